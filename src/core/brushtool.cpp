@@ -94,12 +94,21 @@ void BrushTool::handleMousePress(QPointF scenePos)
 }
 
 void BrushTool::handleMouseMove(QPointF scenePos)
+{
+    handleMouseMovePath(QVector<QPointF>{scenePos});
+}
+
+void BrushTool::handleMouseMovePath(const QVector<QPointF> &scenePoints)
 {
     if (!m_isBrushMode || !m_isDrawing || !m_currentPath || !m_currentPainterPath) return;
+    if (scenePoints.isEmpty()) return;
     
-    m_currentPainterPath->lineTo(scenePos);
+    // 一帧内的所有点都加入路径，笔画不会因事件合并而变稀疏
+    for (const QPointF &point : scenePoints) {
+        m_currentPainterPath->lineTo(point);
+    }
     m_currentPath->setPath(*m_currentPainterPath);
-    m_lastPoint = scenePos;
+    m_lastPoint = scenePoints.last();
 }
 
 void BrushTool::handleMouseRelease(QPointF scenePos)
@@ -12,6 +12,7 @@
 #include <QSlider>
 #include <QPushButton>
 #include <QStack>
+#include <QVector>
 
 class QGraphicsPathItem;
 class QPainterPath;
@@ -27,6 +28,7 @@ public:
     void toggleBrushMode(bool enabled);
     void handleMousePress(QPointF scenePos);
     void handleMouseMove(QPointF scenePos);
+    void handleMouseMovePath(const QVector<QPointF> &scenePoints);
     void handleMouseRelease(QPointF scenePos);
     
     bool isBrushMode() const;
@@ -2,6 +2,7 @@
 #include "utils/panelstyle.h"
 
 #include <QGraphicsPixmapItem>
+#include <QtMath>
 #include <QPixmap>
 #include <QPainter>
 #include <QFrame>
@@ -69,7 +70,8 @@ void ColorPickerTool::handleMouseMove(QPointF scenePos)
     int x = static_cast<int>(scenePos.x());
     int y = static_cast<int>(scenePos.y());
 
-    if (x < 0 || x >= m_image.width() || y < 0 || y >= m_image.height()) {
+    QPoint imagePos = mapToImage(scenePos);
+    if (!m_image.rect().contains(imagePos)) {
         return;
     }
 
@@ -78,7 +80,7 @@ void ColorPickerTool::handleMouseMove(QPointF scenePos)
         return;
     }
 
-    QColor color = m_image.pixelColor(x, y);
+    QColor color = m_image.pixelColor(imagePos);
     m_currentColor = color;
 
     updateColorDisplay(color);
@@ -101,8 +103,9 @@ void ColorPickerTool::handleMousePress(QPointF scenePos)
         int x = static_cast<int>(scenePos.x());
         int y = static_cast<int>(scenePos.y());
 
-        if (x >= 0 && x < m_image.width() && y >= 0 && y < m_image.height()) {
-            QColor color = m_image.pixelColor(x, y);
+        QPoint imagePos = mapToImage(scenePos);
+        if (m_image.rect().contains(imagePos)) {
+            QColor color = m_image.pixelColor(imagePos);
             m_currentColor = color;
             updateColorDisplay(color);
             m_coordLabel->setText(QString("坐标: (%1, %2) [选中模式]").arg(x).arg(y));
@@ -122,6 +125,17 @@ void ColorPickerTool::setImage(const QImage &image)
     m_image = image;
 }
 
+void ColorPickerTool::setImageTransform(const QTransform &sceneToImage)
+{
+    m_sceneToImage = sceneToImage;
+}
+
+QPoint ColorPickerTool::mapToImage(QPointF scenePos) const
+{
+    QPointF imagePos = m_sceneToImage.map(scenePos);
+    return QPoint(qFloor(imagePos.x()), qFloor(imagePos.y()));
+}
+
 QWidget* ColorPickerTool::getColorInfoPanel() const
 {
     return m_colorInfoPanel;
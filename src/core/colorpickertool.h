@@ -6,6 +6,7 @@
 #include <QGraphicsView>
 #include <QPointF>
 #include <QColor>
+#include <QTransform>
 #include <QWidget>
 #include <QLabel>
 #include <QVBoxLayout>
@@ -42,6 +43,9 @@ public:
     // 设置图像用于颜色采样
     void setImage(const QImage &image);
 
+    // 设置场景坐标到图像像素坐标的变换（旋转/翻转仅作用于视图时使用）
+    void setImageTransform(const QTransform &sceneToImage);
+
     // 获取颜色信息面板
     QWidget* getColorInfoPanel() const;
 
@@ -84,6 +88,9 @@ private:
     // 更新所有显示（从当前颜色）
     void updateAllDisplays();
 
+    // 场景坐标映射到图像像素坐标
+    QPoint mapToImage(QPointF scenePos) const;
+
     // 阻塞信号更新辅助函数
     void blockAllSignals(bool block);
 
@@ -116,6 +123,7 @@ private:
     bool m_isSelectionMode;
     QPointF m_selectedPosition;
     QImage m_image;
+    QTransform m_sceneToImage;
 
     // 颜色信息面板
     QWidget *m_colorInfoPanel;
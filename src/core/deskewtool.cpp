@@ -0,0 +1,187 @@
+#include "deskewtool.h"
+#include "utils/panelstyle.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFrame>
+#include <QSignalBlocker>
+#include <QtMath>
+
+namespace {
+
+// 滑块以 0.1 度为步进
+constexpr int kSliderScale = 10;
+constexpr double kMaxAngle = 45.0;
+
+} // namespace
+
+DeskewTool::DeskewTool(QObject *parent)
+    : QObject(parent)
+    , m_isDeskewMode(false)
+    , m_angle(0.0)
+    , m_infoPanel(nullptr)
+    , m_angleSlider(nullptr)
+    , m_angleSpinBox(nullptr)
+    , m_autoDetectButton(nullptr)
+    , m_resetButton(nullptr)
+    , m_applyButton(nullptr)
+    , m_statusLabel(nullptr)
+    , m_isDarkTheme(false)
+{
+    createInfoPanel();
+}
+
+DeskewTool::~DeskewTool()
+{
+    if (m_infoPanel) {
+        delete m_infoPanel;
+    }
+}
+
+void DeskewTool::toggleDeskewMode(bool enabled)
+{
+    if (m_isDeskewMode == enabled) {
+        return;
+    }
+
+    m_isDeskewMode = enabled;
+    if (!enabled) {
+        QSignalBlocker sliderBlocker(m_angleSlider);
+        QSignalBlocker spinBoxBlocker(m_angleSpinBox);
+        m_angle = 0.0;
+        m_angleSlider->setValue(0);
+        m_angleSpinBox->setValue(0.0);
+    }
+
+    emit modeChanged(enabled);
+}
+
+bool DeskewTool::isDeskewMode() const
+{
+    return m_isDeskewMode;
+}
+
+void DeskewTool::setAngle(double degrees)
+{
+    degrees = qBound(-kMaxAngle, degrees, kMaxAngle);
+    {
+        QSignalBlocker sliderBlocker(m_angleSlider);
+        QSignalBlocker spinBoxBlocker(m_angleSpinBox);
+        m_angleSlider->setValue(qRound(degrees * kSliderScale));
+        m_angleSpinBox->setValue(degrees);
+    }
+
+    m_angle = degrees;
+    if (m_isDeskewMode) {
+        emit angleChanged(m_angle);
+    }
+}
+
+double DeskewTool::angle() const
+{
+    return m_angle;
+}
+
+void DeskewTool::setBusy(bool busy, const QString &status)
+{
+    m_autoDetectButton->setEnabled(!busy);
+    m_applyButton->setEnabled(!busy);
+    m_statusLabel->setText(status);
+}
+
+QWidget* DeskewTool::getInfoPanel() const
+{
+    return m_infoPanel;
+}
+
+void DeskewTool::updateTheme(bool isDarkTheme)
+{
+    m_isDarkTheme = isDarkTheme;
+    if (m_infoPanel) {
+        PanelStyle::instance().applyPanelStyle(m_infoPanel, isDarkTheme);
+
+        QList<QFrame*> frames = m_infoPanel->findChildren<QFrame*>();
+        for (QFrame* frame : frames) {
+            if (frame->frameShape() == QFrame::HLine) {
+                frame->setStyleSheet(PanelStyle::instance().getSeparatorStyleSheet(isDarkTheme));
+            }
+        }
+    }
+}
+
+void DeskewTool::createInfoPanel()
+{
+    m_infoPanel = new QWidget();
+    m_infoPanel->setObjectName("toolPanel");
+    QVBoxLayout *layout = new QVBoxLayout(m_infoPanel);
+    layout->setContentsMargins(10, 10, 10, 10);
+    layout->setSpacing(6);
+
+    PanelStyle& style = PanelStyle::instance();
+
+    QLabel *titleLabel = style.createTitleLabel("自由旋转", m_isDarkTheme);
+    layout->addWidget(titleLabel);
+
+    QFrame *line0 = style.createSeparator(m_isDarkTheme);
+    layout->addWidget(line0);
+
+    QLabel *angleTitle = style.createSectionLabel("角度", m_isDarkTheme);
+    layout->addWidget(angleTitle);
+
+    QHBoxLayout *angleLayout = new QHBoxLayout();
+    m_angleSlider = new QSlider(Qt::Horizontal);
+    m_angleSlider->setMinimum(qRound(-kMaxAngle * kSliderScale));
+    m_angleSlider->setMaximum(qRound(kMaxAngle * kSliderScale));
+    m_angleSlider->setValue(0);
+    m_angleSpinBox = new QDoubleSpinBox();
+    m_angleSpinBox->setRange(-kMaxAngle, kMaxAngle);
+    m_angleSpinBox->setDecimals(1);
+    m_angleSpinBox->setSingleStep(0.1);
+    m_angleSpinBox->setValue(0.0);
+    m_angleSpinBox->setSuffix("°");
+    m_angleSpinBox->setFixedWidth(70);
+    angleLayout->addWidget(m_angleSlider, 1);
+    angleLayout->addWidget(m_angleSpinBox);
+    layout->addLayout(angleLayout);
+
+    connect(m_angleSlider, &QSlider::valueChanged, this, [this](int value) {
+        setAngle(static_cast<double>(value) / kSliderScale);
+    });
+    connect(m_angleSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this](double value) {
+        setAngle(value);
+    });
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    m_autoDetectButton = new QPushButton("自动检测");
+    connect(m_autoDetectButton, &QPushButton::clicked, this, [this]() {
+        setBusy(true, "正在检测倾斜角...");
+        emit autoDetectRequested();
+    });
+    m_resetButton = new QPushButton("归零");
+    connect(m_resetButton, &QPushButton::clicked, this, [this]() {
+        setAngle(0.0);
+    });
+    buttonLayout->addWidget(m_autoDetectButton);
+    buttonLayout->addWidget(m_resetButton);
+    layout->addLayout(buttonLayout);
+
+    QFrame *line1 = style.createSeparator(m_isDarkTheme);
+    layout->addWidget(line1);
+
+    m_applyButton = new QPushButton("应用旋转");
+    connect(m_applyButton, &QPushButton::clicked, this, [this]() {
+        if (qFuzzyIsNull(m_angle)) {
+            return;
+        }
+        setBusy(true, "正在旋转全分辨率图像...");
+        emit applyRequested(m_angle);
+    });
+    layout->addWidget(m_applyButton);
+
+    m_statusLabel = style.createContentLabel("拖动滑块只预览可见区域，应用后在后台旋转整张图片", m_isDarkTheme);
+    m_statusLabel->setWordWrap(true);
+    layout->addWidget(m_statusLabel);
+
+    layout->addStretch();
+
+    style.applyPanelStyle(m_infoPanel, m_isDarkTheme);
+}
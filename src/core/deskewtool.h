@@ -0,0 +1,63 @@
+#ifndef DESKEWTOOL_H
+#define DESKEWTOOL_H
+
+#include <QObject>
+#include <QWidget>
+#include <QLabel>
+#include <QSlider>
+#include <QDoubleSpinBox>
+#include <QPushButton>
+
+/**
+ * @brief 自由旋转/纠偏工具
+ *
+ * 提供角度滑块和自动倾斜检测。拖动滑块时只发出预览角度，
+ * 点击应用后才由 ImageViewer 在后台完成全分辨率旋转。
+ */
+class DeskewTool : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DeskewTool(QObject *parent = nullptr);
+    ~DeskewTool();
+
+    void toggleDeskewMode(bool enabled);
+    bool isDeskewMode() const;
+
+    // 设置角度（度，顺时针为正），会发出 angleChanged
+    void setAngle(double degrees);
+    double angle() const;
+
+    // 后台任务进行中时禁用操作按钮
+    void setBusy(bool busy, const QString &status = QString());
+
+    QWidget* getInfoPanel() const;
+
+    void updateTheme(bool isDarkTheme);
+
+signals:
+    void modeChanged(bool enabled);
+    void angleChanged(double degrees);
+    void applyRequested(double degrees);
+    void autoDetectRequested();
+
+private:
+    void createInfoPanel();
+
+private:
+    bool m_isDeskewMode;
+    double m_angle;
+
+    QWidget *m_infoPanel;
+    QSlider *m_angleSlider;
+    QDoubleSpinBox *m_angleSpinBox;
+    QPushButton *m_autoDetectButton;
+    QPushButton *m_resetButton;
+    QPushButton *m_applyButton;
+    QLabel *m_statusLabel;
+
+    bool m_isDarkTheme;
+};
+
+#endif
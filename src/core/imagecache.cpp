@@ -0,0 +1,175 @@
+#include "imagecache.h"
+#include "utils/perfstats.h"
+#include "utils/jpegexif.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+ImageCache& ImageCache::instance()
+{
+    static ImageCache instance;
+    return instance;
+}
+
+ImageCache::Status ImageCache::load(const QString &fileName, Entry &entry)
+{
+    if (lookup(fileName, entry)) {
+        return Loaded;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return OpenFailed;
+    }
+
+    Entry loaded;
+    loaded.fileSize = file.size();
+    loaded.lastModified = QFileInfo(fileName).lastModified();
+
+    QByteArray fileData;
+    {
+        ScopedPerfTimer timer(PerfStats::FileRead);
+        fileData = file.readAll();
+    }
+    file.close();
+
+    cv::Mat matData(1, fileData.size(), CV_8U, (void*)fileData.data());
+    {
+        ScopedPerfTimer timer(PerfStats::Decode);
+        loaded.image = cv::imdecode(matData, cv::IMREAD_UNCHANGED);
+    }
+    if (loaded.image.empty()) {
+        return DecodeFailed;
+    }
+    // IMREAD_UNCHANGED 不处理 EXIF 方向，JPEG 在这里按标签转正，
+    // 之后的方向调整都相对转正后的像素
+    int exifOrientation = jpegExifOrientation(fileData);
+    if (exifOrientation != 1) {
+        ScopedPerfTimer timer(PerfStats::Decode);
+        loaded.image = orientationFromExifValue(exifOrientation).apply(loaded.image);
+    }
+
+    loaded.thumbnail = createThumbnail(loaded.image);
+
+    insert(fileName, loaded);
+    entry = loaded;
+    return Loaded;
+}
+
+bool ImageCache::lookup(const QString &fileName, Entry &entry)
+{
+    QDateTime lastModified = QFileInfo(fileName).lastModified();
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(fileName);
+    // 文件被修改过则视为未命中
+    bool hit = it != m_entries.end() && it->lastModified == lastModified;
+    PerfStats::instance().recordCacheLookup(hit);
+    if (!hit) {
+        return false;
+    }
+
+    m_lru.removeOne(fileName);
+    m_lru.append(fileName);
+    entry = it.value();
+    return true;
+}
+
+void ImageCache::insert(const QString &fileName, const Entry &entry)
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_entries.find(fileName);
+    if (it != m_entries.end()) {
+        m_totalBytes -= entryCost(it.value());
+        m_lru.removeOne(fileName);
+    }
+
+    m_entries.insert(fileName, entry);
+    m_lru.append(fileName);
+    m_totalBytes += entryCost(entry);
+
+    evictIfNeeded();
+}
+
+void ImageCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_lru.clear();
+    m_totalBytes = 0;
+}
+
+void ImageCache::setCapacity(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_capacity = bytes;
+    evictIfNeeded();
+}
+
+qint64 ImageCache::capacity() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_capacity;
+}
+
+QImage ImageCache::createThumbnail(const cv::Mat &image)
+{
+    if (image.empty()) {
+        return QImage();
+    }
+
+    double scale = static_cast<double>(kThumbnailSize) / std::max(image.cols, image.rows);
+    scale = std::min(scale, 1.0);
+    cv::Size thumbSize(std::max(1, cvRound(image.cols * scale)),
+                       std::max(1, cvRound(image.rows * scale)));
+
+    // 超大图先按步长抽样到缩略图的 4 倍，再做区域平均，避免整图 INTER_AREA
+    cv::Mat source = image;
+    cv::Size sampledSize(thumbSize.width * 4, thumbSize.height * 4);
+    if (image.cols > sampledSize.width * 2 && image.rows > sampledSize.height * 2) {
+        cv::resize(image, source, sampledSize, 0, 0, cv::INTER_NEAREST);
+    }
+
+    cv::Mat thumb;
+    cv::resize(source, thumb, thumbSize, 0, 0, cv::INTER_AREA);
+
+    if (thumb.depth() == CV_16U) {
+        thumb.convertTo(thumb, CV_8U, 1.0 / 257.0);
+    } else if (thumb.depth() == CV_32F || thumb.depth() == CV_64F) {
+        thumb.convertTo(thumb, CV_8U, 255.0);
+    } else if (thumb.depth() != CV_8U) {
+        cv::normalize(thumb, thumb, 0, 255, cv::NORM_MINMAX, CV_8U);
+    }
+
+    cv::Mat rgb;
+    if (thumb.channels() == 1) {
+        cv::cvtColor(thumb, rgb, cv::COLOR_GRAY2RGB);
+    } else if (thumb.channels() == 4) {
+        cv::cvtColor(thumb, rgb, cv::COLOR_BGRA2RGB);
+    } else {
+        cv::cvtColor(thumb, rgb, cv::COLOR_BGR2RGB);
+    }
+
+    QImage qImage(rgb.data, rgb.cols, rgb.rows, static_cast<int>(rgb.step), QImage::Format_RGB888);
+    return qImage.copy();
+}
+
+qint64 ImageCache::entryCost(const Entry &entry)
+{
+    return static_cast<qint64>(entry.image.total() * entry.image.elemSize()) + entry.thumbnail.sizeInBytes();
+}
+
+void ImageCache::evictIfNeeded()
+{
+    // 至少保留最近一张，即便它本身超出容量
+    while (m_totalBytes > m_capacity && m_lru.size() > 1) {
+        QString oldest = m_lru.takeFirst();
+        auto it = m_entries.find(oldest);
+        if (it != m_entries.end()) {
+            m_totalBytes -= entryCost(it.value());
+            m_entries.erase(it);
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QImage>
+#include <QDateTime>
+#include <QMutex>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief 解码缓存
+ *
+ * 按文件路径缓存解码后的图像及其缩略图，按字节数做 LRU 淘汰。
+ * 缩略图在解码时顺带生成，之后的导航器等功能直接复用，不再对整图重采样。
+ */
+class ImageCache
+{
+public:
+    enum Status {
+        Loaded = 0,
+        OpenFailed,
+        DecodeFailed
+    };
+
+    struct Entry {
+        cv::Mat image;
+        QImage thumbnail;
+        qint64 fileSize = 0;
+        QDateTime lastModified;
+    };
+
+    static ImageCache& instance();
+
+    // 命中则直接返回缓存，否则读取、解码并放入缓存
+    Status load(const QString &fileName, Entry &entry);
+    bool lookup(const QString &fileName, Entry &entry);
+    void insert(const QString &fileName, const Entry &entry);
+    void clear();
+
+    void setCapacity(qint64 bytes);
+    qint64 capacity() const;
+
+    static QImage createThumbnail(const cv::Mat &image);
+
+    static constexpr int kThumbnailSize = 256;
+
+private:
+    ImageCache() = default;
+    ImageCache(const ImageCache&) = delete;
+    ImageCache& operator=(const ImageCache&) = delete;
+
+    static qint64 entryCost(const Entry &entry);
+    void evictIfNeeded();
+
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    QStringList m_lru;
+    qint64 m_totalBytes = 0;
+    qint64 m_capacity = 1024LL * 1024 * 1024;
+};
+
+#endif
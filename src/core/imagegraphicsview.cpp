@@ -5,7 +5,14 @@
 #include <QKeyEvent>
 #include <QEnterEvent>
 #include <QPainter>
+#include <QFontMetrics>
+#include <QStringList>
 #include <QScrollBar>
+#include <QScreen>
+#include <QTimer>
+#include <cmath>
+
+#include "utils/perfstats.h"
 
 ImageGraphicsView::ImageGraphicsView(QWidget *parent)
     : QGraphicsView(parent)
@@ -13,9 +20,13 @@ ImageGraphicsView::ImageGraphicsView(QWidget *parent)
     , m_rightButtonDragging(false)
     , m_isCrosshairMode(false)
     , m_hasFixedCrosshair(false)
+    , m_hasSharedCrosshair(false)
     , m_brushPreviewVisible(false)
     , m_brushPreviewColor(Qt::red)
     , m_brushPreviewSize(5)
+    , m_inputFrameTimer(new QTimer(this))
+    , m_pendingWheelDelta(0)
+    , m_perfHudVisible(false)
 {
     setRenderHint(QPainter::Antialiasing);
     setRenderHint(QPainter::SmoothPixmapTransform);
@@ -26,10 +37,18 @@ ImageGraphicsView::ImageGraphicsView(QWidget *parent)
     setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
     setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
     setMouseTracking(true);
+
+    m_inputFrameTimer->setSingleShot(true);
+    m_inputFrameTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_inputFrameTimer, &QTimer::timeout, this, &ImageGraphicsView::dispatchPendingInput);
+    m_lastDispatchTimer.start();
 }
 
 void ImageGraphicsView::mousePressEvent(QMouseEvent *event)
 {
+    // 先分发尚未处理的移动，保证工具看到的事件顺序与实际一致
+    dispatchPendingInput();
+
     // 在 CrossCursor 模式下（测距/测角模式），右键用于拖动
     if (event->button() == Qt::RightButton && cursor().shape() == Qt::CrossCursor) {
         m_rightButtonDragging = true;
@@ -50,6 +69,9 @@ void ImageGraphicsView::mousePressEvent(QMouseEvent *event)
 void ImageGraphicsView::mouseMoveEvent(QMouseEvent *event)
 {
     m_lastMousePos = event->pos();
+    if (!m_inputLatencyTimer.isValid()) {
+        m_inputLatencyTimer.start();
+    }
     
     if (m_rightButtonDragging) {
         QPoint delta = event->pos() - m_dragStartPos;
@@ -69,11 +91,13 @@ void ImageGraphicsView::mouseMoveEvent(QMouseEvent *event)
     
     QPointF viewPos = event->pos();
     QPointF scenePos = mapToScene(viewPos.toPoint());
-    emit mouseMoved(scenePos);
+    m_pendingMovePoints.append(scenePos);
+    scheduleInputDispatch();
 }
 
 void ImageGraphicsView::leaveEvent(QEvent *event)
 {
+    dispatchPendingInput();
     QGraphicsView::leaveEvent(event);
     m_mouseInView = false;
     viewport()->update();
@@ -82,6 +106,8 @@ void ImageGraphicsView::leaveEvent(QEvent *event)
 
 void ImageGraphicsView::mouseReleaseEvent(QMouseEvent *event)
 {
+    dispatchPendingInput();
+
     // 处理右键拖动结束
     if (event->button() == Qt::RightButton && m_rightButtonDragging) {
         m_rightButtonDragging = false;
@@ -121,29 +147,71 @@ void ImageGraphicsView::wheelEvent(QWheelEvent *event)
         return;
     }
     
-    qreal scaleFactor = 1.15;
-    if (event->angleDelta().y() < 0) {
-        scaleFactor = 1.0 / scaleFactor;
+    // 滚轮增量在一帧内累加，帧末一次性缩放
+    if (!m_inputLatencyTimer.isValid()) {
+        m_inputLatencyTimer.start();
     }
-    
-    qreal currentScale = transform().m11() * 100;
-    qreal newScale = currentScale * scaleFactor;
-    
-    if ((scaleFactor > 1 && currentScale < 3200) || (scaleFactor < 1 && currentScale > 1)) {
-        qreal actualScaleFactor = scaleFactor;
-        if (scaleFactor > 1 && currentScale < 3200) {
-            actualScaleFactor = 3200 / currentScale;
-            actualScaleFactor = qMin(actualScaleFactor, 1.15);
-        } else if (scaleFactor < 1 && currentScale > 1) {
-            actualScaleFactor = 1.0 / 1.15;
-            if (currentScale * actualScaleFactor < 1) {
-                actualScaleFactor = 1.0 / currentScale;
-            }
-        }
-        
-        scale(actualScaleFactor, actualScaleFactor);
-        emit scaleChanged();
-        event->accept();
+    m_pendingWheelDelta += event->angleDelta().y();
+    event->accept();
+    scheduleInputDispatch();
+}
+
+void ImageGraphicsView::applyWheelZoom(int angleDelta)
+{
+    qreal currentScale = zoomPercent();
+    if ((angleDelta > 0 && currentScale >= 3200) || (angleDelta < 0 && currentScale <= 1)) {
+        return;
+    }
+
+    // 每 120 (一格) 缩放 1.15 倍，高精度滚轮按比例缩放
+    qreal scaleFactor = std::pow(1.15, angleDelta / 120.0);
+    qreal newScale = qBound(qreal(1), currentScale * scaleFactor, qreal(3200));
+    qreal actualScaleFactor = newScale / currentScale;
+
+    scale(actualScaleFactor, actualScaleFactor);
+    emit scaleChanged();
+}
+
+int ImageGraphicsView::frameIntervalMs() const
+{
+    qreal refreshRate = screen() ? screen()->refreshRate() : 60.0;
+    if (refreshRate <= 0) {
+        refreshRate = 60.0;
+    }
+    return qMax(1, qRound(1000.0 / refreshRate));
+}
+
+void ImageGraphicsView::scheduleInputDispatch()
+{
+    if (m_inputFrameTimer->isActive()) {
+        return;
+    }
+
+    // 距上次分发已超过一帧则立即处理，否则等到本帧结束
+    int remaining = frameIntervalMs() - static_cast<int>(m_lastDispatchTimer.elapsed());
+    if (remaining <= 0) {
+        dispatchPendingInput();
+    } else {
+        m_inputFrameTimer->start(remaining);
+    }
+}
+
+void ImageGraphicsView::dispatchPendingInput()
+{
+    m_inputFrameTimer->stop();
+    m_lastDispatchTimer.restart();
+
+    if (m_pendingWheelDelta != 0) {
+        int delta = m_pendingWheelDelta;
+        m_pendingWheelDelta = 0;
+        applyWheelZoom(delta);
+    }
+
+    if (!m_pendingMovePoints.isEmpty()) {
+        QVector<QPointF> points;
+        points.swap(m_pendingMovePoints);
+        emit mouseMovedPath(points);
+        emit mouseMoved(points.last());
     }
 }
 
@@ -167,6 +235,9 @@ void ImageGraphicsView::keyReleaseEvent(QKeyEvent *event)
 
 void ImageGraphicsView::paintEvent(QPaintEvent *event)
 {
+    QElapsedTimer paintTimer;
+    paintTimer.start();
+
     QGraphicsView::paintEvent(event);
     
     QPainter painter(viewport());
@@ -183,6 +254,17 @@ void ImageGraphicsView::paintEvent(QPaintEvent *event)
         painter.drawLine(fixedPos.x(), 0, fixedPos.x(), viewport()->height());
     }
 
+    if (m_hasSharedCrosshair && !m_mouseInView) {
+        QPoint sharedPos = mapFromScene(m_sharedCrosshairPosition);
+        QPen sharedPen(QColor(0, 200, 255, 200));
+        sharedPen.setWidth(1);
+        sharedPen.setStyle(Qt::DashLine);
+        painter.setPen(sharedPen);
+
+        painter.drawLine(0, sharedPos.y(), viewport()->width(), sharedPos.y());
+        painter.drawLine(sharedPos.x(), 0, sharedPos.x(), viewport()->height());
+    }
+
     if ((cursor().shape() == Qt::CrossCursor || m_isCrosshairMode) && !m_hasFixedCrosshair && m_mouseInView) {
         QColor crosshairColor = m_brushPreviewVisible ? m_brushPreviewColor : QColor(0, 255, 0, 200);
         QPen pen(crosshairColor);
@@ -210,6 +292,100 @@ void ImageGraphicsView::paintEvent(QPaintEvent *event)
         painter.drawEllipse(m_lastMousePos.x() - halfSize, m_lastMousePos.y() - halfSize, 
                            displaySize, displaySize);
     }
+
+    PerfStats::instance().record(PerfStats::Paint, paintTimer.nsecsElapsed() / 1e6);
+    if (m_inputLatencyTimer.isValid()) {
+        PerfStats::instance().record(PerfStats::InputLatency, m_inputLatencyTimer.nsecsElapsed() / 1e6);
+        m_inputLatencyTimer.invalidate();
+    }
+
+    if (m_perfHudVisible) {
+        drawPerfHud(painter);
+    }
+}
+
+void ImageGraphicsView::drawPerfHud(QPainter &painter)
+{
+    PerfStats &stats = PerfStats::instance();
+
+    QStringList lines;
+    lines << QString("%1 %2 %3 %4")
+             .arg(QString(), -8)
+             .arg(QString("最近"), 8)
+             .arg(QString("P50"), 8)
+             .arg(QString("P95"), 8);
+    for (int i = 0; i < PerfStats::MetricCount; ++i) {
+        PerfStats::Metric metric = static_cast<PerfStats::Metric>(i);
+        PerfStats::Summary summary = stats.summary(metric);
+        if (summary.count == 0) {
+            lines << QString("%1 %2").arg(PerfStats::metricName(metric), -8).arg(QString("-"), 8);
+            continue;
+        }
+        lines << QString("%1 %2 %3 %4 ms")
+                 .arg(PerfStats::metricName(metric), -8)
+                 .arg(summary.last, 8, 'f', 2)
+                 .arg(summary.p50, 8, 'f', 2)
+                 .arg(summary.p95, 8, 'f', 2);
+    }
+
+    int lookups = stats.cacheLookups();
+    if (lookups > 0) {
+        int hits = stats.cacheHits();
+        lines << QString("缓存命中率: %1% (%2/%3)")
+                 .arg(100.0 * hits / lookups, 0, 'f', 1)
+                 .arg(hits)
+                 .arg(lookups);
+    } else {
+        lines << QString("缓存命中率: -");
+    }
+
+    QFont font("Consolas");
+    font.setStyleHint(QFont::Monospace);
+    font.setPointSize(9);
+    painter.setFont(font);
+    QFontMetrics metrics(font);
+
+    int lineHeight = metrics.height();
+    int width = 0;
+    for (const QString &line : lines) {
+        width = qMax(width, metrics.horizontalAdvance(line));
+    }
+
+    QRect hudRect(8, 8, width + 16, lineHeight * lines.size() + 12);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(0, 0, 0, 170));
+    painter.drawRoundedRect(hudRect, 4, 4);
+
+    painter.setPen(QColor(0, 255, 0));
+    int y = hudRect.top() + 6 + metrics.ascent();
+    for (const QString &line : lines) {
+        painter.drawText(hudRect.left() + 8, y, line);
+        y += lineHeight;
+    }
+}
+
+qreal ImageGraphicsView::zoomPercent() const
+{
+    return transform().m11() * devicePixelRatioF() * 100;
+}
+
+void ImageGraphicsView::setZoomPercent(qreal percent)
+{
+    // 视图变换以逻辑像素为单位，需除以设备像素比才能让 100% 对应物理像素
+    qreal scaleFactor = percent / 100.0 / devicePixelRatioF();
+    resetTransform();
+    scale(scaleFactor, scaleFactor);
+}
+
+void ImageGraphicsView::setPerfHudVisible(bool visible)
+{
+    m_perfHudVisible = visible;
+    viewport()->update();
+}
+
+bool ImageGraphicsView::isPerfHudVisible() const
+{
+    return m_perfHudVisible;
 }
 
 void ImageGraphicsView::setFixedCrosshairPosition(const QPointF &scenePos)
@@ -225,6 +401,22 @@ void ImageGraphicsView::clearFixedCrosshair()
     viewport()->update();
 }
 
+void ImageGraphicsView::setSharedCrosshair(const QPointF &scenePos)
+{
+    m_sharedCrosshairPosition = scenePos;
+    m_hasSharedCrosshair = true;
+    viewport()->update();
+}
+
+void ImageGraphicsView::clearSharedCrosshair()
+{
+    if (!m_hasSharedCrosshair) {
+        return;
+    }
+    m_hasSharedCrosshair = false;
+    viewport()->update();
+}
+
 void ImageGraphicsView::setBrushPreview(const QColor &color, int size, bool visible)
 {
     m_brushPreviewColor = color;
@@ -6,6 +6,11 @@
 #include <QWheelEvent>
 #include <QKeyEvent>
 #include <QColor>
+#include <QVector>
+#include <QElapsedTimer>
+
+class QTimer;
+class QPainter;
 
 class ImageGraphicsView : public QGraphicsView
 {
@@ -17,11 +22,24 @@ public:
     void setFixedCrosshairPosition(const QPointF &scenePos);
     void clearFixedCrosshair();
     
+    // 多窗格对比时由其他窗格同步过来的十字线
+    void setSharedCrosshair(const QPointF &scenePos);
+    void clearSharedCrosshair();
+    
     void setBrushPreview(const QColor &color, int size, bool visible);
     void clearBrushPreview();
 
+    // 以设备像素计的缩放百分比：100% 表示一个图像像素对应一个物理像素
+    qreal zoomPercent() const;
+    void setZoomPercent(qreal percent);
+
+    void setPerfHudVisible(bool visible);
+    bool isPerfHudVisible() const;
+
 signals:
     void mouseMoved(QPointF scenePos);
+    // 一帧内累积的全部移动点（按时间顺序），供需要完整轨迹的工具使用
+    void mouseMovedPath(const QVector<QPointF> &scenePoints);
     void mousePressed(QPointF scenePos);
     void mouseReleased(QPointF scenePos);
     void mouseLeft();
@@ -43,6 +61,13 @@ protected:
     void paintEvent(QPaintEvent *event) override;
 
 private:
+    // 鼠标移动与滚轮事件按显示帧合并，每帧最多分发一次
+    void scheduleInputDispatch();
+    void dispatchPendingInput();
+    void applyWheelZoom(int angleDelta);
+    int frameIntervalMs() const;
+    void drawPerfHud(QPainter &painter);
+
     QPoint m_lastMousePos;
     bool m_mouseInView;
     bool m_rightButtonDragging;
@@ -50,10 +75,21 @@ private:
     bool m_isCrosshairMode;
     QPointF m_fixedCrosshairPosition;
     bool m_hasFixedCrosshair;
+    QPointF m_sharedCrosshairPosition;
+    bool m_hasSharedCrosshair;
     
     bool m_brushPreviewVisible;
     QColor m_brushPreviewColor;
     int m_brushPreviewSize;
+
+    QTimer *m_inputFrameTimer;
+    QElapsedTimer m_lastDispatchTimer;
+    QVector<QPointF> m_pendingMovePoints;
+    int m_pendingWheelDelta;
+
+    bool m_perfHudVisible;
+    // 从首个尚未绘制的输入事件开始计时，绘制完成时记录输入到绘制的延迟
+    QElapsedTimer m_inputLatencyTimer;
 };
 
 #endif
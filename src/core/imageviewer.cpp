@@ -2,18 +2,44 @@
 #include <QMessageBox>
 #include <QFile>
 #include <QFileInfo>
+#include <QSaveFile>
+#include <QBuffer>
+#include <QElapsedTimer>
 #include <QDir>
 #include <QSettings>
 #include <QtConcurrent>
 #include <QPainter>
+#include <QTransform>
+#include <QSignalBlocker>
+#include <QScrollBar>
+#include <QtMath>
+#include <QPointer>
+#include <QGraphicsRectItem>
+#include <QPen>
+#include <QCryptographicHash>
+#include <QStyleOptionGraphicsItem>
+#include <algorithm>
+#include <cmath>
 #include <opencv2/opencv.hpp>
 #include "core/imagegraphicsview.h"
+#include "core/imagecache.h"
+#include "core/tiledimageitem.h"
+#include "core/swipedivideritem.h"
+#include "utils/perfstats.h"
+#include "utils/matconvert.h"
+#include "utils/deskew.h"
+#include "utils/blendkernel.h"
+#include "utils/comparemodes.h"
+#include "utils/bandwriter.h"
+#include "utils/jpegexif.h"
+#include "utils/annotationlayer.h"
 
 ImageViewer::ImageViewer(ImageGraphicsView *view, QGraphicsScene *scene, QObject *parent)
     : QObject(parent)
     , m_view(view)
     , m_scene(scene)
     , m_pixmapItem(nullptr)
+    , m_pixelsMatchFile(false)
     , m_coordinateLabel(nullptr)
     , m_scaleLabel(nullptr)
     , m_sizeLabel(nullptr)
@@ -28,10 +54,105 @@ ImageViewer::ImageViewer(ImageGraphicsView *view, QGraphicsScene *scene, QObject
     , m_isOverlayMode(false)
     , m_alpha1(0.5)
     , m_alpha2(0.5)
-    , m_overlayUpdateTimer(new QTimer(this))
+    , m_alignedGeneration(0)
+    , m_alignedLevelWatcher(new QFutureWatcher<AlignedLevel>(this))
+    , m_pendingAlignedLevel(0)
+    , m_pendingAlignedGeneration(0)
+    , m_overlayItem(nullptr)
+    , m_compareMode(CompareBlend)
+    , m_differenceGain(4.0)
+    , m_differenceHeatmap(true)
+    , m_swipePosition(0.5)
+    , m_checkerSize(64)
+    , m_swipeDivider(nullptr)
+    , m_flickerTimer(new QTimer(this))
+    , m_flickerShowSecond(false)
+    , m_exposureMode(ExposureMatchMode::None)
+    , m_exposureLutGeneration(0)
+    , m_registration(cv::Matx33d::eye())
+    , m_hasRegistration(false)
+    , m_registrationWatcher(new QFutureWatcher<RegistrationResult>(this))
+    , m_alignmentSettleTimer(new QTimer(this))
+    , m_layerPrepareWatcher(new QFutureWatcher<std::shared_ptr<const LayerStack::Prepared>>(this))
+    , m_metricsWatcher(new QFutureWatcher<MetricsGrid>(this))
+    , m_visibleMetricsTimer(new QTimer(this))
+    , m_hasRegions(false)
+    , m_regionThreshold(16)
+    , m_regionMinArea(16)
+    , m_currentRegion(-1)
+    , m_pendingRegionStep(0)
+    , m_regionsWatcher(new QFutureWatcher<std::vector<ChangedRegion>>(this))
+    , m_regionHighlight(nullptr)
+    , m_exportWatcher(new QFutureWatcher<ExportStatus>(this))
+    , m_estimateWatcher(new QFutureWatcher<ExportEstimate>(this))
+    , m_estimateQueued(false)
+    , m_resizeSettleTimer(new QTimer(this))
+    , m_resizeProxyItem(nullptr)
+    , m_isInteractiveResize(false)
+    , m_isRotationPreview(false)
+    , m_previewAngle(0.0)
+    , m_rotationPreviewTimer(new QTimer(this))
+    , m_rotationPreviewItem(nullptr)
+    , m_rotationPreviewLevel(0)
+    , m_rotationLevelWatcher(new QFutureWatcher<cv::Mat>(this))
+    , m_pendingRotationLevel(0)
+    , m_rotationWatcher(new QFutureWatcher<cv::Mat>(this))
 {
-    m_overlayUpdateTimer->setSingleShot(true);
-    connect(m_overlayUpdateTimer, &QTimer::timeout, this, &ImageViewer::updateOverlay);
+    m_resizeSettleTimer->setSingleShot(true);
+    connect(m_resizeSettleTimer, &QTimer::timeout, this, &ImageViewer::finishInteractiveResize);
+    
+    m_flickerTimer->setInterval(500);
+    connect(m_flickerTimer, &QTimer::timeout, this, [this]() {
+        m_flickerShowSecond = !m_flickerShowSecond;
+        refreshOverlayTiles();
+    });
+    
+    // 同一轮事件循环内的多次角度/平移变化只重绘一次预览
+    m_rotationPreviewTimer->setSingleShot(true);
+    m_rotationPreviewTimer->setInterval(0);
+    connect(m_rotationPreviewTimer, &QTimer::timeout, this, &ImageViewer::updateRotationPreview);
+    connect(m_view->horizontalScrollBar(), &QScrollBar::valueChanged, this, [this]() {
+        if (m_isRotationPreview) {
+            m_rotationPreviewTimer->start();
+        }
+        if (!m_metricsGrid.isEmpty()) {
+            m_visibleMetricsTimer->start();
+        }
+    });
+    connect(m_view->verticalScrollBar(), &QScrollBar::valueChanged, this, [this]() {
+        if (m_isRotationPreview) {
+            m_rotationPreviewTimer->start();
+        }
+        if (!m_metricsGrid.isEmpty()) {
+            m_visibleMetricsTimer->start();
+        }
+    });
+
+    // 可见区域指标只是对缓存瓦片求和，同一轮事件循环内的多次视图变化合并通知
+    m_visibleMetricsTimer->setSingleShot(true);
+    m_visibleMetricsTimer->setInterval(0);
+    connect(m_visibleMetricsTimer, &QTimer::timeout, this, &ImageViewer::qualityMetricsChanged);
+    connect(m_metricsWatcher, &QFutureWatcher<MetricsGrid>::finished, this, &ImageViewer::onMetricsFinished);
+    connect(m_regionsWatcher, &QFutureWatcher<std::vector<ChangedRegion>>::finished,
+            this, &ImageViewer::onRegionsFinished);
+    connect(m_exportWatcher, &QFutureWatcher<ExportStatus>::finished, this, &ImageViewer::onExportFinished);
+    connect(m_alignedLevelWatcher, &QFutureWatcher<AlignedLevel>::finished,
+            this, &ImageViewer::onAlignedLevelFinished);
+    connect(m_layerPrepareWatcher, &QFutureWatcher<std::shared_ptr<const LayerStack::Prepared>>::finished,
+            this, &ImageViewer::onLayerPrepared);
+    connect(m_estimateWatcher, &QFutureWatcher<ExportEstimate>::finished, this, &ImageViewer::onEstimateFinished);
+
+    m_alignmentSettleTimer->setSingleShot(true);
+    m_alignmentSettleTimer->setInterval(300);
+    connect(m_alignmentSettleTimer, &QTimer::timeout, this, [this]() {
+        saveManualAlignment();
+        updateQualityMetrics();
+    });
+    connect(m_rotationWatcher, &QFutureWatcher<cv::Mat>::finished, this, &ImageViewer::onRotationFinished);
+    connect(m_rotationLevelWatcher, &QFutureWatcher<cv::Mat>::finished,
+            this, &ImageViewer::onRotationPreviewLevelFinished);
+    connect(m_registrationWatcher, &QFutureWatcher<RegistrationResult>::finished,
+            this, &ImageViewer::onRegistrationFinished);
 }
 
 void ImageViewer::setCoordinateLabel(QLabel *label)
@@ -84,6 +205,7 @@ void ImageViewer::openImage(const QString &fileName)
         m_currentDirectory = directoryPath;
         loadImagesFromDirectory(directoryPath);
         loadSavedPosition();
+        loadManualAlignment();
     }
     
     m_currentImageIndex = m_imageList.indexOf(fileName);
@@ -91,29 +213,35 @@ void ImageViewer::openImage(const QString &fileName)
         m_currentImageIndex = 0;
     }
     
-    QFile file(fileName);
-    if (!file.open(QIODevice::ReadOnly)) {
+    ImageCache::Entry entry;
+    ImageCache::Status status = ImageCache::instance().load(fileName, entry);
+    if (status == ImageCache::OpenFailed) {
         QMessageBox::warning(nullptr, tr("错误"), tr("无法打开图片文件: %1").arg(fileName));
         emit imageLoadingFinished();
         return;
     }
-    
-    m_fileSize = file.size();
-    QByteArray fileData = file.readAll();
-    file.close();
-    
-    cv::Mat matData(1, fileData.size(), CV_8U, (void*)fileData.data());
-    
-    cv::Mat cvImage = cv::imdecode(matData, cv::IMREAD_UNCHANGED);
-    if (cvImage.empty()) {
+    if (status == ImageCache::DecodeFailed) {
         QMessageBox::warning(nullptr, tr("错误"), tr("无法解码图片文件: %1").arg(fileName));
         emit imageLoadingFinished();
         return;
     }
     
-    m_cvImage = cvImage;
+    m_currentFileName = fileName;
+    m_fileSize = entry.fileSize;
+    m_thumbnail = entry.thumbnail;
+    clearRotationPreview();
+    m_rotationPreviewSource.release();
+    invalidateAlignedInputs();
+    m_cvImage = entry.image;
+    m_pixelsMatchFile = true;
+    m_orientation.reset();
+    if (!m_pairedDirectory.isEmpty()) {
+        loadPairedImage(fileName);
+    }
     updatePixmapFromMat();
     
+    finishInteractiveResize();
+    
     if (m_pixmapItem) {
         m_scene->removeItem(m_pixmapItem);
         delete m_pixmapItem;
@@ -123,6 +251,12 @@ void ImageViewer::openImage(const QString &fileName)
     m_pixmapItem = m_scene->addPixmap(m_originalPixmap);
     m_scene->setSceneRect(m_originalPixmap.rect());
     
+    if (m_isOverlayMode && hasOverlayContent()) {
+        updateOverlay();
+    } else {
+        hideOverlayItem();
+    }
+    
     m_view->setEnabled(true);
     if (m_zoomSlider) {
         m_zoomSlider->setEnabled(true);
@@ -132,15 +266,21 @@ void ImageViewer::openImage(const QString &fileName)
     }
     
     m_isFitToWindow = true;
-    m_view->fitInView(m_pixmapItem, Qt::KeepAspectRatio);
+    m_view->fitInView(displayItem(), Qt::KeepAspectRatio);
+    emit fitToWindowChanged(true);
     
     updateSizeInfo();
     updateScaleInfo();
     updateImageIndexLabel();
     
     emit imageLoaded(fileName);
+    emit thumbnailChanged();
     emit imageIndexChanged(m_currentImageIndex + 1, m_imageList.size());
     emit imageLoadingFinished();
+
+    if (!m_pairedDirectory.isEmpty()) {
+        prefetchNeighbourPairs();
+    }
 }
 
 void ImageViewer::zoomIn()
@@ -149,7 +289,7 @@ void ImageViewer::zoomIn()
         return;
     }
     
-    qreal currentScale = m_view->transform().m11() * 100;
+    qreal currentScale = m_view->zoomPercent();
 
     if (currentScale < 3200) {
         qreal maxScaleFactor = 1.2;
@@ -173,7 +313,7 @@ void ImageViewer::zoomOut()
         return;
     }
     
-    qreal currentScale = m_view->transform().m11() * 100;
+    qreal currentScale = m_view->zoomPercent();
     
     if (currentScale > 1) {
         m_view->scale(1.0 / 1.2, 1.0 / 1.2);
@@ -194,7 +334,7 @@ void ImageViewer::fitToWindow()
     }
     
     if (m_isFitToWindow) {
-        m_view->fitInView(m_pixmapItem, Qt::KeepAspectRatio);
+        m_view->fitInView(displayItem(), Qt::KeepAspectRatio);
     } else {
         originalSize();
     }
@@ -208,7 +348,7 @@ void ImageViewer::originalSize()
         return;
     }
     
-    m_view->resetTransform();
+    m_view->setZoomPercent(100);
     updateScaleInfo();
     
     m_isFitToWindow = false;
@@ -221,20 +361,8 @@ void ImageViewer::rotateLeft()
         return;
     }
 
-    cv::Mat rotated;
-    cv::transpose(m_cvImage, rotated);
-    cv::flip(rotated, rotated, 0);
-    m_cvImage = rotated;
-
-    if (m_isOverlayMode && !m_cvImage2.empty()) {
-        updateOverlay();
-    } else {
-        updatePixmapFromMat();
-        m_pixmapItem->setPixmap(m_originalPixmap);
-        m_scene->setSceneRect(m_originalPixmap.rect());
-    }
-
-    emit scaleChanged();
+    m_orientation.rotateLeft();
+    applyOrientation();
 }
 
 void ImageViewer::rotateRight()
@@ -243,20 +371,8 @@ void ImageViewer::rotateRight()
         return;
     }
 
-    cv::Mat rotated;
-    cv::transpose(m_cvImage, rotated);
-    cv::flip(rotated, rotated, 1);
-    m_cvImage = rotated;
-
-    if (m_isOverlayMode && !m_cvImage2.empty()) {
-        updateOverlay();
-    } else {
-        updatePixmapFromMat();
-        m_pixmapItem->setPixmap(m_originalPixmap);
-        m_scene->setSceneRect(m_originalPixmap.rect());
-    }
-
-    emit scaleChanged();
+    m_orientation.rotateRight();
+    applyOrientation();
 }
 
 void ImageViewer::rotate180()
@@ -265,19 +381,8 @@ void ImageViewer::rotate180()
         return;
     }
 
-    cv::Mat rotated;
-    cv::flip(m_cvImage, rotated, -1);
-    m_cvImage = rotated;
-
-    if (m_isOverlayMode && !m_cvImage2.empty()) {
-        updateOverlay();
-    } else {
-        updatePixmapFromMat();
-        m_pixmapItem->setPixmap(m_originalPixmap);
-        m_scene->setSceneRect(m_originalPixmap.rect());
-    }
-
-    emit scaleChanged();
+    m_orientation.rotate180();
+    applyOrientation();
 }
 
 void ImageViewer::flipHorizontal()
@@ -286,19 +391,8 @@ void ImageViewer::flipHorizontal()
         return;
     }
 
-    cv::Mat flipped;
-    cv::flip(m_cvImage, flipped, 1);
-    m_cvImage = flipped;
-
-    if (m_isOverlayMode && !m_cvImage2.empty()) {
-        updateOverlay();
-    } else {
-        updatePixmapFromMat();
-        m_pixmapItem->setPixmap(m_originalPixmap);
-        m_scene->setSceneRect(m_originalPixmap.rect());
-    }
-
-    emit scaleChanged();
+    m_orientation.flipHorizontal();
+    applyOrientation();
 }
 
 void ImageViewer::flipVertical()
@@ -307,148 +401,490 @@ void ImageViewer::flipVertical()
         return;
     }
 
-    cv::Mat flipped;
-    cv::flip(m_cvImage, flipped, 0);
-    m_cvImage = flipped;
+    m_orientation.flipVertical();
+    applyOrientation();
+}
 
-    if (m_isOverlayMode && !m_cvImage2.empty()) {
+void ImageViewer::applyOrientation()
+{
+    // 旋转/翻转只改变图元变换，像素数据保持不变，导出时才烘焙
+    if (m_isOverlayMode && hasOverlayContent()) {
         updateOverlay();
     } else {
-        updatePixmapFromMat();
-        m_pixmapItem->setPixmap(m_originalPixmap);
-        m_scene->setSceneRect(m_originalPixmap.rect());
+        showOriginalPixmap();
     }
 
+    updateSizeInfo();
+    if (m_isRotationPreview) {
+        m_rotationPreviewTimer->start();
+    }
+    emit orientationChanged();
+    emit thumbnailChanged();
     emit scaleChanged();
 }
 
-bool ImageViewer::exportImage(const QString &fileName)
+void ImageViewer::showOriginalPixmap()
 {
-    if (!m_view->isEnabled() || fileName.isEmpty()) {
-        return false;
+    if (!m_pixmapItem) {
+        return;
+    }
+
+    hideOverlayItem();
+    m_pixmapItem->setPixmap(m_originalPixmap);
+    m_pixmapItem->setTransform(m_orientation.toTransform(m_originalPixmap.size()));
+    m_pixmapItem->setVisible(!m_isRotationPreview);
+    m_scene->setSceneRect(m_pixmapItem->sceneBoundingRect());
+}
+
+QGraphicsItem* ImageViewer::displayItem() const
+{
+    if (isOverlayDisplayed()) {
+        return m_overlayItem;
     }
+    return m_pixmapItem;
+}
 
-    cv::Mat imageToExport;
-    if (m_isOverlayMode && !m_cvImage.empty() && !m_cvImage2.empty()) {
-        imageToExport = computeOverlay();
-        if (imageToExport.empty()) {
+bool ImageViewer::exportSnapshot(ExportSnapshot &snapshot)
+{
+    // 这里只复制引用和绘制命令，不做任何整幅像素操作
+    if (m_isOverlayMode && hasOverlayContent()) {
+        if (!overlaySnapshot(snapshot.inputs)) {
             return false;
         }
+        snapshot.overlay = true;
+        snapshot.layers = m_layerStack;
     } else if (!m_cvImage.empty()) {
-        imageToExport = m_cvImage;
+        snapshot.image = m_cvImage;
+        snapshot.orientation = m_orientation;
+        if (m_pixelsMatchFile) {
+            snapshot.sourceFileName = m_currentFileName;
+        }
     } else {
         return false;
     }
+    snapshot.hasAnnotations = snapshotAnnotations(snapshot.annotations);
+    return true;
+}
 
-    QFileInfo fileInfo(fileName);
-    QString suffix = fileInfo.suffix().toLower();
-
-    std::string ext;
-    if (suffix == "png") {
-        ext = ".png";
-    } else if (suffix == "jpg" || suffix == "jpeg") {
-        ext = ".jpg";
-    } else if (suffix == "bmp") {
-        ext = ".bmp";
-    } else if (suffix == "tiff" || suffix == "tif") {
-        ext = ".tiff";
-    } else if (suffix == "webp") {
-        ext = ".webp";
-    } else {
+bool ImageViewer::startExport(const QString &fileName, const ExportOptions &options)
+{
+    if (!m_view->isEnabled() || fileName.isEmpty() || m_exportWatcher->isRunning()) {
         return false;
     }
 
-    std::vector<uchar> buffer;
-    cv::imencode(ext, imageToExport, buffer);
-
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly)) {
+    ExportSnapshot snapshot;
+    if (!exportSnapshot(snapshot)) {
         return false;
     }
 
-    file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
-    file.close();
-
+    m_exportFileName = fileName;
+    m_exportCancel = std::make_shared<std::atomic_bool>(false);
+    std::shared_ptr<std::atomic_bool> cancel = m_exportCancel;
+    QPointer<ImageViewer> self(this);
+    m_exportWatcher->setFuture(QtConcurrent::run([snapshot, fileName, options, cancel, self]() mutable {
+        return runExport(snapshot, fileName, options, *cancel, [self](int percent) {
+            QMetaObject::invokeMethod(self, [self, percent]() {
+                if (self) {
+                    emit self->exportProgress(percent);
+                }
+            }, Qt::QueuedConnection);
+        });
+    }));
     return true;
 }
 
-QFuture<bool> ImageViewer::exportImageAsync(const QString &fileName)
+void ImageViewer::cancelExport()
 {
-    if (!m_view->isEnabled() || fileName.isEmpty()) {
-        return QtConcurrent::run([]() { return false; });
+    if (m_exportCancel) {
+        m_exportCancel->store(true);
     }
+}
 
-    cv::Mat imageToExport;
-    if (m_isOverlayMode && !m_cvImage.empty() && !m_cvImage2.empty()) {
-        imageToExport = computeOverlay();
-        if (imageToExport.empty()) {
-            return QtConcurrent::run([]() { return false; });
-        }
-    } else if (!m_cvImage.empty()) {
-        imageToExport = m_cvImage.clone();
-    } else {
-        return QtConcurrent::run([]() { return false; });
+bool ImageViewer::isExporting() const
+{
+    return m_exportWatcher->isRunning();
+}
+
+void ImageViewer::onExportFinished()
+{
+    ExportStatus status = m_exportWatcher->result();
+    m_exportCancel.reset();
+    emit exportFinished(status == ExportStatus::Succeeded, status == ExportStatus::Cancelled, m_exportFileName);
+}
+
+void ImageViewer::requestExportEstimate(const QString &suffix, const ExportOptions &options)
+{
+    m_estimateSuffix = suffix;
+    m_estimateOptions = options;
+    if (m_estimateWatcher->isRunning()) {
+        m_estimateQueued = true;
+        return;
     }
+    launchExportEstimate();
+}
 
-    QRectF sceneRect = m_scene->sceneRect();
-    QImage renderedImage(sceneRect.size().toSize(), QImage::Format_ARGB32);
-    renderedImage.fill(Qt::transparent);
-    
-    QPainter painter(&renderedImage);
+void ImageViewer::launchExportEstimate()
+{
+    m_estimateQueued = false;
+    ExportSnapshot snapshot;
+    if (!m_view->isEnabled() || !exportSnapshot(snapshot)) {
+        emit exportEstimateReady(ExportEstimate());
+        return;
+    }
+
+    QString suffix = m_estimateSuffix;
+    ExportOptions options = m_estimateOptions;
+    m_estimateWatcher->setFuture(QtConcurrent::run([snapshot, suffix, options]() mutable {
+        return estimateExport(snapshot, suffix, options);
+    }));
+}
+
+void ImageViewer::onEstimateFinished()
+{
+    // 参数已经变化的结果不再通知，直接按最新参数重算
+    if (m_estimateQueued) {
+        launchExportEstimate();
+        return;
+    }
+    emit exportEstimateReady(m_estimateWatcher->result());
+}
+
+bool ImageViewer::canExportJpegLosslessly() const
+{
+    if ((m_isOverlayMode && hasOverlayContent()) || !m_pixelsMatchFile || m_cvImage.empty()) {
+        return false;
+    }
+    QString suffix = QFileInfo(m_currentFileName).suffix().toLower();
+    return (suffix == "jpg" || suffix == "jpeg") && !hasAnnotationItems();
+}
+
+bool ImageViewer::hasAnnotationItems() const
+{
+    const QList<QGraphicsItem*> items = m_scene->items();
+    return std::any_of(items.begin(), items.end(), [this](const QGraphicsItem *item) {
+        return item->isVisible() && isAnnotationItem(item);
+    });
+}
+
+bool ImageViewer::isAnnotationItem(const QGraphicsItem *item) const
+{
+    // 图像本身和对比装饰（分割线、差异区域高亮）不属于标注
+    const QGraphicsItem *top = item->topLevelItem();
+    return top != m_pixmapItem && top != m_overlayItem && top != m_resizeProxyItem
+           && top != m_rotationPreviewItem && top != m_swipeDivider && top != m_regionHighlight;
+}
+
+bool ImageViewer::snapshotAnnotations(QPicture &picture) const
+{
+    QGraphicsItem *item = displayItem();
+    if (!item) {
+        return false;
+    }
+
+    // 按场景顺序把标注图元的绘制命令录制下来，坐标换算到导出图像的像素坐标
+    QPointF origin = item->sceneBoundingRect().topLeft();
+    QPainter painter(&picture);
     painter.setRenderHint(QPainter::Antialiasing);
-    painter.setRenderHint(QPainter::SmoothPixmapTransform);
-    
-    m_scene->render(&painter, QRectF(), sceneRect);
+    painter.translate(-origin);
+
+    bool recorded = false;
+    QStyleOptionGraphicsItem option;
+    const QList<QGraphicsItem*> items = m_scene->items(Qt::AscendingOrder);
+    for (QGraphicsItem *annotation : items) {
+        if (!annotation->isVisible() || !isAnnotationItem(annotation)) {
+            continue;
+        }
+        painter.save();
+        painter.setTransform(annotation->sceneTransform(), true);
+        painter.setOpacity(annotation->effectiveOpacity());
+        option.exposedRect = annotation->boundingRect();
+        option.rect = option.exposedRect.toAlignedRect();
+        annotation->paint(&painter, &option, nullptr);
+        painter.restore();
+        recorded = true;
+    }
     painter.end();
+    return recorded;
+}
+
+QSize ImageViewer::exportSize(const ExportSnapshot &snapshot)
+{
+    return snapshot.overlay
+        ? QSize(snapshot.inputs.aligned1.cols, snapshot.inputs.aligned1.rows)
+        : snapshot.orientation.mapSize(QSize(snapshot.image.cols, snapshot.image.rows));
+}
+
+int ImageViewer::exportPixelType(const ExportSnapshot &snapshot, const QString &suffix,
+                                 std::unique_ptr<BandWriter> &writer)
+{
+    // 普通导出（含标注）保持源图格式，叠加结果为 8 位 BGR。
+    // 格式不支持时依次退到同通道数的 8 位、8 位 BGR；流式写出器仍不支持则放弃流式写出
+    auto supported = [&](int type) {
+        return writer ? writer->supportsType(type) : encoderSupportsType(suffix, type);
+    };
+    const int preferred = snapshot.overlay ? CV_8UC3 : snapshot.image.type();
+    for (int type : {preferred, CV_MAKETYPE(CV_8U, CV_MAT_CN(preferred)), CV_8UC3}) {
+        if (supported(type)) {
+            return type;
+        }
+    }
+    writer.reset();
+    for (int type : {preferred, CV_MAKETYPE(CV_8U, CV_MAT_CN(preferred))}) {
+        if (encoderSupportsType(suffix, type)) {
+            return type;
+        }
+    }
+    return CV_8UC3;
+}
+
+ImageViewer::ExportStatus ImageViewer::runExport(ExportSnapshot &snapshot, const QString &fileName,
+                                                 const ExportOptions &options, const std::atomic_bool &cancel,
+                                                 const std::function<void(int)> &progress)
+{
+    const QSize size = exportSize(snapshot);
+    if (size.isEmpty()) {
+        return ExportStatus::Failed;
+    }
 
-    cv::Mat renderedMat(renderedImage.height(), renderedImage.width(), CV_8UC4);
-    for (int y = 0; y < renderedImage.height(); ++y) {
-        QRgb* line = (QRgb*)renderedImage.scanLine(y);
-        cv::Vec4b* matLine = renderedMat.ptr<cv::Vec4b>(y);
-        for (int x = 0; x < renderedImage.width(); ++x) {
-            matLine[x] = cv::Vec4b(qBlue(line[x]), qGreen(line[x]), qRed(line[x]), qAlpha(line[x]));
+    const QString suffix = QFileInfo(fileName).suffix();
+    if (encoderExtension(suffix).empty()) {
+        return ExportStatus::Failed;
+    }
+    // JPEG 源图只改了方向时不解码也不重新编码
+    QByteArray jpeg;
+    if (rewriteJpegSource(snapshot, suffix, options, jpeg)) {
+        QSaveFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly) || file.write(jpeg) != jpeg.size() || !file.commit()) {
+            return ExportStatus::Failed;
         }
+        progress(100);
+        return ExportStatus::Succeeded;
     }
 
-    cv::Mat finalImage;
-    if (renderedMat.channels() == 4) {
-        cv::cvtColor(renderedMat, finalImage, cv::COLOR_BGRA2BGR);
+    std::unique_ptr<BandWriter> writer = createBandWriter(suffix, options);
+    const int type = exportPixelType(snapshot, suffix, writer);
+
+    // 能流式写出的格式逐行带编码写入临时文件，其余格式先在内存中拼出整幅图像。
+    // 两种方式都只在完整写出后才替换目标文件，失败或取消时已有文件保持不变
+    cv::Mat whole;
+    if (writer) {
+        if (!writer->open(fileName, size.width(), size.height(), type)) {
+            return ExportStatus::Failed;
+        }
     } else {
-        finalImage = renderedMat;
+        whole.create(size.height(), size.width(), type);
+    }
+
+    // 行带预算按实际像素字节数计算：16 位或浮点源图每像素远不止 4 字节
+    const int renderType = snapshot.overlay ? CV_8UC4 : snapshot.image.type();
+    const qint64 pixelBytes = std::max(CV_ELEM_SIZE(type), CV_ELEM_SIZE(renderType));
+    const qint64 rowBytes = static_cast<qint64>(size.width()) * pixelBytes;
+    const int bandRows = static_cast<int>(std::clamp<qint64>(kExportBandBytes / rowBytes, 1, size.height()));
+    // 整幅编码的格式把最后一段进度留给编码
+    const int renderShare = writer ? 100 : 90;
+    int reported = -1;
+    for (int y0 = 0; y0 < size.height(); y0 += bandRows) {
+        if (cancel.load()) {
+            return ExportStatus::Cancelled;
+        }
+        int y1 = std::min(y0 + bandRows, size.height());
+        cv::Mat band = renderExportBand(snapshot, y0, y1);
+        band = toExportType(band, type);
+        if (writer) {
+            if (!writer->writeBand(band)) {
+                return ExportStatus::Failed;
+            }
+        } else {
+            band.copyTo(whole.rowRange(y0, y1));
+        }
+
+        int percent = static_cast<int>(static_cast<qint64>(y1) * renderShare / size.height());
+        if (percent != reported) {
+            reported = percent;
+            progress(percent);
+        }
     }
 
-    QFileInfo fileInfo(fileName);
-    QString suffix = fileInfo.suffix().toLower();
-
-    std::string ext;
-    if (suffix == "png") {
-        ext = ".png";
-    } else if (suffix == "jpg" || suffix == "jpeg") {
-        ext = ".jpg";
-    } else if (suffix == "bmp") {
-        ext = ".bmp";
-    } else if (suffix == "tiff" || suffix == "tif") {
-        ext = ".tiff";
-    } else if (suffix == "webp") {
-        ext = ".webp";
+    if (writer) {
+        if (!writer->finish()) {
+            return ExportStatus::Failed;
+        }
     } else {
-        return QtConcurrent::run([]() { return false; });
+        if (cancel.load()) {
+            return ExportStatus::Cancelled;
+        }
+        if (!writeEncoded(whole, fileName, options)) {
+            return ExportStatus::Failed;
+        }
+    }
+    progress(100);
+    return ExportStatus::Succeeded;
+}
+
+ExportEstimate ImageViewer::estimateExport(ExportSnapshot &snapshot, const QString &suffix,
+                                           const ExportOptions &options)
+{
+    ExportEstimate estimate;
+    const QSize size = exportSize(snapshot);
+    if (size.isEmpty() || encoderExtension(suffix).empty()) {
+        return estimate;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray jpeg;
+    if (rewriteJpegSource(snapshot, suffix, options, jpeg)) {
+        estimate.valid = true;
+        estimate.bytes = jpeg.size();
+        estimate.seconds = timer.nsecsElapsed() * 1e-9;
+        return estimate;
+    }
+
+    std::unique_ptr<BandWriter> writer = createBandWriter(suffix, options);
+    const int type = exportPixelType(snapshot, suffix, writer);
+
+    // 在图像高度上均匀取若干行带，小图直接完整编码一次
+    int samples = kEstimateSamples;
+    int sampleRows = static_cast<int>(std::clamp<qint64>(kEstimatePixels / samples / size.width(), 8, size.height()));
+    if (static_cast<qint64>(sampleRows) * samples >= size.height()) {
+        samples = 1;
+        sampleRows = size.height();
+    }
+
+    qint64 bytes = 0;
+    qint64 nanoseconds = 0;
+    qint64 rows = 0;
+    for (int i = 0; i < samples; ++i) {
+        int y0 = samples == 1 ? 0 : static_cast<int>(static_cast<qint64>(size.height() - sampleRows) * i / (samples - 1));
+        cv::Mat band = renderExportBand(snapshot, y0, y0 + sampleRows);
+        band = toExportType(band, type);
+
+        // 只计编码时间，合成耗时与编码参数无关
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        timer.start();
+        if (!encodeImage(band, suffix, options, &buffer)) {
+            return estimate;
+        }
+        nanoseconds += timer.nsecsElapsed();
+        bytes += buffer.size();
+        rows += band.rows;
     }
 
-    return QtConcurrent::run([finalImage, fileName, ext]() {
-        std::vector<uchar> buffer;
-        cv::imencode(ext, finalImage, buffer);
+    const double scale = static_cast<double>(size.height()) / rows;
+    estimate.valid = true;
+    estimate.bytes = static_cast<qint64>(bytes * scale);
+    estimate.seconds = nanoseconds * 1e-9 * scale;
+    return estimate;
+}
 
-        QFile file(fileName);
-        if (!file.open(QIODevice::WriteOnly)) {
-            return false;
+cv::Mat ImageViewer::renderExportBand(ExportSnapshot &snapshot, int y0, int y1)
+{
+    if (!snapshot.overlay) {
+        // 方向变换是 90° 的整数倍，目标行带恰好对应源图中的一个矩形，只变换这一块
+        QSize sourceSize(snapshot.image.cols, snapshot.image.rows);
+        QSize size = snapshot.orientation.mapSize(sourceSize);
+        QRect sourceRect = snapshot.orientation.toTransform(sourceSize).inverted()
+                               .mapRect(QRectF(0, y0, size.width(), y1 - y0)).toAlignedRect();
+        cv::Mat band = snapshot.orientation.apply(
+            snapshot.image(cv::Rect(sourceRect.x(), sourceRect.y(), sourceRect.width(), sourceRect.height())));
+        if (!snapshot.hasAnnotations) {
+            return band;
         }
 
-        file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
-        file.close();
+        // 标注以 16 位精度光栅化到单独的图层，再按源图位深一趟合成，不经过 8 位画布
+        if (band.datastart == snapshot.image.datastart) {
+            band = band.clone();
+        }
+        QImage layer(band.cols, band.rows, QImage::Format_RGBA64_Premultiplied);
+        layer.fill(Qt::transparent);
+        QPainter painter(&layer);
+        painter.translate(0, -y0);
+        painter.drawPicture(0, 0, snapshot.annotations);
+        painter.end();
+        compositeAnnotationLayer(band, layer);
+        return band;
+    }
+
+    // 叠加结果本身就是 8 位 BGRA 画布；GUI 线程尚未生成的图层在工作线程上补齐
+    snapshot.layers.prepareAll();
+    cv::Mat canvas = blendOverlay(snapshot.inputs, snapshot.layers,
+                                  cv::Rect(0, y0, snapshot.inputs.aligned1.cols, y1 - y0));
+    if (snapshot.hasAnnotations) {
+        // BGRA 内存即 Format_ARGB32，直接在像素数据上回放标注
+        QImage target(canvas.data, canvas.cols, canvas.rows, static_cast<qsizetype>(canvas.step),
+                      QImage::Format_ARGB32);
+        QPainter painter(&target);
+        painter.translate(0, -y0);
+        painter.drawPicture(0, 0, snapshot.annotations);
+        painter.end();
+    }
 
-        return true;
-    });
+    cv::Mat result;
+    cv::cvtColor(canvas, result, cv::COLOR_BGRA2BGR);
+    return result;
+}
+
+cv::Mat ImageViewer::toExportType(const cv::Mat &band, int type)
+{
+    if (band.type() == type) {
+        return band;
+    }
+
+    // 格式存不下源图位深时才降到 8 位，通道数不支持时转为 BGR
+    cv::Mat converted = CV_MAT_DEPTH(type) == band.depth() ? band : toDisplayDepth(band);
+    const int channels = CV_MAT_CN(type);
+    if (converted.channels() != channels) {
+        cv::Mat reordered;
+        if (converted.channels() == 1) {
+            cv::cvtColor(converted, reordered, channels == 4 ? cv::COLOR_GRAY2BGRA : cv::COLOR_GRAY2BGR);
+        } else if (converted.channels() == 4) {
+            cv::cvtColor(converted, reordered, channels == 1 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGRA2BGR);
+        } else {
+            cv::cvtColor(converted, reordered, channels == 1 ? cv::COLOR_BGR2GRAY : cv::COLOR_BGR2BGRA);
+        }
+        converted = reordered;
+    }
+    return converted;
+}
+
+bool ImageViewer::writeEncoded(const cv::Mat &image, const QString &fileName, const ExportOptions &options)
+{
+    if (encoderExtension(QFileInfo(fileName).suffix()).empty()) {
+        return false;
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    // 编码失败时放弃临时文件，目标文件保持原样
+    if (!encodeImage(image, QFileInfo(fileName).suffix(), options, &file)) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool ImageViewer::rewriteJpegSource(const ExportSnapshot &snapshot, const QString &suffix,
+                                    const ExportOptions &options, QByteArray &data)
+{
+    QString lower = suffix.toLower();
+    if (!options.jpegLosslessOrientation || snapshot.sourceFileName.isEmpty() || snapshot.hasAnnotations
+        || (lower != "jpg" && lower != "jpeg")) {
+        return false;
+    }
+
+    // 源文件不是可解析的 JPEG 时返回 false，由调用方按常规方式重新编码
+    QFile source(snapshot.sourceFileName);
+    if (!source.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    data = source.readAll();
+    // 显示的像素已按源文件的 EXIF 方向转正，写回的是两者合成后的方向
+    Orientation stored = orientationFromExifValue(jpegExifOrientation(data));
+    return setJpegExifOrientation(data, exifOrientationValue(stored.followedBy(snapshot.orientation)));
 }
 
 void ImageViewer::applyZoom(int percent)
@@ -457,10 +893,7 @@ void ImageViewer::applyZoom(int percent)
         return;
     }
     
-    qreal scaleFactor = percent / 100.0;
-    
-    m_view->resetTransform();
-    m_view->scale(scaleFactor, scaleFactor);
+    m_view->setZoomPercent(percent);
     
     updateScaleInfo();
     
@@ -485,11 +918,42 @@ bool ImageViewer::isEnabled() const
     return m_view->isEnabled();
 }
 
+QString ImageViewer::currentFileName() const
+{
+    return m_currentFileName;
+}
+
+QString ImageViewer::secondImageFileName() const
+{
+    return m_currentImage2Path;
+}
+
 QPixmap ImageViewer::originalPixmap() const
 {
     return m_originalPixmap;
 }
 
+QImage ImageViewer::thumbnail() const
+{
+    if (m_orientation.isIdentity()) {
+        return m_thumbnail;
+    }
+    return m_thumbnail.transformed(m_orientation.toTransform(m_thumbnail.size()));
+}
+
+Orientation ImageViewer::orientation() const
+{
+    return m_orientation;
+}
+
+QTransform ImageViewer::sceneToImageTransform() const
+{
+    if (!m_pixmapItem) {
+        return QTransform();
+    }
+    return m_pixmapItem->sceneTransform().inverted();
+}
+
 QGraphicsPixmapItem* ImageViewer::pixmapItem() const
 {
     return m_pixmapItem;
@@ -507,81 +971,385 @@ bool ImageViewer::isFitToWindow() const
 
 void ImageViewer::resizeEvent()
 {
-    if (m_isFitToWindow && m_pixmapItem) {
-        m_view->fitInView(m_pixmapItem, Qt::KeepAspectRatio);
-        updateScaleInfo();
+    if (!m_isFitToWindow || !m_pixmapItem) {
+        return;
+    }
+    
+    // 拖动窗口边缘期间只做廉价的变换更新，停止后再精确适应并高质量重绘
+    if (!m_isInteractiveResize) {
+        beginInteractiveResize();
     }
+    m_view->fitInView(displayItem(), Qt::KeepAspectRatio);
+    m_resizeSettleTimer->start(150);
 }
 
-void ImageViewer::updateScaleInfo()
+void ImageViewer::beginInteractiveResize()
 {
-    if (!m_view->isEnabled() || !m_pixmapItem) {
-        if (m_scaleLabel) {
-            m_scaleLabel->setText("缩放:");
-        }
-        return;
-    }
+    m_isInteractiveResize = true;
     
-    QSize originalSize = m_originalPixmap.size();
-    if (originalSize.width() <= 0 || originalSize.height() <= 0) {
-        if (m_scaleLabel) {
-            m_scaleLabel->setText("缩放:");
-        }
+    // 旋转预览本身只覆盖可见区域，稳定后按新视口重新生成即可；
+    // 叠加图元按可见瓦片渲染，本身就足够廉价
+    if (m_isRotationPreview || isOverlayDisplayed()) {
         return;
     }
     
-    qreal currentScale = m_view->transform().m11() * 100;
+    QPixmap source = m_pixmapItem->pixmap();
+    qreal deviceScale = m_view->zoomPercent() / 100.0;
+    QSize frameSize = (QSizeF(source.size()) * deviceScale).toSize();
     
-    if (m_scaleLabel) {
-        m_scaleLabel->setText(tr("缩放:"));
+    // 放大显示时原图本身就比帧小，直接用最近邻缩放即可
+    if (frameSize.isEmpty() || frameSize.width() >= source.width() || frameSize.height() >= source.height()) {
+        m_pixmapItem->setTransformationMode(Qt::FastTransformation);
+        return;
     }
     
-    if (m_zoomSlider) {
-        m_zoomSlider->setValue(qRound(qBound(qreal(1), currentScale, qreal(3200))));
-    }
-    if (m_zoomSpinBox) {
-        m_zoomSpinBox->setValue(qRound(qBound(qreal(1), currentScale, qreal(3200))));
-    }
-}
-
-void ImageViewer::updateSizeInfo()
-{
-    if (m_pixmapItem && m_view->isEnabled()) {
-        int width = m_originalPixmap.width();
-        int height = m_originalPixmap.height();
-        if (m_sizeLabel) {
-            m_sizeLabel->setText(tr("尺寸: %1x%2").arg(width).arg(height));
-        }
-        
-        if (m_imageSizeLabel) {
-            QString sizeStr;
-            if (m_fileSize < 1024) {
-                sizeStr = tr("%1 B").arg(m_fileSize);
-            } else if (m_fileSize < 1024 * 1024) {
-                sizeStr = tr("%1 KB").arg(m_fileSize / 1024.0, 0, 'f', 2);
-            } else if (m_fileSize < 1024 * 1024 * 1024) {
-                sizeStr = tr("%1 MB").arg(m_fileSize / (1024.0 * 1024.0), 0, 'f', 2);
-            } else {
-                sizeStr = tr("%1 GB").arg(m_fileSize / (1024.0 * 1024.0 * 1024.0), 0, 'f', 2);
-            }
-            m_imageSizeLabel->setText(tr("图片大小: %1").arg(sizeStr));
-        }
-    } else {
-        if (m_sizeLabel) {
-            m_sizeLabel->setText("尺寸: 0x0");
-        }
-        if (m_imageSizeLabel) {
-            m_imageSizeLabel->setText("图片大小: 0 B");
-        }
+    // 按当前显示分辨率渲染一帧，拖动期间只缩放这张小图
+    QPixmap frame(frameSize);
+    frame.fill(Qt::transparent);
+    {
+        QPainter painter(&frame);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.drawPixmap(frame.rect(), source);
     }
+    
+    m_resizeProxyItem = m_scene->addPixmap(frame);
+    m_resizeProxyItem->setTransformationMode(Qt::SmoothTransformation);
+    m_resizeProxyItem->setZValue(m_pixmapItem->zValue() - 1);
+    // 帧按图元自身坐标渲染，再套用图元的方向变换
+    m_resizeProxyItem->setTransform(QTransform::fromScale(qreal(source.width()) / frame.width(),
+                                                          qreal(source.height()) / frame.height())
+                                    * m_pixmapItem->sceneTransform());
+    m_pixmapItem->setVisible(false);
 }
 
-void ImageViewer::updatePixmapFromMat()
+void ImageViewer::finishInteractiveResize()
 {
-    if (m_cvImage.empty()) {
+    if (!m_isInteractiveResize) {
         return;
     }
     
+    m_resizeSettleTimer->stop();
+    m_isInteractiveResize = false;
+    
+    if (m_resizeProxyItem) {
+        m_scene->removeItem(m_resizeProxyItem);
+        delete m_resizeProxyItem;
+        m_resizeProxyItem = nullptr;
+    }
+    
+    if (m_pixmapItem) {
+        m_pixmapItem->setVisible(!m_isRotationPreview && !isOverlayDisplayed());
+        if (m_isFitToWindow) {
+            m_view->fitInView(displayItem(), Qt::KeepAspectRatio);
+        }
+        updateScaleInfo();
+    }
+}
+
+void ImageViewer::setPreviewRotation(double degrees)
+{
+    if (m_cvImage.empty() || !m_pixmapItem) {
+        return;
+    }
+
+    if (qFuzzyIsNull(degrees)) {
+        clearRotationPreview();
+        return;
+    }
+
+    m_isRotationPreview = true;
+    m_previewAngle = degrees;
+    m_rotationPreviewTimer->start();
+}
+
+void ImageViewer::clearRotationPreview()
+{
+    m_rotationPreviewTimer->stop();
+    m_isRotationPreview = false;
+    m_previewAngle = 0.0;
+
+    if (m_rotationPreviewItem) {
+        m_scene->removeItem(m_rotationPreviewItem);
+        delete m_rotationPreviewItem;
+        m_rotationPreviewItem = nullptr;
+    }
+    if (m_pixmapItem && !m_isInteractiveResize) {
+        m_pixmapItem->setVisible(!isOverlayDisplayed());
+    }
+}
+
+QTransform ImageViewer::rotationSceneToSource(double degrees) const
+{
+    // 场景坐标绕画布中心逆向旋转回方向变换后的坐标，再经方向逆变换回原图坐标
+    QSize imageSize(m_cvImage.cols, m_cvImage.rows);
+    QSize canvasSize = m_orientation.mapSize(imageSize);
+    qreal cx = canvasSize.width() / 2.0;
+    qreal cy = canvasSize.height() / 2.0;
+
+    QTransform sceneToOriented = QTransform::fromTranslate(-cx, -cy)
+                                 * QTransform().rotate(-degrees)
+                                 * QTransform::fromTranslate(cx, cy);
+    return sceneToOriented * m_orientation.toTransform(imageSize).inverted();
+}
+
+void ImageViewer::updateRotationPreview()
+{
+    if (!m_isRotationPreview || m_cvImage.empty() || !m_pixmapItem) {
+        return;
+    }
+
+    ScopedPerfTimer timer(PerfStats::Convert);
+
+    QRectF canvas = m_scene->sceneRect();
+    QRectF visible = m_view->mapToScene(m_view->viewport()->rect()).boundingRect().intersected(canvas);
+    if (visible.isEmpty()) {
+        return;
+    }
+
+    qreal deviceScale = m_view->zoomPercent() / 100.0;
+    QSize frameSize = (visible.size() * deviceScale).toSize().expandedTo(QSize(1, 1));
+
+    // 缩小显示时从降采样后的源图取样，避免线性插值产生混叠。降采样层在后台生成，
+    // 就绪前沿用上一层；还没有任何层时直接从原图取样，每帧只处理视口大小的像素
+    int level = TiledImageItem::levelForScale(deviceScale);
+    if (level == 1) {
+        m_rotationPreviewSource = m_cvImage;
+        m_rotationPreviewLevel = 1;
+    } else if (level != m_rotationPreviewLevel || m_rotationPreviewSource.empty()) {
+        requestRotationPreviewLevel(level);
+    }
+    const cv::Mat source = m_rotationPreviewSource.empty() ? m_cvImage : m_rotationPreviewSource;
+    qreal levelScaleX = static_cast<qreal>(source.cols) / m_cvImage.cols;
+    qreal levelScaleY = static_cast<qreal>(source.rows) / m_cvImage.rows;
+
+    // 帧像素中心 -> 场景 -> 原图 -> 降采样源图像素中心
+    qreal stepX = visible.width() / frameSize.width();
+    qreal stepY = visible.height() / frameSize.height();
+    QTransform frameToSource = QTransform::fromTranslate(0.5, 0.5)
+                               * QTransform::fromScale(stepX, stepY)
+                               * QTransform::fromTranslate(visible.left(), visible.top())
+                               * rotationSceneToSource(m_previewAngle)
+                               * QTransform::fromScale(levelScaleX, levelScaleY)
+                               * QTransform::fromTranslate(-0.5, -0.5);
+
+    cv::Mat frame;
+    cv::warpAffine(source, frame, toAffineMatrix(frameToSource),
+                   cv::Size(frameSize.width(), frameSize.height()),
+                   cv::INTER_LINEAR | cv::WARP_INVERSE_MAP, cv::BORDER_CONSTANT);
+
+    if (!m_rotationPreviewItem) {
+        m_rotationPreviewItem = m_scene->addPixmap(QPixmap());
+        m_rotationPreviewItem->setZValue(m_pixmapItem->zValue() + 0.5);
+        m_rotationPreviewItem->setTransformationMode(Qt::SmoothTransformation);
+    }
+    m_rotationPreviewItem->setPixmap(QPixmap::fromImage(cvMatToQImage(frame)));
+    m_rotationPreviewItem->setPos(visible.topLeft());
+    m_rotationPreviewItem->setTransform(QTransform::fromScale(stepX, stepY));
+    m_pixmapItem->setVisible(false);
+}
+
+void ImageViewer::requestRotationPreviewLevel(int level)
+{
+    if (m_rotationLevelWatcher->isRunning()) {
+        // 完成时若所需的层已变化会重新请求
+        return;
+    }
+
+    m_pendingRotationLevel = level;
+    m_pendingRotationLevelSource = m_cvImage;
+    cv::Mat source = m_cvImage;
+    m_rotationLevelWatcher->setFuture(QtConcurrent::run([source, level]() {
+        cv::Mat scaled;
+        cv::resize(source, scaled, cv::Size(qMax(1, source.cols / level), qMax(1, source.rows / level)),
+                   0, 0, cv::INTER_AREA);
+        return scaled;
+    }));
+}
+
+void ImageViewer::onRotationPreviewLevelFinished()
+{
+    cv::Mat scaled = m_rotationLevelWatcher->result();
+    bool stale = m_pendingRotationLevelSource.data != m_cvImage.data;
+    m_pendingRotationLevelSource.release();
+
+    if (!stale && !scaled.empty()) {
+        m_rotationPreviewSource = scaled;
+        m_rotationPreviewLevel = m_pendingRotationLevel;
+    }
+    // 用新层重绘；若缩放级别或图片已变化，会请求新的层
+    if (m_isRotationPreview) {
+        m_rotationPreviewTimer->start();
+    }
+}
+
+void ImageViewer::commitRotation(double degrees)
+{
+    if (m_cvImage.empty() || m_rotationWatcher->isRunning()) {
+        return;
+    }
+
+    QSize canvasSize = m_orientation.mapSize(QSize(m_cvImage.cols, m_cvImage.rows));
+    cv::Matx23d dstToSrc = toAffineMatrix(QTransform::fromTranslate(0.5, 0.5)
+                                          * rotationSceneToSource(degrees)
+                                          * QTransform::fromTranslate(-0.5, -0.5));
+    cv::Size dstSize(canvasSize.width(), canvasSize.height());
+
+    // 记录提交时的源图与方向，完成时若已切换图片或再次旋转则丢弃结果
+    m_pendingRotationSource = m_cvImage;
+    m_pendingRotationOrientation = m_orientation;
+
+    cv::Mat source = m_cvImage;
+    m_rotationWatcher->setFuture(QtConcurrent::run([source, dstToSrc, dstSize]() {
+        return warpAffineParallel(source, dstToSrc, dstSize);
+    }));
+}
+
+void ImageViewer::onRotationFinished()
+{
+    cv::Mat rotated = m_rotationWatcher->result();
+    bool stale = m_pendingRotationSource.data != m_cvImage.data
+                 || m_pendingRotationOrientation != m_orientation;
+    m_pendingRotationSource.release();
+
+    if (!stale && !rotated.empty()) {
+        clearRotationPreview();
+        m_rotationPreviewSource.release();
+
+        invalidateAlignedInputs();
+        m_cvImage = rotated;
+        m_pixelsMatchFile = false;
+        m_orientation.reset();
+        m_thumbnail = ImageCache::createThumbnail(m_cvImage);
+        updatePixmapFromMat();
+
+        if (m_isOverlayMode && hasOverlayContent()) {
+            updateOverlay();
+        } else {
+            showOriginalPixmap();
+        }
+        updateSizeInfo();
+
+        emit orientationChanged();
+        emit thumbnailChanged();
+        emit scaleChanged();
+    }
+
+    emit rotationCommitted();
+}
+
+QFuture<double> ImageViewer::estimateSkewAsync() const
+{
+    cv::Mat source = m_cvImage;
+    Orientation orientation = m_orientation;
+    return QtConcurrent::run([source, orientation]() {
+        return estimateSkewAngle(source, orientation);
+    });
+}
+
+void ImageViewer::updateScaleInfo()
+{
+    if (!m_view->isEnabled() || !m_pixmapItem) {
+        if (m_scaleLabel) {
+            m_scaleLabel->setText("缩放:");
+        }
+        return;
+    }
+    
+    QSize originalSize = m_originalPixmap.size();
+    if (originalSize.width() <= 0 || originalSize.height() <= 0) {
+        if (m_scaleLabel) {
+            m_scaleLabel->setText("缩放:");
+        }
+        return;
+    }
+    
+    qreal currentScale = m_view->zoomPercent();
+    
+    if (m_scaleLabel) {
+        m_scaleLabel->setText(tr("缩放:"));
+    }
+    
+    updateSamplingMode();
+    
+    if (m_isRotationPreview) {
+        m_rotationPreviewTimer->start();
+    }
+    if (m_swipeDivider) {
+        m_swipeDivider->setViewScale(m_view->transform().m11());
+    }
+    if (!m_metricsGrid.isEmpty()) {
+        m_visibleMetricsTimer->start();
+    }
+    
+    // 程序化同步控件时屏蔽信号，避免经 valueChanged 回调 applyZoom 再次缩放
+    int percent = qRound(qBound(qreal(1), currentScale, qreal(3200)));
+    if (m_zoomSlider && m_zoomSlider->value() != percent) {
+        QSignalBlocker blocker(m_zoomSlider);
+        m_zoomSlider->setValue(percent);
+    }
+    if (m_zoomSpinBox && m_zoomSpinBox->value() != percent) {
+        QSignalBlocker blocker(m_zoomSpinBox);
+        m_zoomSpinBox->setValue(percent);
+    }
+}
+
+void ImageViewer::updateSamplingMode()
+{
+    if (!m_pixmapItem) {
+        return;
+    }
+
+    // 视图变换与设备像素比在绘制时合并为一次变换直接采样到物理像素；
+    // 恰好 1:1 时使用最近邻，避免平滑插值把像素边缘糊掉
+    qreal deviceScale = m_view->zoomPercent() / 100.0;
+    bool pixelExact = qAbs(deviceScale - 1.0) < 1e-6;
+    Qt::TransformationMode mode = pixelExact ? Qt::FastTransformation : Qt::SmoothTransformation;
+    if (m_pixmapItem->transformationMode() != mode) {
+        m_pixmapItem->setTransformationMode(mode);
+    }
+}
+
+void ImageViewer::updateSizeInfo()
+{
+    if (m_pixmapItem && m_view->isEnabled()) {
+        QSize displaySize = m_orientation.mapSize(m_originalPixmap.size());
+        int width = displaySize.width();
+        int height = displaySize.height();
+        if (m_sizeLabel) {
+            m_sizeLabel->setText(tr("尺寸: %1x%2").arg(width).arg(height));
+        }
+        
+        if (m_imageSizeLabel) {
+            QString sizeStr;
+            if (m_fileSize < 1024) {
+                sizeStr = tr("%1 B").arg(m_fileSize);
+            } else if (m_fileSize < 1024 * 1024) {
+                sizeStr = tr("%1 KB").arg(m_fileSize / 1024.0, 0, 'f', 2);
+            } else if (m_fileSize < 1024 * 1024 * 1024) {
+                sizeStr = tr("%1 MB").arg(m_fileSize / (1024.0 * 1024.0), 0, 'f', 2);
+            } else {
+                sizeStr = tr("%1 GB").arg(m_fileSize / (1024.0 * 1024.0 * 1024.0), 0, 'f', 2);
+            }
+            m_imageSizeLabel->setText(tr("图片大小: %1").arg(sizeStr));
+        }
+    } else {
+        if (m_sizeLabel) {
+            m_sizeLabel->setText("尺寸: 0x0");
+        }
+        if (m_imageSizeLabel) {
+            m_imageSizeLabel->setText("图片大小: 0 B");
+        }
+    }
+}
+
+void ImageViewer::updatePixmapFromMat()
+{
+    if (m_cvImage.empty()) {
+        return;
+    }
+    
+    ScopedPerfTimer timer(PerfStats::Convert);
+    
     cv::Mat cvImageRGB;
     if (m_cvImage.channels() == 3) {
         cv::cvtColor(m_cvImage, cvImageRGB, cv::COLOR_BGR2RGB);
@@ -692,6 +1460,151 @@ void ImageViewer::previousImage()
     openImage(m_imageList[m_currentImageIndex]);
 }
 
+void ImageViewer::setPairedDirectory(const QString &directoryPath)
+{
+    if (m_pairedDirectory == directoryPath) {
+        return;
+    }
+
+    m_pairedDirectory = directoryPath;
+    cancelPairPrefetches();
+    emit pairedDirectoryChanged(directoryPath);
+    loadManualAlignment();
+
+    if (m_pairedDirectory.isEmpty() || m_cvImage.empty()) {
+        return;
+    }
+
+    // 立即为当前图片加载配对
+    QString pairedPath = pairedPathFor(m_currentFileName);
+    if (!pairedPath.isEmpty()) {
+        loadSecondImage(pairedPath);
+    } else if (!m_cvImage2.empty()) {
+        clearSecondImage();
+    }
+    prefetchNeighbourPairs();
+}
+
+QString ImageViewer::pairedDirectory() const
+{
+    return m_pairedDirectory;
+}
+
+QString ImageViewer::pairedPathFor(const QString &fileName) const
+{
+    if (m_pairedDirectory.isEmpty() || fileName.isEmpty()) {
+        return QString();
+    }
+
+    // 优先同名文件，其次同一基本名的其他图片格式
+    QFileInfo fileInfo(fileName);
+    QDir dir(m_pairedDirectory);
+    if (dir.exists(fileInfo.fileName())) {
+        return dir.absoluteFilePath(fileInfo.fileName());
+    }
+
+    QStringList filters;
+    for (const QString &suffix : {"png", "jpg", "jpeg", "bmp", "tiff", "tif", "webp"}) {
+        filters << fileInfo.completeBaseName() + "." + suffix;
+    }
+    QFileInfoList matches = dir.entryInfoList(filters, QDir::Files, QDir::Name | QDir::IgnoreCase);
+    return matches.isEmpty() ? QString() : matches.first().absoluteFilePath();
+}
+
+void ImageViewer::loadPairedImage(const QString &fileName)
+{
+    // 配对缺失或无法解码时清空第二张图片，不弹出提示以免打断连续浏览
+    QString pairedPath = pairedPathFor(fileName);
+    ImageCache::Entry entry;
+    if (!pairedPath.isEmpty() && ImageCache::instance().load(pairedPath, entry) == ImageCache::Loaded) {
+        m_cvImage2 = entry.image;
+        m_currentImage2Path = pairedPath;
+        emit secondImageLoaded(pairedPath);
+    } else if (!m_cvImage2.empty() || !m_currentImage2Path.isEmpty()) {
+        m_cvImage2.release();
+        m_currentImage2Path.clear();
+        emit secondImageCleared();
+    }
+}
+
+void ImageViewer::prefetchNeighbourPairs()
+{
+    if (m_imageList.size() < 2) {
+        cancelPairPrefetches();
+        return;
+    }
+
+    int count = m_imageList.size();
+    QStringList neighbours;
+    neighbours << m_imageList[(m_currentImageIndex + 1) % count];
+    neighbours << m_imageList[(m_currentImageIndex + count - 1) % count];
+    neighbours.removeDuplicates();
+
+    // 对齐只服务于叠加显示，非叠加模式下仅预解码
+    bool align = m_isOverlayMode;
+
+    // 保留仍是相邻配对的任务（包括尚未完成的），其余取消
+    QList<PairPrefetch> prefetches;
+    for (const QString &fileName1 : neighbours) {
+        QString fileName2 = pairedPathFor(fileName1);
+        bool reused = false;
+        for (int i = 0; i < m_pairPrefetches.size(); ++i) {
+            const PairPrefetch &prefetch = m_pairPrefetches[i];
+            if (prefetch.fileName1 == fileName1 && prefetch.fileName2 == fileName2
+                && (prefetch.align || !align)) {
+                prefetches << m_pairPrefetches.takeAt(i);
+                reused = true;
+                break;
+            }
+        }
+        if (reused) {
+            continue;
+        }
+
+        PairPrefetch prefetch;
+        prefetch.fileName1 = fileName1;
+        prefetch.fileName2 = fileName2;
+        prefetch.align = align;
+        prefetch.cancel = std::make_shared<std::atomic_bool>(false);
+        std::shared_ptr<std::atomic_bool> cancel = prefetch.cancel;
+        prefetch.future = QtConcurrent::run([fileName1, fileName2, align, cancel]() {
+            PreparedPair pair;
+            pair.fileName1 = fileName1;
+            pair.fileName2 = fileName2;
+
+            // 解码结果进入共享缓存，切换时 openImage 命中同一份数据
+            ImageCache::Entry entry1;
+            if (*cancel || ImageCache::instance().load(fileName1, entry1) != ImageCache::Loaded) {
+                return pair;
+            }
+            pair.source1 = entry1.image;
+
+            ImageCache::Entry entry2;
+            if (*cancel || fileName2.isEmpty()
+                || ImageCache::instance().load(fileName2, entry2) != ImageCache::Loaded) {
+                return pair;
+            }
+            pair.source2 = entry2.image;
+            if (align && !*cancel) {
+                alignImages(pair.source1, pair.source2, pair.aligned1, pair.aligned2);
+            }
+            return pair;
+        });
+        prefetches << prefetch;
+    }
+    cancelPairPrefetches();
+    m_pairPrefetches = prefetches;
+}
+
+void ImageViewer::cancelPairPrefetches()
+{
+    // 已在进行的解码或对齐无法中断，只是不再开始后续步骤
+    for (const PairPrefetch &prefetch : m_pairPrefetches) {
+        *prefetch.cancel = true;
+    }
+    m_pairPrefetches.clear();
+}
+
 // Overlay mode implementation
 
 void ImageViewer::enableOverlayMode(bool enable)
@@ -699,15 +1612,16 @@ void ImageViewer::enableOverlayMode(bool enable)
     m_isOverlayMode = enable;
     emit overlayModeChanged(enable);
 
-    if (enable && !m_cvImage2.empty()) {
+    if (enable && hasOverlayContent()) {
         updateOverlay();
     } else if (!enable && !m_cvImage.empty()) {
         // Restore original image 1
-        updatePixmapFromMat();
-        if (m_pixmapItem) {
-            m_pixmapItem->setPixmap(m_originalPixmap);
-            m_scene->setSceneRect(m_originalPixmap.rect());
-        }
+        showOriginalPixmap();
+    }
+
+    // 进入叠加模式后相邻配对需要补上对齐
+    if (enable && !m_pairedDirectory.isEmpty()) {
+        prefetchNeighbourPairs();
     }
 }
 
@@ -722,24 +1636,19 @@ bool ImageViewer::loadSecondImage(const QString &fileName)
         return false;
     }
 
-    QFile file(fileName);
-    if (!file.open(QIODevice::ReadOnly)) {
+    ImageCache::Entry entry;
+    ImageCache::Status status = ImageCache::instance().load(fileName, entry);
+    if (status == ImageCache::OpenFailed) {
         QMessageBox::warning(nullptr, tr("错误"), tr("无法打开图片文件: %1").arg(fileName));
         return false;
     }
-
-    QByteArray fileData = file.readAll();
-    file.close();
-
-    cv::Mat matData(1, fileData.size(), CV_8U, (void*)fileData.data());
-
-    cv::Mat cvImage = cv::imdecode(matData, cv::IMREAD_UNCHANGED);
-    if (cvImage.empty()) {
+    if (status == ImageCache::DecodeFailed) {
         QMessageBox::warning(nullptr, tr("错误"), tr("无法解码图片文件: %1").arg(fileName));
         return false;
     }
 
-    m_cvImage2 = cvImage;
+    invalidateAlignedInputs();
+    m_cvImage2 = entry.image;
     m_currentImage2Path = fileName;
 
     emit secondImageLoaded(fileName);
@@ -755,16 +1664,15 @@ void ImageViewer::clearSecondImage()
 {
     m_cvImage2.release();
     m_currentImage2Path.clear();
+    invalidateAlignedInputs();
 
     emit secondImageCleared();
 
-    if (m_isOverlayMode && !m_cvImage.empty()) {
+    if (m_isOverlayMode && hasOverlayContent()) {
+        updateOverlay();
+    } else if (m_isOverlayMode && !m_cvImage.empty()) {
         // Restore original image 1
-        updatePixmapFromMat();
-        if (m_pixmapItem) {
-            m_pixmapItem->setPixmap(m_originalPixmap);
-            m_scene->setSceneRect(m_originalPixmap.rect());
-        }
+        showOriginalPixmap();
     }
 }
 
@@ -772,8 +1680,8 @@ void ImageViewer::setAlpha1(double alpha)
 {
     m_alpha1 = qBound(0.0, alpha, 1.0);
 
-    if (m_isOverlayMode && !m_cvImage.empty() && !m_cvImage2.empty()) {
-        m_overlayUpdateTimer->start(100);
+    if (m_compareMode == CompareBlend) {
+        refreshOverlayTiles();
     }
 }
 
@@ -781,8 +1689,8 @@ void ImageViewer::setAlpha2(double alpha)
 {
     m_alpha2 = qBound(0.0, alpha, 1.0);
 
-    if (m_isOverlayMode && !m_cvImage.empty() && !m_cvImage2.empty()) {
-        m_overlayUpdateTimer->start(100);
+    if (m_compareMode == CompareBlend) {
+        refreshOverlayTiles();
     }
 }
 
@@ -796,105 +1704,1090 @@ double ImageViewer::getAlpha2() const
     return m_alpha2;
 }
 
-void ImageViewer::alignImages(const cv::Mat &img1, const cv::Mat &img2,
-                               cv::Mat &aligned1, cv::Mat &aligned2)
+void ImageViewer::setCompareMode(CompareMode mode)
 {
-    // Unify number of channels
-    cv::Mat img1_unified, img2_unified;
-
-    // Convert to RGB if needed
-    if (img1.channels() == 1) {
-        cv::cvtColor(img1, img1_unified, cv::COLOR_GRAY2BGR);
-    } else if (img1.channels() == 4) {
-        cv::cvtColor(img1, img1_unified, cv::COLOR_BGRA2BGR);
-    } else {
-        img1_unified = img1.clone();
-    }
-
-    if (img2.channels() == 1) {
-        cv::cvtColor(img2, img2_unified, cv::COLOR_GRAY2BGR);
-    } else if (img2.channels() == 4) {
-        cv::cvtColor(img2, img2_unified, cv::COLOR_BGRA2BGR);
-    } else {
-        img2_unified = img2.clone();
+    if (m_compareMode == mode) {
+        return;
     }
 
-    // Get maximum dimensions
-    int maxWidth = std::max(img1_unified.cols, img2_unified.cols);
-    int maxHeight = std::max(img1_unified.rows, img2_unified.rows);
-
-    // Create canvases with maximum size
-    aligned1 = cv::Mat::zeros(maxHeight, maxWidth, CV_8UC3);
-    aligned2 = cv::Mat::zeros(maxHeight, maxWidth, CV_8UC3);
+    m_compareMode = mode;
+    m_flickerShowSecond = false;
+    updateCompareDecorations();
+    refreshOverlayTiles();
+}
 
-    // Center align images
-    int x1 = (maxWidth - img1_unified.cols) / 2;
-    int y1 = (maxHeight - img1_unified.rows) / 2;
-    img1_unified.copyTo(aligned1(cv::Rect(x1, y1, img1_unified.cols, img1_unified.rows)));
+ImageViewer::CompareMode ImageViewer::compareMode() const
+{
+    return m_compareMode;
+}
 
-    int x2 = (maxWidth - img2_unified.cols) / 2;
-    int y2 = (maxHeight - img2_unified.rows) / 2;
-    img2_unified.copyTo(aligned2(cv::Rect(x2, y2, img2_unified.cols, img2_unified.rows)));
+void ImageViewer::setDifferenceGain(double gain)
+{
+    m_differenceGain = qMax(1.0, gain);
+    if (m_compareMode == CompareDifference) {
+        refreshOverlayTiles();
+    }
 }
 
-cv::Mat ImageViewer::computeOverlay()
+void ImageViewer::setDifferenceHeatmap(bool enabled)
 {
-    if (m_cvImage.empty() || m_cvImage2.empty()) {
-        return cv::Mat();
+    m_differenceHeatmap = enabled;
+    if (m_compareMode == CompareDifference) {
+        refreshOverlayTiles();
     }
+}
 
-    cv::Mat aligned1, aligned2;
-    alignImages(m_cvImage, m_cvImage2, aligned1, aligned2);
+void ImageViewer::setSwipePosition(double fraction)
+{
+    m_swipePosition = qBound(0.0, fraction, 1.0);
+    if (m_swipeDivider && m_overlayItem) {
+        m_swipeDivider->setDividerX(m_swipePosition * m_overlayItem->canvasSize().width());
+    }
+    if (m_compareMode == CompareSwipe) {
+        refreshOverlayTiles();
+    }
+}
 
-    cv::Mat result;
-    cv::addWeighted(aligned1, m_alpha1, aligned2, m_alpha2, 0, result);
+void ImageViewer::setCheckerSize(int size)
+{
+    m_checkerSize = qMax(1, size);
+    if (m_compareMode == CompareCheckerboard) {
+        refreshOverlayTiles();
+    }
+}
 
-    return result;
+void ImageViewer::setFlickerRate(double rate)
+{
+    m_flickerTimer->setInterval(qMax(1, qRound(1000.0 / qMax(0.1, rate))));
 }
 
-void ImageViewer::updateOverlay()
+void ImageViewer::refreshOverlayTiles()
 {
-    if (!m_isOverlayMode || m_cvImage.empty() || m_cvImage2.empty()) {
-        return;
+    // 只丢弃已缓存的瓦片，下一帧按显示分辨率重新渲染可见部分
+    if (isOverlayDisplayed()) {
+        m_overlayItem->invalidate();
     }
+}
 
-    m_overlayResult = computeOverlay();
+void ImageViewer::updateCompareDecorations()
+{
+    bool overlayShown = isOverlayDisplayed();
+
+    bool showDivider = overlayShown && m_compareMode == CompareSwipe;
+    if (showDivider && !m_swipeDivider) {
+        m_swipeDivider = new SwipeDividerItem();
+        m_scene->addItem(m_swipeDivider);
+        connect(m_swipeDivider, &SwipeDividerItem::dividerMoved, this, [this](qreal x) {
+            QSize canvasSize = m_overlayItem->canvasSize();
+            if (canvasSize.width() <= 0) {
+                return;
+            }
+            qreal oldX = m_swipePosition * canvasSize.width();
+            m_swipePosition = qBound(0.0, x / canvasSize.width(), 1.0);
+            // 只有新旧分割线之间的瓦片内容发生变化
+            int left = qFloor(qMin(oldX, x)) - 1;
+            int right = qCeil(qMax(oldX, x)) + 1;
+            m_overlayItem->invalidateRect(QRect(left, 0, right - left, canvasSize.height()));
+            emit swipePositionChanged(m_swipePosition);
+        });
+    }
+    if (m_swipeDivider) {
+        if (showDivider) {
+            QSize canvasSize = m_overlayItem->canvasSize();
+            m_swipeDivider->setCanvasSize(canvasSize);
+            m_swipeDivider->setDividerX(m_swipePosition * canvasSize.width());
+            m_swipeDivider->setViewScale(m_view->transform().m11());
+            m_swipeDivider->setZValue(m_overlayItem->zValue() + 1);
+        }
+        m_swipeDivider->setVisible(showDivider);
+    }
 
-    if (m_overlayResult.empty()) {
-        return;
+    if (overlayShown && m_compareMode == CompareFlicker) {
+        if (!m_flickerTimer->isActive()) {
+            m_flickerTimer->start();
+        }
+    } else {
+        m_flickerTimer->stop();
     }
+}
 
-    // Convert overlay result to QPixmap
-    cv::Mat cvImageRGB;
-    if (m_overlayResult.channels() == 3) {
-        cv::cvtColor(m_overlayResult, cvImageRGB, cv::COLOR_BGR2RGB);
-    } else if (m_overlayResult.channels() == 4) {
-        cv::cvtColor(m_overlayResult, cvImageRGB, cv::COLOR_BGRA2RGBA);
+void ImageViewer::alignImages(const cv::Mat &img1, const cv::Mat &img2,
+                               cv::Mat &aligned1, cv::Mat &aligned2)
+{
+    // Get maximum dimensions
+    int maxWidth = std::max(img1.cols, img2.cols);
+    int maxHeight = std::max(img1.rows, img2.rows);
+
+    // Center align images, converting straight into the canvas
+    placeCentered(img1, maxWidth, maxHeight, aligned1);
+    if (img2.empty()) {
+        // 只有附加图层时没有第二张图片
+        aligned2.release();
     } else {
-        cvImageRGB = m_overlayResult.clone();
+        placeCentered(img2, maxWidth, maxHeight, aligned2);
     }
+}
 
-    QImage::Format format;
-    if (cvImageRGB.channels() == 1) {
-        format = QImage::Format_Grayscale8;
-    } else if (cvImageRGB.channels() == 4) {
-        format = QImage::Format_RGBA8888;
+void ImageViewer::placeCentered(const cv::Mat &image, int width, int height, cv::Mat &canvas)
+{
+    // 尺寸和类型不变时 create 不会重新分配；使用 BGRA 布局以便直接输出到显示缓冲区
+    canvas.create(height, width, CV_8UC4);
+    if (image.cols != width || image.rows != height) {
+        canvas.setTo(cv::Scalar::all(0));
+    }
+
+    int x = (width - image.cols) / 2;
+    int y = (height - image.rows) / 2;
+    cv::Mat target = canvas(cv::Rect(x, y, image.cols, image.rows));
+
+    // Unify depth and number of channels
+    cv::Mat source = toDisplayDepth(image);
+    if (source.channels() == 1) {
+        cv::cvtColor(source, target, cv::COLOR_GRAY2BGRA);
+    } else if (source.channels() == 3) {
+        cv::cvtColor(source, target, cv::COLOR_BGR2BGRA);
     } else {
-        format = QImage::Format_RGB888;
+        source.copyTo(target);
     }
+}
 
-    QImage qImage(
-        cvImageRGB.data,
-        cvImageRGB.cols,
-        cvImageRGB.rows,
-        static_cast<int>(cvImageRGB.step),
-        format
-    );
+bool ImageViewer::ensureAlignedInputs()
+{
+    if (!hasOverlayContent()) {
+        return false;
+    }
 
-    QPixmap overlayPixmap = QPixmap::fromImage(qImage.copy());
+    // 只有源图或方向变化时才重新对齐，透明度变化直接复用
+    bool valid = !m_alignedImage1.empty()
+                 && m_alignedSource1.data == m_cvImage.data
+                 && m_alignedSource2.data == m_cvImage2.data
+                 && m_alignedOrientation == m_orientation;
+    if (valid) {
+        return true;
+    }
 
-    if (m_pixmapItem) {
-        m_pixmapItem->setPixmap(overlayPixmap);
-        m_scene->setSceneRect(overlayPixmap.rect());
+    // 后台配准、指标计算、差异分析、级别降采样或导出仍在读取旧画布时不能原地复用缓冲区
+    if (m_registrationWatcher->isRunning() || m_metricsWatcher->isRunning() || m_regionsWatcher->isRunning()
+        || m_exportWatcher->isRunning() || m_estimateWatcher->isRunning() || m_alignedLevelWatcher->isRunning()) {
+        m_alignedImage1.release();
+        m_alignedImage2.release();
     }
+    // 预取的配对已按原始方向对齐过时直接采用
+    bool adopted = false;
+    if (m_orientation.isIdentity()) {
+        for (int i = 0; i < m_pairPrefetches.size(); ++i) {
+            if (!m_pairPrefetches[i].future.isFinished()) {
+                continue;
+            }
+            PreparedPair pair = m_pairPrefetches[i].future.result();
+            if (pair.source1.data == m_cvImage.data && pair.source2.data == m_cvImage2.data
+                && !pair.aligned1.empty()) {
+                // 采用后画布会被原地复用，预取结果不能再留给之后匹配
+                m_alignedImage1 = pair.aligned1;
+                m_alignedImage2 = pair.aligned2;
+                m_pairPrefetches.removeAt(i);
+                adopted = true;
+                break;
+            }
+        }
+    }
+    if (!adopted) {
+        alignImages(m_orientation.apply(m_cvImage), m_cvImage2, m_alignedImage1, m_alignedImage2);
+    }
+    m_alignedLevels.clear();
+    ++m_alignedGeneration;
+    // 画布坐标已变化，之前的配准结果不再适用
+    resetRegistration();
+    m_alignedSource1 = m_cvImage;
+    m_alignedSource2 = m_cvImage2;
+    m_alignedOrientation = m_orientation;
+
+    QSize baseSize = m_orientation.mapSize(QSize(m_cvImage.cols, m_cvImage.rows));
+    QRect baseRect(QPoint((m_alignedImage1.cols - baseSize.width()) / 2,
+                          (m_alignedImage1.rows - baseSize.height()) / 2), baseSize);
+    m_layerStack.setGeometry(QSize(m_alignedImage1.cols, m_alignedImage1.rows), baseRect, m_orientation);
+    prepareLayers();
+    return true;
+}
+
+void ImageViewer::invalidateAlignedInputs()
+{
+    m_alignedSource1.release();
+    m_alignedSource2.release();
+    m_alignedImage1.release();
+    m_alignedImage2.release();
+    m_alignedLevels.clear();
+    ++m_alignedGeneration;
+    resetRegistration();
+}
+
+bool ImageViewer::overlaySnapshot(OverlaySnapshot &snapshot)
+{
+    if (!ensureAlignedInputs()) {
+        return false;
+    }
+
+    snapshot.aligned1 = m_alignedImage1;
+    snapshot.aligned2 = m_alignedImage2;
+    snapshot.alpha1 = m_alpha1;
+    snapshot.alpha2 = m_alpha2;
+    snapshot.sampled = hasSamplingTransform();
+    snapshot.sampling = samplingTransform();
+    const ChannelLut *lut = exposureLut();
+    snapshot.hasLut = lut != nullptr;
+    if (lut) {
+        snapshot.lut = *lut;
+    }
+    return true;
+}
+
+cv::Mat ImageViewer::blendOverlay(const OverlaySnapshot &snapshot, const LayerStack &layers, const cv::Rect &roi)
+{
+    cv::Mat blended;
+    cv::Mat image1 = snapshot.aligned1(roi);
+    if (snapshot.aligned2.empty()) {
+        blendBgra(image1, 1.0, image1, 0.0, blended);
+    } else {
+        cv::Mat image2 = snapshot.sampled ? registeredRegion(snapshot.aligned2, snapshot.sampling, roi, 1)
+                                          : snapshot.aligned2(roi);
+        blendBgra(image1, snapshot.alpha1, image2, snapshot.alpha2, blended,
+                  snapshot.hasLut ? &snapshot.lut : nullptr);
+    }
+    layers.composite(blended, roi, 1);
+    return blended;
+}
+
+void ImageViewer::updateOverlay()
+{
+    if (!m_isOverlayMode || !m_pixmapItem || !ensureAlignedInputs()) {
+        return;
+    }
+
+    // 叠加结果不再整幅混合，由瓦片图元只渲染可见区域
+    QSize canvasSize(m_alignedImage1.cols, m_alignedImage1.rows);
+    if (!m_overlayItem) {
+        m_overlayItem = new TiledImageItem(canvasSize);
+        m_overlayItem->setRenderer([this](const QRect &sourceRect, int level) {
+            return renderOverlayTile(sourceRect, level);
+        });
+        m_scene->addItem(m_overlayItem);
+    } else {
+        m_overlayItem->setCanvasSize(canvasSize);
+        m_overlayItem->invalidate();
+    }
+
+    m_overlayItem->setZValue(m_pixmapItem->zValue());
+    m_overlayItem->setVisible(true);
+    m_pixmapItem->setVisible(false);
+    m_scene->setSceneRect(m_overlayItem->sceneBoundingRect());
+    updateCompareDecorations();
+    updateQualityMetrics();
+    if (m_regionHighlight && !regionsUpToDate()) {
+        m_regionHighlight->setVisible(false);
+    }
+}
+
+void ImageViewer::hideOverlayItem()
+{
+    if (m_overlayItem) {
+        m_overlayItem->setVisible(false);
+        m_overlayItem->invalidate();
+    }
+    updateCompareDecorations();
+    updateQualityMetrics();
+    if (m_regionHighlight && !regionsUpToDate()) {
+        m_regionHighlight->setVisible(false);
+    }
+}
+
+bool ImageViewer::isOverlayDisplayed() const
+{
+    return m_overlayItem && m_overlayItem->isVisible();
+}
+
+const ImageViewer::AlignedLevel& ImageViewer::alignedLevel(int level)
+{
+    auto it = m_alignedLevels.find(level);
+    if (it != m_alignedLevels.end()) {
+        return it->second;
+    }
+
+    // 每个缩放级别只降采样一次，之后透明度变化只混合小图。整幅 INTER_AREA 降采样在后台进行，
+    // 完成前从已有的最近较细级别最近邻取样，代价只与该级别的尺寸成正比，不会卡住绘制
+    const AlignedLevel *nearest = nullptr;
+    for (const auto &[builtLevel, built] : m_alignedLevels) {
+        if (builtLevel < level && !built.approximate) {
+            nearest = &built;
+        }
+    }
+    cv::Mat source1 = nearest ? nearest->image1 : m_alignedImage1;
+    cv::Mat source2 = nearest ? nearest->image2 : m_alignedImage2;
+
+    AlignedLevel &entry = m_alignedLevels[level];
+    cv::Size levelSize((m_alignedImage1.cols + level - 1) / level,
+                       (m_alignedImage1.rows + level - 1) / level);
+    cv::resize(source1, entry.image1, levelSize, 0, 0, cv::INTER_NEAREST);
+    if (!source2.empty()) {
+        cv::resize(source2, entry.image2, levelSize, 0, 0, cv::INTER_NEAREST);
+    }
+    entry.approximate = true;
+    requestAlignedLevel(level);
+    return entry;
+}
+
+void ImageViewer::requestAlignedLevel(int level)
+{
+    if (m_alignedLevelWatcher->isRunning()) {
+        // 完成时会继续生成其余仍为近似的级别
+        return;
+    }
+
+    m_pendingAlignedLevel = level;
+    m_pendingAlignedGeneration = m_alignedGeneration;
+    cv::Mat image1 = m_alignedImage1;
+    cv::Mat image2 = m_alignedImage2;
+    m_alignedLevelWatcher->setFuture(QtConcurrent::run([image1, image2, level]() {
+        AlignedLevel entry;
+        cv::Size levelSize((image1.cols + level - 1) / level, (image1.rows + level - 1) / level);
+        cv::resize(image1, entry.image1, levelSize, 0, 0, cv::INTER_AREA);
+        if (!image2.empty()) {
+            cv::resize(image2, entry.image2, levelSize, 0, 0, cv::INTER_AREA);
+        }
+        return entry;
+    }));
+}
+
+void ImageViewer::onAlignedLevelFinished()
+{
+    AlignedLevel entry = m_alignedLevelWatcher->result();
+    if (m_pendingAlignedGeneration == m_alignedGeneration) {
+        auto it = m_alignedLevels.find(m_pendingAlignedLevel);
+        if (it != m_alignedLevels.end() && it->second.approximate) {
+            it->second = entry;
+            // 用近似输入渲染的瓦片全部重绘
+            if (m_overlayItem) {
+                m_overlayItem->invalidate();
+            }
+        }
+    }
+
+    for (const auto &[level, built] : m_alignedLevels) {
+        if (built.approximate) {
+            requestAlignedLevel(level);
+            break;
+        }
+    }
+}
+
+QImage ImageViewer::renderOverlayTile(const QRect &sourceRect, int level)
+{
+    if (!ensureAlignedInputs()) {
+        return QImage();
+    }
+
+    ScopedPerfTimer timer(PerfStats::Blend);
+
+    cv::Mat image1 = m_alignedImage1;
+    cv::Mat image2 = m_alignedImage2;
+    if (level > 1) {
+        const AlignedLevel &entry = alignedLevel(level);
+        image1 = entry.image1;
+        image2 = entry.image2;
+    }
+
+    // 瓦片原点是 level 的整数倍，右下边缘向上取整
+    int x0 = sourceRect.left() / level;
+    int y0 = sourceRect.top() / level;
+    int x1 = qMin(image1.cols, (sourceRect.left() + sourceRect.width() + level - 1) / level);
+    int y1 = qMin(image1.rows, (sourceRect.top() + sourceRect.height() + level - 1) / level);
+    if (x1 <= x0 || y1 <= y0) {
+        return QImage();
+    }
+
+    cv::Rect roi(x0, y0, x1 - x0, y1 - y0);
+    QImage tile(roi.width, roi.height, QImage::Format_RGB32);
+    cv::Mat target = wrapQImage(tile);
+    cv::Mat tile1 = image1(roi);
+    if (image2.empty()) {
+        blendBgra(tile1, 1.0, tile1, 0.0, target);
+        m_layerStack.composite(target, roi, level);
+        return tile;
+    }
+    cv::Mat tile2 = hasSamplingTransform() ? registeredRegion(image2, samplingTransform(), roi, level) : image2(roi);
+
+    // 混合模式在内核中逐行查表，其余模式只对当前瓦片查表
+    const ChannelLut *lut = exposureLut();
+    if (lut && m_compareMode != CompareBlend) {
+        cv::Mat normalized;
+        applyChannelLut(tile2, *lut, normalized);
+        tile2 = normalized;
+    }
+
+    switch (m_compareMode) {
+    case CompareDifference:
+        renderDifference(tile1, tile2, m_differenceGain, m_differenceHeatmap, target);
+        break;
+    case CompareSwipe: {
+        qreal dividerX = m_swipePosition * m_alignedImage1.cols;
+        renderSwipe(tile1, tile2, qRound(dividerX / level) - x0, target);
+        break;
+    }
+    case CompareCheckerboard:
+        renderCheckerboard(tile1, tile2, sourceRect.topLeft(), level, m_checkerSize, target);
+        break;
+    case CompareFlicker:
+        blendBgra(m_flickerShowSecond ? tile2 : tile1, 1.0, tile1, 0.0, target);
+        break;
+    case CompareBlend:
+    default:
+        blendBgra(tile1, m_alpha1, tile2, m_alpha2, target, lut);
+        break;
+    }
+
+    // 附加图层在同一瓦片缓冲区上逐行合成
+    m_layerStack.composite(target, roi, level);
+    return tile;
+}
+
+bool ImageViewer::startRegistration(RegistrationModel model)
+{
+    if (m_registrationWatcher->isRunning() || m_cvImage2.empty() || !ensureAlignedInputs()) {
+        return false;
+    }
+
+    // 记录提交时的输入，完成时若已更换图片或方向则丢弃结果
+    m_pendingRegistrationSource1 = m_alignedImage1;
+    m_pendingRegistrationSource2 = m_alignedImage2;
+    m_registrationCancel = std::make_shared<std::atomic_bool>(false);
+
+    cv::Mat reference = m_alignedImage1;
+    cv::Mat moving = m_alignedImage2;
+    std::shared_ptr<std::atomic_bool> cancel = m_registrationCancel;
+    QPointer<ImageViewer> self(this);
+    m_registrationWatcher->setFuture(QtConcurrent::run([reference, moving, model, cancel, self]() {
+        return registerImages(reference, moving, model, *cancel, [self](int percent) {
+            QMetaObject::invokeMethod(self, [self, percent]() {
+                if (self) {
+                    emit self->registrationProgress(percent);
+                }
+            }, Qt::QueuedConnection);
+        });
+    }));
+    return true;
+}
+
+void ImageViewer::cancelRegistration()
+{
+    if (m_registrationCancel) {
+        m_registrationCancel->store(true);
+    }
+}
+
+void ImageViewer::clearRegistration()
+{
+    cancelRegistration();
+    if (m_hasRegistration) {
+        resetRegistration();
+        refreshOverlayTiles();
+        updateQualityMetrics();
+    }
+}
+
+bool ImageViewer::isRegistering() const
+{
+    return m_registrationWatcher->isRunning();
+}
+
+bool ImageViewer::hasRegistration() const
+{
+    return m_hasRegistration;
+}
+
+void ImageViewer::resetRegistration()
+{
+    if (!m_hasRegistration) {
+        return;
+    }
+    m_hasRegistration = false;
+    m_registration = cv::Matx33d::eye();
+    emit registrationCleared();
+}
+
+void ImageViewer::onRegistrationFinished()
+{
+    RegistrationResult result = m_registrationWatcher->result();
+    bool stale = m_pendingRegistrationSource1.data != m_alignedImage1.data
+                 || m_pendingRegistrationSource2.data != m_alignedImage2.data;
+    m_pendingRegistrationSource1.release();
+    m_pendingRegistrationSource2.release();
+    m_registrationCancel.reset();
+
+    if (stale && !result.cancelled) {
+        emit registrationFinished(false, tr("图片已更换，配准结果已丢弃"));
+        return;
+    }
+
+    if (result.success) {
+        m_registration = result.transform;
+        m_hasRegistration = true;
+        // 自动配准结果取代之前的手动微调
+        if (!m_manualAlignment.isIdentity()) {
+            m_manualAlignment = ManualAlignment();
+            saveManualAlignment();
+            emit manualAlignmentChanged();
+        }
+        refreshOverlayTiles();
+        updateQualityMetrics();
+    }
+    emit registrationFinished(result.success, result.message);
+}
+
+void ImageViewer::setExposureMatchMode(ExposureMatchMode mode)
+{
+    if (m_exposureMode == mode) {
+        return;
+    }
+
+    m_exposureMode = mode;
+    m_exposureLutGeneration = 0;
+    refreshOverlayTiles();
+    updateQualityMetrics();
+}
+
+ExposureMatchMode ImageViewer::exposureMatchMode() const
+{
+    return m_exposureMode;
+}
+
+const ChannelLut* ImageViewer::exposureLut()
+{
+    if (m_exposureMode == ExposureMatchMode::None || m_alignedImage2.empty()) {
+        return nullptr;
+    }
+
+    // 每对输入只统计一次直方图，之后所有瓦片共用同一张查找表
+    if (m_exposureLutGeneration != m_alignedGeneration) {
+        m_exposureLut = computeExposureLut(m_alignedImage1, m_alignedImage2, m_exposureMode);
+        m_exposureLutGeneration = m_alignedGeneration;
+    }
+    return &m_exposureLut;
+}
+
+ComparedImage ImageViewer::comparedImage2()
+{
+    ComparedImage compared;
+    compared.image = m_alignedImage2;
+    compared.registered = hasSamplingTransform();
+    compared.registration = samplingTransform();
+    const ChannelLut *lut = exposureLut();
+    compared.normalized = lut != nullptr;
+    if (lut) {
+        compared.lut = *lut;
+    }
+    return compared;
+}
+
+bool ImageViewer::ManualAlignment::isIdentity() const
+{
+    return dx == 0.0 && dy == 0.0 && angle == 0.0 && scale == 1.0;
+}
+
+void ImageViewer::setManualAlignment(const ManualAlignment &alignment)
+{
+    m_manualAlignment = alignment;
+    m_manualAlignment.scale = qBound(0.01, alignment.scale, 100.0);
+    // 角度折回 (-180, 180]，避免连续微调越过面板输入框的范围
+    m_manualAlignment.angle = std::remainder(alignment.angle, 360.0);
+    if (m_manualAlignment.angle <= -180.0) {
+        m_manualAlignment.angle += 360.0;
+    }
+    emit manualAlignmentChanged();
+
+    // 可见瓦片按显示分辨率重新混合，整图分析等微调停止后再做
+    refreshOverlayTiles();
+    m_alignmentSettleTimer->start();
+}
+
+void ImageViewer::nudgeManualAlignment(double dx, double dy, double angle, double scaleFactor)
+{
+    ManualAlignment alignment = m_manualAlignment;
+    alignment.dx += dx;
+    alignment.dy += dy;
+    alignment.angle += angle;
+    alignment.scale *= scaleFactor;
+    setManualAlignment(alignment);
+}
+
+void ImageViewer::resetManualAlignment()
+{
+    setManualAlignment(ManualAlignment());
+}
+
+ImageViewer::ManualAlignment ImageViewer::manualAlignment() const
+{
+    return m_manualAlignment;
+}
+
+bool ImageViewer::hasSamplingTransform() const
+{
+    return m_hasRegistration || !m_manualAlignment.isIdentity();
+}
+
+cv::Matx33d ImageViewer::samplingTransform() const
+{
+    // 手动对齐 M 把配准后的第二张图片绕画布中心变换到显示位置，
+    // 采样时先取 M 的逆再经配准变换映射到第二张图片
+    cv::Matx33d transform = m_hasRegistration ? m_registration : cv::Matx33d::eye();
+    if (m_manualAlignment.isIdentity()) {
+        return transform;
+    }
+
+    double cx = (m_alignedImage1.cols - 1) * 0.5;
+    double cy = (m_alignedImage1.rows - 1) * 0.5;
+    double radians = qDegreesToRadians(m_manualAlignment.angle);
+    double c = std::cos(radians) * m_manualAlignment.scale;
+    double s = std::sin(radians) * m_manualAlignment.scale;
+    cv::Matx33d toCenter(1, 0, -cx, 0, 1, -cy, 0, 0, 1);
+    cv::Matx33d rotateScale(c, -s, 0, s, c, 0, 0, 0, 1);
+    cv::Matx33d back(1, 0, cx + m_manualAlignment.dx, 0, 1, cy + m_manualAlignment.dy, 0, 0, 1);
+    cv::Matx33d manual = back * rotateScale * toCenter;
+    return transform * manual.inv();
+}
+
+QString ImageViewer::manualAlignmentSettingsKey() const
+{
+    // 以两个目录共同标识一组配对图片
+    QByteArray id = QCryptographicHash::hash((m_currentDirectory + "|" + m_pairedDirectory).toUtf8(),
+                                             QCryptographicHash::Md5).toHex();
+    return "manualAlignment/" + QString::fromLatin1(id);
+}
+
+void ImageViewer::loadManualAlignment()
+{
+    if (m_pairedDirectory.isEmpty()) {
+        return;
+    }
+
+    QVariantList values = m_settings->value(manualAlignmentSettingsKey()).toList();
+    ManualAlignment alignment;
+    if (values.size() == 4) {
+        alignment.dx = values[0].toDouble();
+        alignment.dy = values[1].toDouble();
+        alignment.angle = values[2].toDouble();
+        alignment.scale = values[3].toDouble();
+    }
+    m_manualAlignment = alignment;
+    emit manualAlignmentChanged();
+    refreshOverlayTiles();
+}
+
+void ImageViewer::saveManualAlignment()
+{
+    if (m_pairedDirectory.isEmpty()) {
+        return;
+    }
+
+    if (m_manualAlignment.isIdentity()) {
+        m_settings->remove(manualAlignmentSettingsKey());
+    } else {
+        m_settings->setValue(manualAlignmentSettingsKey(), QVariantList{
+            m_manualAlignment.dx, m_manualAlignment.dy, m_manualAlignment.angle, m_manualAlignment.scale});
+    }
+}
+
+bool ImageViewer::hasOverlayContent() const
+{
+    return !m_cvImage.empty() && (!m_cvImage2.empty() || m_layerStack.count() > 0);
+}
+
+void ImageViewer::invalidateOverlayRect(const QRect &canvasRect)
+{
+    if (isOverlayDisplayed() && !canvasRect.isEmpty()) {
+        m_overlayItem->invalidateRect(canvasRect);
+    }
+}
+
+bool ImageViewer::addLayer(const QString &fileName)
+{
+    if (fileName.isEmpty()) {
+        return false;
+    }
+
+    ImageCache::Entry entry;
+    ImageCache::Status status = ImageCache::instance().load(fileName, entry);
+    if (status == ImageCache::OpenFailed) {
+        QMessageBox::warning(nullptr, tr("错误"), tr("无法打开图片文件: %1").arg(fileName));
+        return false;
+    }
+    if (status == ImageCache::DecodeFailed) {
+        QMessageBox::warning(nullptr, tr("错误"), tr("无法解码图片文件: %1").arg(fileName));
+        return false;
+    }
+
+    int index = m_layerStack.addLayer(fileName, entry.image);
+    emit layersChanged();
+
+    if (!m_isOverlayMode) {
+        return true;
+    }
+    if (isOverlayDisplayed()) {
+        // 对齐数据在后台生成，完成后只重绘受影响的瓦片
+        prepareLayers();
+    } else {
+        updateOverlay();
+    }
+    return true;
+}
+
+void ImageViewer::removeLayer(int index)
+{
+    if (index < 0 || index >= m_layerStack.count()) {
+        return;
+    }
+
+    QRect affected = isOverlayDisplayed() ? m_layerStack.affectedRect(index) : QRect();
+    m_layerStack.removeLayer(index);
+    emit layersChanged();
+
+    if (m_isOverlayMode && !hasOverlayContent() && !m_cvImage.empty()) {
+        showOriginalPixmap();
+    } else {
+        invalidateOverlayRect(affected);
+    }
+}
+
+void ImageViewer::moveLayer(int from, int to)
+{
+    if (from < 0 || from >= m_layerStack.count() || to < 0 || to >= m_layerStack.count() || from == to) {
+        return;
+    }
+
+    // 只有位于两者之间的图层合成顺序发生变化
+    QRect affected;
+    if (isOverlayDisplayed()) {
+        for (int i = qMin(from, to); i <= qMax(from, to); ++i) {
+            affected = affected.united(m_layerStack.affectedRect(i));
+        }
+    }
+    m_layerStack.moveLayer(from, to);
+    emit layersChanged();
+    invalidateOverlayRect(affected);
+}
+
+void ImageViewer::setLayerOpacity(int index, double opacity)
+{
+    if (index < 0 || index >= m_layerStack.count()
+        || m_layerStack.layer(index).opacity == qBound(0.0, opacity, 1.0)) {
+        return;
+    }
+
+    m_layerStack.setOpacity(index, opacity);
+    if (isOverlayDisplayed()) {
+        invalidateOverlayRect(m_layerStack.affectedRect(index));
+    }
+}
+
+void ImageViewer::setLayerBlendMode(int index, LayerBlendMode mode)
+{
+    if (index < 0 || index >= m_layerStack.count() || m_layerStack.layer(index).mode == mode) {
+        return;
+    }
+
+    // 新旧混合方式影响的区域都需要重绘
+    QRect affected = isOverlayDisplayed() ? m_layerStack.affectedRect(index) : QRect();
+    m_layerStack.setBlendMode(index, mode);
+    if (isOverlayDisplayed()) {
+        invalidateOverlayRect(affected.united(m_layerStack.affectedRect(index)));
+    }
+}
+
+void ImageViewer::setLayerVisible(int index, bool visible)
+{
+    if (index < 0 || index >= m_layerStack.count() || m_layerStack.layer(index).visible == visible) {
+        return;
+    }
+
+    m_layerStack.setVisible(index, visible);
+    if (isOverlayDisplayed()) {
+        invalidateOverlayRect(m_layerStack.affectedRect(index));
+    }
+}
+
+const LayerStack& ImageViewer::layerStack() const
+{
+    return m_layerStack;
+}
+
+void ImageViewer::prepareLayers()
+{
+    if (m_layerPrepareWatcher->isRunning()) {
+        // 完成时继续生成下一个图层
+        return;
+    }
+    int index = m_layerStack.firstUnprepared();
+    if (index < 0) {
+        return;
+    }
+
+    m_pendingLayerSource = m_layerStack.layer(index).source;
+    m_pendingLayerOrientation = m_layerStack.orientation();
+    cv::Mat source = m_pendingLayerSource;
+    Orientation orientation = m_pendingLayerOrientation;
+    m_layerPrepareWatcher->setFuture(QtConcurrent::run([source, orientation]() {
+        return LayerStack::prepare(source, orientation);
+    }));
+}
+
+void ImageViewer::onLayerPrepared()
+{
+    int index = m_layerStack.adoptPrepared(m_pendingLayerSource, m_pendingLayerOrientation,
+                                           m_layerPrepareWatcher->result());
+    m_pendingLayerSource.release();
+    if (index >= 0) {
+        invalidateOverlayRect(m_layerStack.affectedRect(index));
+    }
+    prepareLayers();
+}
+
+bool ImageViewer::OverlayInputKey::operator==(const OverlayInputKey &other) const
+{
+    if (alignedGeneration != other.alignedGeneration || registered != other.registered
+        || exposureMode != other.exposureMode) {
+        return false;
+    }
+    return !registered || cv::norm(registration, other.registration, cv::NORM_INF) == 0.0;
+}
+
+ImageViewer::OverlayInputKey ImageViewer::currentOverlayInputKey() const
+{
+    OverlayInputKey key;
+    key.alignedGeneration = m_alignedGeneration;
+    key.registered = hasSamplingTransform();
+    key.registration = samplingTransform();
+    key.exposureMode = m_exposureMode;
+    return key;
+}
+
+void ImageViewer::updateQualityMetrics()
+{
+    // 只有两张图片都在叠加显示时才有意义
+    if (!isOverlayDisplayed() || m_alignedImage2.empty()) {
+        if (!m_metricsGrid.isEmpty()) {
+            m_metricsGrid = MetricsGrid();
+            m_metricsKey = OverlayInputKey();
+            emit qualityMetricsChanged();
+        }
+        return;
+    }
+
+    OverlayInputKey key = currentOverlayInputKey();
+    if (key == m_metricsKey && !m_metricsGrid.isEmpty()) {
+        m_visibleMetricsTimer->start();
+        return;
+    }
+    if (m_metricsWatcher->isRunning()) {
+        // 完成时发现输入已变化会重新计算
+        return;
+    }
+
+    m_metricsGrid = MetricsGrid();
+    m_pendingMetricsKey = key;
+    emit qualityMetricsChanged();
+
+    cv::Mat image1 = m_alignedImage1;
+    ComparedImage compared = comparedImage2();
+    m_metricsWatcher->setFuture(QtConcurrent::run([image1, compared]() {
+        return MetricsGrid::compute(image1, compared);
+    }));
+}
+
+void ImageViewer::onMetricsFinished()
+{
+    MetricsGrid grid = m_metricsWatcher->result();
+    if (m_pendingMetricsKey == currentOverlayInputKey()) {
+        m_metricsGrid = grid;
+        m_metricsKey = m_pendingMetricsKey;
+        emit qualityMetricsChanged();
+    } else {
+        updateQualityMetrics();
+    }
+}
+
+QualityMetrics ImageViewer::wholeImageMetrics() const
+{
+    return m_metricsGrid.summarize();
+}
+
+QualityMetrics ImageViewer::visibleMetrics() const
+{
+    if (m_metricsGrid.isEmpty()) {
+        return QualityMetrics();
+    }
+    // 叠加图元位于场景原点，场景坐标即画布坐标
+    QRect visible = m_view->mapToScene(m_view->viewport()->rect()).boundingRect().toAlignedRect();
+    return m_metricsGrid.summarize(visible);
+}
+
+bool ImageViewer::isComputingMetrics() const
+{
+    return m_metricsWatcher->isRunning();
+}
+
+bool ImageViewer::RegionsRequest::operator==(const RegionsRequest &other) const
+{
+    return key == other.key && threshold == other.threshold && minArea == other.minArea;
+}
+
+ImageViewer::RegionsRequest ImageViewer::currentRegionsRequest() const
+{
+    RegionsRequest request;
+    request.key = currentOverlayInputKey();
+    request.threshold = m_regionThreshold;
+    request.minArea = m_regionMinArea;
+    return request;
+}
+
+bool ImageViewer::regionsUpToDate() const
+{
+    return m_hasRegions && isOverlayDisplayed() && m_regionsRequest == currentRegionsRequest();
+}
+
+void ImageViewer::analyzeChangedRegions(int threshold, int minArea)
+{
+    m_regionThreshold = qBound(0, threshold, 254);
+    m_regionMinArea = qMax(1, minArea);
+
+    if (regionsUpToDate()) {
+        emit changedRegionsUpdated();
+        return;
+    }
+    if (m_regionsWatcher->isRunning()) {
+        // 完成时发现输入或参数已变化会重新检测
+        return;
+    }
+
+    m_hasRegions = false;
+    m_changedRegions.clear();
+    m_currentRegion = -1;
+    if (m_regionHighlight) {
+        m_regionHighlight->setVisible(false);
+    }
+    if (!isOverlayDisplayed() || m_alignedImage2.empty()) {
+        m_pendingRegionStep = 0;
+        emit changedRegionsUpdated();
+        return;
+    }
+
+    m_pendingRegionsRequest = currentRegionsRequest();
+    emit changedRegionsUpdated();
+
+    cv::Mat image1 = m_alignedImage1;
+    ComparedImage compared = comparedImage2();
+    int regionThreshold = m_regionThreshold;
+    int regionMinArea = m_regionMinArea;
+    m_regionsWatcher->setFuture(QtConcurrent::run([=]() {
+        return detectChangedRegions(image1, compared, regionThreshold, regionMinArea);
+    }));
+}
+
+void ImageViewer::onRegionsFinished()
+{
+    std::vector<ChangedRegion> regions = m_regionsWatcher->result();
+    if (!(m_pendingRegionsRequest == currentRegionsRequest()) || !isOverlayDisplayed()) {
+        analyzeChangedRegions(m_regionThreshold, m_regionMinArea);
+        return;
+    }
+
+    m_changedRegions = std::move(regions);
+    m_regionsRequest = m_pendingRegionsRequest;
+    m_hasRegions = true;
+    m_currentRegion = -1;
+    emit changedRegionsUpdated();
+
+    // 检测是由跳转触发时，完成后继续跳转
+    int step = m_pendingRegionStep;
+    m_pendingRegionStep = 0;
+    if (step > 0) {
+        goToNextRegion();
+    } else if (step < 0) {
+        goToPreviousRegion();
+    }
+}
+
+const std::vector<ChangedRegion>& ImageViewer::changedRegions() const
+{
+    return m_changedRegions;
+}
+
+int ImageViewer::currentRegionIndex() const
+{
+    return m_currentRegion;
+}
+
+bool ImageViewer::isAnalyzingRegions() const
+{
+    return m_regionsWatcher->isRunning();
+}
+
+void ImageViewer::goToNextRegion()
+{
+    if (!regionsUpToDate()) {
+        m_pendingRegionStep = 1;
+        analyzeChangedRegions(m_regionThreshold, m_regionMinArea);
+        return;
+    }
+    if (m_changedRegions.empty()) {
+        return;
+    }
+    goToRegion((m_currentRegion + 1) % static_cast<int>(m_changedRegions.size()));
+}
+
+void ImageViewer::goToPreviousRegion()
+{
+    if (!regionsUpToDate()) {
+        m_pendingRegionStep = -1;
+        analyzeChangedRegions(m_regionThreshold, m_regionMinArea);
+        return;
+    }
+    if (m_changedRegions.empty()) {
+        return;
+    }
+    int count = static_cast<int>(m_changedRegions.size());
+    goToRegion(m_currentRegion <= 0 ? count - 1 : m_currentRegion - 1);
+}
+
+void ImageViewer::goToRegion(int index)
+{
+    const QRect &bounds = m_changedRegions[index].bounds;
+    m_currentRegion = index;
+
+    if (!m_regionHighlight) {
+        m_regionHighlight = new QGraphicsRectItem();
+        QPen pen(QColor(255, 64, 64), 2);
+        pen.setCosmetic(true);
+        m_regionHighlight->setPen(pen);
+        m_regionHighlight->setBrush(Qt::NoBrush);
+        m_scene->addItem(m_regionHighlight);
+    }
+    m_regionHighlight->setRect(bounds);
+    m_regionHighlight->setZValue(m_overlayItem->zValue() + 2);
+    m_regionHighlight->setVisible(true);
+
+    // 区域四周留出余量，极小区域的放大倍数不超过缩放上限
+    int margin = qMax(16, qMax(bounds.width(), bounds.height()) / 4);
+    m_view->fitInView(QRectF(bounds.adjusted(-margin, -margin, margin, margin)), Qt::KeepAspectRatio);
+    qreal percent = m_view->zoomPercent();
+    if (percent > 3200) {
+        qreal factor = 3200 / percent;
+        m_view->scale(factor, factor);
+        m_view->centerOn(QRectF(bounds).center());
+    }
+
+    if (m_isFitToWindow) {
+        m_isFitToWindow = false;
+        emit fitToWindowChanged(false);
+    }
+    updateScaleInfo();
+    emit scaleChanged();
+    emit currentRegionChanged(index);
 }
@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QPixmap>
+#include <QImage>
 #include <QGraphicsView>
 #include <QGraphicsScene>
 #include <QGraphicsPixmapItem>
@@ -13,15 +14,48 @@
 #include <QSettings>
 #include <QStringList>
 #include <QTimer>
+#include <QFutureWatcher>
+#include <QPicture>
 #include <opencv2/opencv.hpp>
+#include <map>
+#include <memory>
 
 #include "core/imagegraphicsview.h"
+#include "utils/orientation.h"
+#include "utils/registration.h"
+#include "core/layerstack.h"
+#include "utils/imagemetrics.h"
+#include "utils/changeregions.h"
+#include "utils/exposurematch.h"
+#include "utils/exportencoder.h"
+
+class TiledImageItem;
+class BandWriter;
+class SwipeDividerItem;
 
 class ImageViewer : public QObject
 {
     Q_OBJECT
 
 public:
+    // 叠加模式下两张图片的对比方式
+    enum CompareMode {
+        CompareBlend = 0,
+        CompareDifference,
+        CompareSwipe,
+        CompareCheckerboard,
+        CompareFlicker
+    };
+
+    // 手动微调第二张图片：绕画布中心缩放、旋转后平移，单位为像素和度
+    struct ManualAlignment {
+        double dx = 0.0;
+        double dy = 0.0;
+        double angle = 0.0;
+        double scale = 1.0;
+        bool isIdentity() const;
+    };
+
     explicit ImageViewer(ImageGraphicsView *view, QGraphicsScene *scene, QObject *parent = nullptr);
     
     void setCoordinateLabel(QLabel *label);
@@ -42,8 +76,15 @@ public:
     void rotate180();
     void flipHorizontal();
     void flipVertical();
-    bool exportImage(const QString &fileName);
-    QFuture<bool> exportImageAsync(const QString &fileName);
+    // 后台导出：GUI 线程只快照像素引用和标注的绘制命令，合成、编码和写文件都在工作线程完成；
+    // TIFF/PNG 按行带合成并流式写入文件；普通导出保持源图位深，标注按源图精度合成
+    bool startExport(const QString &fileName, const ExportOptions &options = ExportOptions());
+    void cancelExport();
+    bool isExporting() const;
+    // 在均匀分布的样本行带上试编码，估计导出文件大小和编码耗时；参数连续变化时只保留最新一次请求
+    void requestExportEstimate(const QString &suffix, const ExportOptions &options);
+    // 当前图片是未经像素编辑的 JPEG 且没有标注，导出 JPEG 时可以只改写 EXIF 方向
+    bool canExportJpegLosslessly() const;
     void applyZoom(int percent);
     void updateCoordinates(QPointF scenePos);
     
@@ -51,9 +92,20 @@ public:
     void previousImage();
 
     bool isEnabled() const;
+    QString currentFileName() const;
+    QString secondImageFileName() const;
     QPixmap originalPixmap() const;
+    QImage thumbnail() const;
+    Orientation orientation() const;
+    QTransform sceneToImageTransform() const;
     QGraphicsPixmapItem* pixmapItem() const;
 
+    // 自由旋转：预览只变换可见区域，提交后在后台旋转全分辨率图像
+    void setPreviewRotation(double degrees);
+    void clearRotationPreview();
+    void commitRotation(double degrees);
+    QFuture<double> estimateSkewAsync() const;
+
     void setFitToWindow(bool fit);
     bool isFitToWindow() const;
 
@@ -67,13 +119,68 @@ public:
     bool loadSecondImage(const QString &fileName);
     void clearSecondImage();
 
+    // A/B 配对目录：切换图片时按同名文件自动加载第二张图片，并预取相邻的配对
+    void setPairedDirectory(const QString &directoryPath);
+    QString pairedDirectory() const;
+
 void setAlpha1(double alpha);
     void setAlpha2(double alpha);
     double getAlpha1() const;
     double getAlpha2() const;
 
+    void setCompareMode(CompareMode mode);
+    CompareMode compareMode() const;
+    void setDifferenceGain(double gain);
+    void setDifferenceHeatmap(bool enabled);
+    // 混合与对比前把第二张图片的曝光归一化到第一张
+    void setExposureMatchMode(ExposureMatchMode mode);
+    ExposureMatchMode exposureMatchMode() const;
+    // 分割线位置为画布宽度的比例 0..1
+    void setSwipePosition(double fraction);
+    void setCheckerSize(int size);
+    // 每秒切换次数
+    void setFlickerRate(double rate);
+
+    // 自动配准：后台估计第二张图相对第一张的变换，混合时逐瓦片按逆映射采样。
+    // 返回 false 表示未启动，此时不会发出 registrationFinished
+    bool startRegistration(RegistrationModel model);
+    void cancelRegistration();
+    void clearRegistration();
+    bool isRegistering() const;
+    bool hasRegistration() const;
+
+    // 手动对齐在混合时与自动配准结果组合，只重绘可见瓦片；设置配对目录时按目录组保存
+    void setManualAlignment(const ManualAlignment &alignment);
+    void nudgeManualAlignment(double dx, double dy, double angle, double scaleFactor);
+    void resetManualAlignment();
+    ManualAlignment manualAlignment() const;
+
+    // 附加图层：叠加在对比结果之上，按可见瓦片合成
+    bool addLayer(const QString &fileName);
+    void removeLayer(int index);
+    void moveLayer(int from, int to);
+    void setLayerOpacity(int index, double opacity);
+    void setLayerBlendMode(int index, LayerBlendMode mode);
+    void setLayerVisible(int index, bool visible);
+    const LayerStack& layerStack() const;
+
+    // 画质指标：整图在后台分块并行计算一次，可见区域由瓦片结果累加
+    QualityMetrics wholeImageMetrics() const;
+    QualityMetrics visibleMetrics() const;
+    bool isComputingMetrics() const;
+
+    // 差异区域：按阈值提取连通变化区域，结果缓存到输入或参数变化为止
+    void analyzeChangedRegions(int threshold, int minArea);
+    const std::vector<ChangedRegion>& changedRegions() const;
+    int currentRegionIndex() const;
+    bool isAnalyzingRegions() const;
+    void goToNextRegion();
+    void goToPreviousRegion();
+
 signals:
     void imageLoaded(const QString &fileName);
+    void thumbnailChanged();
+    void orientationChanged();
     void scaleChanged();
     void fitToWindowChanged(bool fit);
     void imageIndexChanged(int currentIndex, int totalCount);
@@ -82,26 +189,148 @@ signals:
     void overlayModeChanged(bool enabled);
     void secondImageLoaded(const QString &fileName);
     void secondImageCleared();
+    void pairedDirectoryChanged(const QString &directoryPath);
+    void rotationCommitted();
+    void swipePositionChanged(double fraction);
+    void registrationProgress(int percent);
+    void registrationFinished(bool success, const QString &message);
+    void registrationCleared();
+    void manualAlignmentChanged();
+    void layersChanged();
+    void qualityMetricsChanged();
+    void changedRegionsUpdated();
+    void currentRegionChanged(int index);
+    void exportProgress(int percent);
+    void exportFinished(bool success, bool cancelled, const QString &fileName);
+    void exportEstimateReady(const ExportEstimate &estimate);
 
 private:
     void updateSizeInfo();
+    void updateSamplingMode();
+    void beginInteractiveResize();
+    void finishInteractiveResize();
     void updatePixmapFromMat();
+    void applyOrientation();
+    void showOriginalPixmap();
+    QGraphicsItem* displayItem() const;
+    QTransform rotationSceneToSource(double degrees) const;
+    void updateRotationPreview();
+    void requestRotationPreviewLevel(int level);
+    void onRotationPreviewLevelFinished();
+    void onRotationFinished();
     void loadImagesFromDirectory(const QString &directoryPath);
     void saveCurrentPosition();
     void loadSavedPosition();
     void updateImageIndexLabel();
 
+    QString pairedPathFor(const QString &fileName) const;
+    void loadPairedImage(const QString &fileName);
+    void prefetchNeighbourPairs();
+    void cancelPairPrefetches();
+
     // Overlay helper functions
-    void alignImages(const cv::Mat &img1, const cv::Mat &img2,
-                     cv::Mat &aligned1, cv::Mat &aligned2);
-    cv::Mat computeOverlay();
+    static void alignImages(const cv::Mat &img1, const cv::Mat &img2,
+                            cv::Mat &aligned1, cv::Mat &aligned2);
+    static void placeCentered(const cv::Mat &image, int width, int height, cv::Mat &canvas);
+    bool ensureAlignedInputs();
+    void invalidateAlignedInputs();
+    struct AlignedLevel {
+        cv::Mat image1;
+        cv::Mat image2;
+        // 后台 INTER_AREA 降采样完成前的最近邻近似
+        bool approximate = false;
+    };
+
+    // 合成叠加结果所需的输入，像素按引用计数共享，图层栈复制后各自维护缓存
+    struct OverlaySnapshot {
+        cv::Mat aligned1;
+        cv::Mat aligned2;
+        double alpha1 = 1.0;
+        double alpha2 = 0.0;
+        bool sampled = false;
+        cv::Matx33d sampling = cv::Matx33d::eye();
+        bool hasLut = false;
+        ChannelLut lut;
+    };
+    struct ExportSnapshot {
+        bool overlay = false;
+        OverlaySnapshot inputs;
+        LayerStack layers;
+        cv::Mat image;
+        Orientation orientation;
+        bool hasAnnotations = false;
+        QPicture annotations;
+        // 像素与源文件一致时记录源文件，JPEG 方向导出可直接改写它
+        QString sourceFileName;
+    };
+    bool overlaySnapshot(OverlaySnapshot &snapshot);
+    static cv::Mat blendOverlay(const OverlaySnapshot &snapshot, const LayerStack &layers, const cv::Rect &roi);
+    bool isAnnotationItem(const QGraphicsItem *item) const;
+    bool snapshotAnnotations(QPicture &picture) const;
+    enum class ExportStatus {
+        Succeeded,
+        Failed,
+        Cancelled
+    };
+    // 每个行带约 32MB（按 BGRA 计），与图像宽度无关地限制导出时的内存占用
+    static constexpr qint64 kExportBandBytes = 32LL * 1024 * 1024;
+    // 样本行带的总像素数，足以代表整幅图像的压缩率又能在后台很快完成
+    static constexpr qint64 kEstimatePixels = 2LL * 1024 * 1024;
+    static constexpr int kEstimateSamples = 8;
+    bool exportSnapshot(ExportSnapshot &snapshot);
+    static QSize exportSize(const ExportSnapshot &snapshot);
+    static int exportPixelType(const ExportSnapshot &snapshot, const QString &suffix,
+                               std::unique_ptr<BandWriter> &writer);
+    static cv::Mat toExportType(const cv::Mat &band, int type);
+    static ExportStatus runExport(ExportSnapshot &snapshot, const QString &fileName, const ExportOptions &options,
+                                  const std::atomic_bool &cancel, const std::function<void(int)> &progress);
+    static ExportEstimate estimateExport(ExportSnapshot &snapshot, const QString &suffix,
+                                         const ExportOptions &options);
+    static cv::Mat renderExportBand(ExportSnapshot &snapshot, int y0, int y1);
+    static bool writeEncoded(const cv::Mat &image, const QString &fileName, const ExportOptions &options);
+    static bool rewriteJpegSource(const ExportSnapshot &snapshot, const QString &suffix,
+                                  const ExportOptions &options, QByteArray &data);
+    bool hasAnnotationItems() const;
+    void onExportFinished();
+    void launchExportEstimate();
+    void onEstimateFinished();
     void updateOverlay();
+    void hideOverlayItem();
+    bool isOverlayDisplayed() const;
+    const AlignedLevel& alignedLevel(int level);
+    void requestAlignedLevel(int level);
+    void onAlignedLevelFinished();
+    void prepareLayers();
+    void onLayerPrepared();
+    QImage renderOverlayTile(const QRect &sourceRect, int level);
+    void refreshOverlayTiles();
+    void updateCompareDecorations();
+    const ChannelLut* exposureLut();
+    // 后台分析使用的第二张图片：只记录配准变换与曝光查找表，按瓦片或行带应用
+    ComparedImage comparedImage2();
+    void onRegistrationFinished();
+    void resetRegistration();
+    bool hasSamplingTransform() const;
+    cv::Matx33d samplingTransform() const;
+    QString manualAlignmentSettingsKey() const;
+    void loadManualAlignment();
+    void saveManualAlignment();
+    bool hasOverlayContent() const;
+    void invalidateOverlayRect(const QRect &canvasRect);
+    void updateQualityMetrics();
+    void onMetricsFinished();
+    void onRegionsFinished();
+    void goToRegion(int index);
 
     ImageGraphicsView *m_view;
     QGraphicsScene *m_scene;
     QGraphicsPixmapItem *m_pixmapItem;
     QPixmap m_originalPixmap;
     cv::Mat m_cvImage;
+    // m_cvImage 仍是源文件的解码结果（没有提交过自由旋转）
+    bool m_pixelsMatchFile;
+    QImage m_thumbnail;
+    Orientation m_orientation;
 
     QLabel *m_coordinateLabel;
     QLabel *m_scaleLabel;
@@ -114,6 +343,7 @@ private:
     bool m_isFitToWindow;
     qint64 m_fileSize;
 
+    QString m_currentFileName;
     QStringList m_imageList;
     int m_currentImageIndex;
     QString m_currentDirectory;
@@ -128,8 +358,139 @@ private:
     double m_alpha1;
     double m_alpha2;
 
-    cv::Mat m_overlayResult;
-    QTimer *m_overlayUpdateTimer;
+    // 配对目录与预取：相邻配对在后台解码并对齐，切换到该配对时直接采用
+    struct PreparedPair {
+        QString fileName1;
+        QString fileName2;
+        cv::Mat source1;
+        cv::Mat source2;
+        cv::Mat aligned1;
+        cv::Mat aligned2;
+    };
+    // 每个相邻配对至多一个在途任务；离开相邻位置的任务通过 cancel 尽早结束
+    struct PairPrefetch {
+        QString fileName1;
+        QString fileName2;
+        bool align = false;
+        std::shared_ptr<std::atomic_bool> cancel;
+        QFuture<PreparedPair> future;
+    };
+    QString m_pairedDirectory;
+    QList<PairPrefetch> m_pairPrefetches;
+
+    // 对齐后的叠加输入，只在源图或方向变化时重建
+    cv::Mat m_alignedImage1;
+    cv::Mat m_alignedImage2;
+    cv::Mat m_alignedSource1;
+    cv::Mat m_alignedSource2;
+    Orientation m_alignedOrientation;
+    // 对齐输入每次重建或释放时递增；画布可能原地复用，不能用数据指针判断是否变化
+    quint64 m_alignedGeneration;
+
+    // 各缩放级别的降采样对齐输入，按需在后台生成
+    std::map<int, AlignedLevel> m_alignedLevels;
+    QFutureWatcher<AlignedLevel> *m_alignedLevelWatcher;
+    int m_pendingAlignedLevel;
+    quint64 m_pendingAlignedGeneration;
+    TiledImageItem *m_overlayItem;
+
+    // 对比模式参数
+    CompareMode m_compareMode;
+    double m_differenceGain;
+    bool m_differenceHeatmap;
+    double m_swipePosition;
+    int m_checkerSize;
+    SwipeDividerItem *m_swipeDivider;
+    QTimer *m_flickerTimer;
+    bool m_flickerShowSecond;
+
+    // 曝光归一化查找表，由对齐输入的降采样直方图计算，输入变化后重算
+    ExposureMatchMode m_exposureMode;
+    ChannelLut m_exposureLut;
+    quint64 m_exposureLutGeneration;
+
+    // 自动配准结果：对齐画布上图 1 坐标 -> 图 2 坐标，只在渲染瓦片时应用
+    cv::Matx33d m_registration;
+    bool m_hasRegistration;
+    QFutureWatcher<RegistrationResult> *m_registrationWatcher;
+    std::shared_ptr<std::atomic_bool> m_registrationCancel;
+    cv::Mat m_pendingRegistrationSource1;
+    cv::Mat m_pendingRegistrationSource2;
+
+    ManualAlignment m_manualAlignment;
+    // 微调停止后才保存设置并重新计算整图分析
+    QTimer *m_alignmentSettleTimer;
+
+    LayerStack m_layerStack;
+    // 图层对齐数据逐个在后台生成
+    QFutureWatcher<std::shared_ptr<const LayerStack::Prepared>> *m_layerPrepareWatcher;
+    cv::Mat m_pendingLayerSource;
+    Orientation m_pendingLayerOrientation;
+
+    // 对比分析所基于的输入，指标与差异区域都在输入变化后重新计算
+    struct OverlayInputKey {
+        quint64 alignedGeneration = 0;
+        bool registered = false;
+        cv::Matx33d registration = cv::Matx33d::eye();
+        ExposureMatchMode exposureMode = ExposureMatchMode::None;
+        bool operator==(const OverlayInputKey &other) const;
+    };
+    OverlayInputKey currentOverlayInputKey() const;
+
+    MetricsGrid m_metricsGrid;
+    OverlayInputKey m_metricsKey;
+    OverlayInputKey m_pendingMetricsKey;
+    QFutureWatcher<MetricsGrid> *m_metricsWatcher;
+    QTimer *m_visibleMetricsTimer;
+
+    // 差异区域列表及其对应的输入和参数
+    struct RegionsRequest {
+        OverlayInputKey key;
+        int threshold = 0;
+        int minArea = 0;
+        bool operator==(const RegionsRequest &other) const;
+    };
+    RegionsRequest currentRegionsRequest() const;
+    bool regionsUpToDate() const;
+    std::vector<ChangedRegion> m_changedRegions;
+    bool m_hasRegions;
+    RegionsRequest m_regionsRequest;
+    RegionsRequest m_pendingRegionsRequest;
+    int m_regionThreshold;
+    int m_regionMinArea;
+    int m_currentRegion;
+    int m_pendingRegionStep;
+    QFutureWatcher<std::vector<ChangedRegion>> *m_regionsWatcher;
+    QGraphicsRectItem *m_regionHighlight;
+
+    QFutureWatcher<ExportStatus> *m_exportWatcher;
+    std::shared_ptr<std::atomic_bool> m_exportCancel;
+    QString m_exportFileName;
+
+    // 导出估计：运行期间到达的新请求只记录参数，完成后再以最新参数重算
+    QFutureWatcher<ExportEstimate> *m_estimateWatcher;
+    QString m_estimateSuffix;
+    ExportOptions m_estimateOptions;
+    bool m_estimateQueued;
+
+    // 窗口缩放防抖：拖动期间显示按显示分辨率缓存的帧
+    QTimer *m_resizeSettleTimer;
+    QGraphicsPixmapItem *m_resizeProxyItem;
+    bool m_isInteractiveResize;
+
+    // 自由旋转预览与后台全分辨率旋转
+    bool m_isRotationPreview;
+    double m_previewAngle;
+    QTimer *m_rotationPreviewTimer;
+    QGraphicsPixmapItem *m_rotationPreviewItem;
+    cv::Mat m_rotationPreviewSource;
+    int m_rotationPreviewLevel;
+    QFutureWatcher<cv::Mat> *m_rotationLevelWatcher;
+    cv::Mat m_pendingRotationLevelSource;
+    int m_pendingRotationLevel;
+    QFutureWatcher<cv::Mat> *m_rotationWatcher;
+    cv::Mat m_pendingRotationSource;
+    Orientation m_pendingRotationOrientation;
 };
 
 #endif // IMAGEVIEWER_H
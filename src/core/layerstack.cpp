@@ -0,0 +1,282 @@
+#include "layerstack.h"
+#include "utils/matconvert.h"
+
+#include <QRectF>
+#include <QtGlobal>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+// 金字塔缩小到长边不超过该值为止
+constexpr int kMinPyramidSize = 64;
+
+QRect boundingRectOf(const cv::Mat &mask)
+{
+    cv::Rect rect = cv::boundingRect(mask);
+    return QRect(rect.x, rect.y, rect.width, rect.height);
+}
+
+} // namespace
+
+int LayerStack::count() const
+{
+    return static_cast<int>(m_layers.size());
+}
+
+const LayerStack::Layer& LayerStack::layer(int index) const
+{
+    return m_layers[index];
+}
+
+int LayerStack::addLayer(const QString &fileName, const cv::Mat &image)
+{
+    Layer layer;
+    layer.fileName = fileName;
+    layer.source = image;
+    m_layers.push_back(layer);
+    m_prepared.emplace_back();
+    return count() - 1;
+}
+
+void LayerStack::removeLayer(int index)
+{
+    if (index < 0 || index >= count()) {
+        return;
+    }
+    m_layers.erase(m_layers.begin() + index);
+    m_prepared.erase(m_prepared.begin() + index);
+}
+
+void LayerStack::moveLayer(int from, int to)
+{
+    if (from < 0 || from >= count() || to < 0 || to >= count() || from == to) {
+        return;
+    }
+    Layer layer = std::move(m_layers[from]);
+    std::shared_ptr<const Prepared> prepared = std::move(m_prepared[from]);
+    m_layers.erase(m_layers.begin() + from);
+    m_prepared.erase(m_prepared.begin() + from);
+    m_layers.insert(m_layers.begin() + to, std::move(layer));
+    m_prepared.insert(m_prepared.begin() + to, std::move(prepared));
+}
+
+void LayerStack::clear()
+{
+    m_layers.clear();
+    m_prepared.clear();
+}
+
+void LayerStack::setOpacity(int index, double opacity)
+{
+    if (index >= 0 && index < count()) {
+        m_layers[index].opacity = qBound(0.0, opacity, 1.0);
+    }
+}
+
+void LayerStack::setBlendMode(int index, LayerBlendMode mode)
+{
+    if (index >= 0 && index < count()) {
+        m_layers[index].mode = mode;
+    }
+}
+
+void LayerStack::setVisible(int index, bool visible)
+{
+    if (index >= 0 && index < count()) {
+        m_layers[index].visible = visible;
+    }
+}
+
+void LayerStack::setGeometry(const QSize &canvasSize, const QRect &baseRect, const Orientation &orientation)
+{
+    m_canvasSize = canvasSize;
+    m_baseRect = baseRect;
+    if (orientation == m_orientation) {
+        return;
+    }
+    // 放置区域在合成时换算，只有方向变化才需要重新生成
+    m_orientation = orientation;
+    for (std::shared_ptr<const Prepared> &prepared : m_prepared) {
+        prepared.reset();
+    }
+}
+
+Orientation LayerStack::orientation() const
+{
+    return m_orientation;
+}
+
+std::shared_ptr<const LayerStack::Prepared> LayerStack::prepare(const cv::Mat &source, const Orientation &orientation)
+{
+    auto prepared = std::make_shared<Prepared>();
+    cv::Mat oriented = toDisplayDepth(orientation.apply(source));
+    cv::Mat bgra;
+    if (oriented.channels() == 1) {
+        cv::cvtColor(oriented, bgra, cv::COLOR_GRAY2BGRA);
+    } else if (oriented.channels() == 3) {
+        cv::cvtColor(oriented, bgra, cv::COLOR_BGR2BGRA);
+    } else {
+        bgra = oriented;
+    }
+
+    std::vector<cv::Mat> channels;
+    cv::split(bgra, channels);
+    cv::Mat opaque = channels[3] > 0;
+    cv::Mat maxChannel = cv::max(cv::max(channels[0], channels[1]), channels[2]);
+    cv::Mat minChannel = cv::min(cv::min(channels[0], channels[1]), channels[2]);
+    prepared->opaqueRect = boundingRectOf(opaque);
+    prepared->nonBlackRect = boundingRectOf(opaque & (maxChannel > 0));
+    prepared->nonWhiteRect = boundingRectOf(opaque & (minChannel < 255));
+
+    // 缩小显示时从不小于目标分辨率的最粗一层取样，避免混叠
+    prepared->pyramid.push_back(bgra);
+    while (std::max(prepared->pyramid.back().cols, prepared->pyramid.back().rows) > kMinPyramidSize) {
+        const cv::Mat &finer = prepared->pyramid.back();
+        cv::Mat coarser;
+        cv::resize(finer, coarser, cv::Size((finer.cols + 1) / 2, (finer.rows + 1) / 2), 0, 0, cv::INTER_AREA);
+        prepared->pyramid.push_back(coarser);
+    }
+    return prepared;
+}
+
+int LayerStack::firstUnprepared() const
+{
+    for (int i = 0; i < count(); ++i) {
+        if (!m_prepared[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int LayerStack::adoptPrepared(const cv::Mat &source, const Orientation &orientation,
+                              const std::shared_ptr<const Prepared> &prepared)
+{
+    if (!prepared || orientation != m_orientation) {
+        return -1;
+    }
+    // 生成期间图层可能被移动，按源像素找回
+    for (int i = 0; i < count(); ++i) {
+        if (!m_prepared[i] && m_layers[i].source.data == source.data) {
+            m_prepared[i] = prepared;
+            return i;
+        }
+    }
+    return -1;
+}
+
+void LayerStack::prepareAll()
+{
+    for (int i = 0; i < count(); ++i) {
+        if (!m_prepared[i]) {
+            m_prepared[i] = prepare(m_layers[i].source, m_orientation);
+        }
+    }
+}
+
+QRect LayerStack::affectedRect(int index) const
+{
+    if (index < 0 || index >= count() || !m_prepared[index]) {
+        return QRect();
+    }
+    // 普通混合只受 alpha 影响；正片叠底中白色、滤色/相加/差值中黑色不改变底图
+    const Prepared &prepared = *m_prepared[index];
+    switch (m_layers[index].mode) {
+    case LayerBlendMode::Multiply:
+        return toCanvas(prepared.nonWhiteRect, prepared);
+    case LayerBlendMode::Screen:
+    case LayerBlendMode::Additive:
+    case LayerBlendMode::Difference:
+        return toCanvas(prepared.nonBlackRect, prepared);
+    case LayerBlendMode::Normal:
+    default:
+        return toCanvas(prepared.opaqueRect, prepared);
+    }
+}
+
+bool LayerStack::hasVisibleLayers() const
+{
+    for (const Layer &layer : m_layers) {
+        if (layer.visible && layer.opacity > 0.0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void LayerStack::composite(cv::Mat &target, const cv::Rect &roi, int level) const
+{
+    const QRect canvasRoi(roi.x * level, roi.y * level, roi.width * level, roi.height * level);
+    std::vector<LayerTile> tiles;
+    for (int i = 0; i < count(); ++i) {
+        const Layer &layer = m_layers[i];
+        if (!layer.visible || layer.opacity <= 0.0 || !m_prepared[i]
+            || !affectedRect(i).intersects(canvasRoi)) {
+            continue;
+        }
+        cv::Mat tile = placedTile(*m_prepared[i], roi, level);
+        if (!tile.empty()) {
+            tiles.push_back({tile, layer.opacity, layer.mode});
+        }
+    }
+    compositeLayers(target, tiles);
+}
+
+cv::Mat LayerStack::placedTile(const Prepared &prepared, const cv::Rect &roi, int level) const
+{
+    if (m_baseRect.isEmpty()) {
+        return cv::Mat();
+    }
+
+    // 每个目标像素覆盖 level 个画布像素，选取每像素跨度不超过它的最粗金字塔层
+    const cv::Mat &base = prepared.pyramid.front();
+    double span = static_cast<double>(level) * base.cols / m_baseRect.width();
+    size_t index = 0;
+    while (index + 1 < prepared.pyramid.size() && span >= 2.0) {
+        span *= 0.5;
+        ++index;
+    }
+    const cv::Mat &source = prepared.pyramid[index];
+
+    // 只有像素中心落在放置区域内的目标像素取样，区域外保持透明
+    auto insideRange = [level](int baseStart, int baseEnd, int roiStart, int roiLength, int &first, int &last) {
+        first = qBound(0, static_cast<int>(std::ceil(static_cast<double>(baseStart) / level - 0.5)) - roiStart,
+                       roiLength);
+        last = qBound(0, static_cast<int>(std::ceil(static_cast<double>(baseEnd) / level - 0.5)) - roiStart,
+                      roiLength);
+    };
+    int x0, x1, y0, y1;
+    insideRange(m_baseRect.left(), m_baseRect.left() + m_baseRect.width(), roi.x, roi.width, x0, x1);
+    insideRange(m_baseRect.top(), m_baseRect.top() + m_baseRect.height(), roi.y, roi.height, y0, y1);
+    if (x1 <= x0 || y1 <= y0) {
+        return cv::Mat();
+    }
+
+    // 目标像素中心 -> 画布 -> 金字塔层像素中心；边缘复制，避免与区域外的透明像素插值而变淡
+    const double ax = static_cast<double>(source.cols) / m_baseRect.width();
+    const double ay = static_cast<double>(source.rows) / m_baseRect.height();
+    cv::Matx23d dstToSrc(ax * level, 0, ((roi.x + x0 + 0.5) * level - m_baseRect.left()) * ax - 0.5,
+                         0, ay * level, ((roi.y + y0 + 0.5) * level - m_baseRect.top()) * ay - 0.5);
+
+    cv::Mat tile = cv::Mat::zeros(roi.height, roi.width, CV_8UC4);
+    cv::Mat inside = tile(cv::Rect(x0, y0, x1 - x0, y1 - y0));
+    cv::warpAffine(source, inside, dstToSrc, inside.size(), cv::INTER_LINEAR | cv::WARP_INVERSE_MAP,
+                   cv::BORDER_REPLICATE);
+    return tile;
+}
+
+QRect LayerStack::toCanvas(const QRect &layerRect, const Prepared &prepared) const
+{
+    const cv::Mat &base = prepared.pyramid.front();
+    if (layerRect.isEmpty() || m_baseRect.isEmpty()) {
+        return QRect();
+    }
+    const double sx = static_cast<double>(m_baseRect.width()) / base.cols;
+    const double sy = static_cast<double>(m_baseRect.height()) / base.rows;
+    QRectF mapped(m_baseRect.left() + layerRect.left() * sx, m_baseRect.top() + layerRect.top() * sy,
+                  layerRect.width() * sx, layerRect.height() * sy);
+    // 双线性取样会向外扩散约一个像素
+    return mapped.toAlignedRect().adjusted(-1, -1, 1, 1) & QRect(QPoint(0, 0), m_canvasSize);
+}
@@ -0,0 +1,85 @@
+#ifndef LAYERSTACK_H
+#define LAYERSTACK_H
+
+#include <QRect>
+#include <QString>
+#include <memory>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "utils/layerblend.h"
+#include "utils/orientation.h"
+
+/**
+ * @brief 叠加模式中位于对比结果之上的附加图层（掩膜、热图、边缘图等）
+ *
+ * 图层与第一张图片同源：随其方向一起旋转/翻转，并缩放到第一张图片在对齐画布中的区域。
+ * 每个图层只按自身尺寸保存方向变换后的金字塔，放置位置由画布中的区域换算；
+ * 合成时只对目标瓦片取样，不生成整幅画布大小的副本。
+ */
+class LayerStack
+{
+public:
+    struct Layer {
+        QString fileName;
+        cv::Mat source;
+        double opacity = 1.0;
+        LayerBlendMode mode = LayerBlendMode::Normal;
+        bool visible = true;
+    };
+
+    // 按图层自身尺寸生成的对齐数据，生成后只读，可在线程间共享
+    struct Prepared {
+        std::vector<cv::Mat> pyramid;   // 第 0 层为按方向变换后的 BGRA 图层，逐层减半
+        QRect opaqueRect;               // 图层坐标：alpha 非零
+        QRect nonBlackRect;             // 图层坐标：alpha 非零且颜色非黑
+        QRect nonWhiteRect;             // 图层坐标：alpha 非零且颜色非白
+    };
+
+    int count() const;
+    const Layer& layer(int index) const;
+
+    // 返回新图层的序号，新图层位于最上方
+    int addLayer(const QString &fileName, const cv::Mat &image);
+    void removeLayer(int index);
+    void moveLayer(int from, int to);
+    void clear();
+
+    void setOpacity(int index, double opacity);
+    void setBlendMode(int index, LayerBlendMode mode);
+    void setVisible(int index, bool visible);
+
+    // 画布尺寸、第一张图片所在区域或方向变化；只有方向变化时才丢弃对齐数据
+    void setGeometry(const QSize &canvasSize, const QRect &baseRect, const Orientation &orientation);
+    Orientation orientation() const;
+
+    // 在任意线程上为 source 生成对齐数据，只处理图层自身尺寸的像素
+    static std::shared_ptr<const Prepared> prepare(const cv::Mat &source, const Orientation &orientation);
+    // 第一个尚未生成对齐数据的图层，没有时返回 -1
+    int firstUnprepared() const;
+    // 采用后台生成的对齐数据；图层已被移除或方向已变化时返回 -1，否则返回图层序号
+    int adoptPrepared(const cv::Mat &source, const Orientation &orientation,
+                      const std::shared_ptr<const Prepared> &prepared);
+    // 同步生成全部缺失的对齐数据，供工作线程上的导出使用
+    void prepareAll();
+
+    // 图层在当前混合方式下实际改变画面的画布区域，用于只重绘受影响的瓦片；尚未生成时为空
+    QRect affectedRect(int index) const;
+
+    bool hasVisibleLayers() const;
+
+    // 把已生成对齐数据的可见图层合成到 target 上；roi 为第 level 级降采样坐标
+    void composite(cv::Mat &target, const cv::Rect &roi, int level) const;
+
+private:
+    cv::Mat placedTile(const Prepared &prepared, const cv::Rect &roi, int level) const;
+    QRect toCanvas(const QRect &layerRect, const Prepared &prepared) const;
+
+    std::vector<Layer> m_layers;
+    std::vector<std::shared_ptr<const Prepared>> m_prepared;
+    QSize m_canvasSize;
+    QRect m_baseRect;
+    Orientation m_orientation;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "swipedivideritem.h"
+
+#include <QPainter>
+#include <QGraphicsSceneMouseEvent>
+#include <QCursor>
+
+namespace {
+
+// 屏幕像素下的可拖动半宽与手柄半径
+constexpr qreal kGrabHalfWidth = 6.0;
+constexpr qreal kHandleRadius = 8.0;
+
+} // namespace
+
+SwipeDividerItem::SwipeDividerItem(QGraphicsItem *parent)
+    : QGraphicsObject(parent)
+    , m_viewScale(1.0)
+{
+    setCursor(Qt::SplitHCursor);
+    setAcceptedMouseButtons(Qt::LeftButton);
+}
+
+void SwipeDividerItem::setCanvasSize(const QSizeF &canvasSize)
+{
+    prepareGeometryChange();
+    m_canvasSize = canvasSize;
+    setDividerX(qBound(qreal(0), pos().x(), m_canvasSize.width()));
+}
+
+void SwipeDividerItem::setDividerX(qreal x)
+{
+    setPos(x, 0);
+}
+
+qreal SwipeDividerItem::dividerX() const
+{
+    return pos().x();
+}
+
+void SwipeDividerItem::setViewScale(qreal scale)
+{
+    if (scale <= 0 || qFuzzyCompare(scale, m_viewScale)) {
+        return;
+    }
+    prepareGeometryChange();
+    m_viewScale = scale;
+}
+
+qreal SwipeDividerItem::halfGrabWidth() const
+{
+    return qMax(kGrabHalfWidth, kHandleRadius) / m_viewScale;
+}
+
+QRectF SwipeDividerItem::boundingRect() const
+{
+    qreal half = halfGrabWidth();
+    return QRectF(-half, 0, half * 2, m_canvasSize.height());
+}
+
+void SwipeDividerItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+
+    QPen pen(Qt::white, 2);
+    pen.setCosmetic(true);
+    painter->setPen(pen);
+    painter->drawLine(QPointF(0, 0), QPointF(0, m_canvasSize.height()));
+
+    // 画布中部的圆形手柄
+    qreal radius = kHandleRadius / m_viewScale;
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setBrush(QColor(0, 120, 215));
+    painter->drawEllipse(QPointF(0, m_canvasSize.height() / 2), radius, radius);
+}
+
+void SwipeDividerItem::mousePressEvent(QGraphicsSceneMouseEvent *event)
+{
+    // 接受按下事件以获得后续移动事件，同时阻止视图开始拖动画布
+    event->accept();
+}
+
+void SwipeDividerItem::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
+{
+    qreal x = qBound(qreal(0), event->scenePos().x(), m_canvasSize.width());
+    if (x != dividerX()) {
+        setDividerX(x);
+        emit dividerMoved(x);
+    }
+}
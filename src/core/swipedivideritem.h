@@ -0,0 +1,42 @@
+#ifndef SWIPEDIVIDERITEM_H
+#define SWIPEDIVIDERITEM_H
+
+#include <QGraphicsObject>
+
+/**
+ * @brief 卷帘对比模式的分割线
+ *
+ * 竖线贯穿整个画布高度，可水平拖动。拖动时发出画布坐标下的新位置。
+ */
+class SwipeDividerItem : public QGraphicsObject
+{
+    Q_OBJECT
+
+public:
+    explicit SwipeDividerItem(QGraphicsItem *parent = nullptr);
+
+    void setCanvasSize(const QSizeF &canvasSize);
+    void setDividerX(qreal x);
+    qreal dividerX() const;
+
+    // 视图缩放变化时更新，使可拖动区域在屏幕上保持固定宽度
+    void setViewScale(qreal scale);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = nullptr) override;
+
+signals:
+    void dividerMoved(qreal x);
+
+protected:
+    void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
+    void mouseMoveEvent(QGraphicsSceneMouseEvent *event) override;
+
+private:
+    qreal halfGrabWidth() const;
+
+    QSizeF m_canvasSize;
+    qreal m_viewScale;
+};
+
+#endif
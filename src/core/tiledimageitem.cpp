@@ -0,0 +1,160 @@
+#include "tiledimageitem.h"
+#include "utils/matconvert.h"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QtMath>
+
+TiledImageItem::TiledImageItem(const QSize &canvasSize, QGraphicsItem *parent)
+    : QGraphicsItem(parent)
+    , m_canvasSize(canvasSize)
+{
+    // 需要精确的 exposedRect 才能只渲染可见瓦片
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    // 缓存上限按 KB 计，约 128 MB
+    m_tiles.setMaxCost(128 * 1024);
+}
+
+void TiledImageItem::setCanvasSize(const QSize &canvasSize)
+{
+    if (m_canvasSize == canvasSize) {
+        return;
+    }
+    prepareGeometryChange();
+    m_canvasSize = canvasSize;
+    m_tiles.clear();
+}
+
+QSize TiledImageItem::canvasSize() const
+{
+    return m_canvasSize;
+}
+
+void TiledImageItem::setRenderer(const TileRenderer &renderer)
+{
+    m_renderer = renderer;
+    invalidate();
+}
+
+void TiledImageItem::invalidate()
+{
+    m_tiles.clear();
+    update();
+}
+
+void TiledImageItem::invalidateRect(const QRect &canvasRect)
+{
+    const QList<quint64> keys = m_tiles.keys();
+    for (quint64 key : keys) {
+        int level = static_cast<int>(key >> 48);
+        int tx = static_cast<int>((key >> 24) & 0xFFFFFF);
+        int ty = static_cast<int>(key & 0xFFFFFF);
+        int span = kTileSize * level;
+        if (QRect(tx * span, ty * span, span, span).intersects(canvasRect)) {
+            m_tiles.remove(key);
+        }
+    }
+    update(QRectF(canvasRect));
+}
+
+QRectF TiledImageItem::boundingRect() const
+{
+    return QRectF(QPointF(0, 0), QSizeF(m_canvasSize));
+}
+
+int TiledImageItem::levelForScale(qreal deviceScale)
+{
+    // 取不超过 1 / deviceScale 的最大 2 的幂，瓦片分辨率不低于显示分辨率
+    int level = 1;
+    while (level < 64 && deviceScale * level * 2 <= 1.0) {
+        level *= 2;
+    }
+    return level;
+}
+
+quint64 TiledImageItem::tileKey(int level, int tx, int ty)
+{
+    return (static_cast<quint64>(level) << 48)
+         | (static_cast<quint64>(tx & 0xFFFFFF) << 24)
+         | static_cast<quint64>(ty & 0xFFFFFF);
+}
+
+void TiledImageItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+
+    if (!m_renderer || m_canvasSize.isEmpty()) {
+        return;
+    }
+
+    QRectF exposed = option->exposedRect.intersected(boundingRect());
+    if (exposed.isEmpty()) {
+        return;
+    }
+
+    // 设备变换已包含视图缩放与设备像素比，旋转时 m12 承载缩放分量
+    QTransform device = painter->deviceTransform();
+    qreal deviceScale = qSqrt(device.m11() * device.m11() + device.m12() * device.m12());
+    if (deviceScale <= 0) {
+        return;
+    }
+
+    int level = levelForScale(deviceScale);
+    int span = kTileSize * level;
+    qreal residualScale = deviceScale * level;
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, !qFuzzyCompare(residualScale, 1.0));
+
+    int firstX = qMax(0, static_cast<int>(exposed.left()) / span);
+    int firstY = qMax(0, static_cast<int>(exposed.top()) / span);
+    int lastX = static_cast<int>(qCeil(exposed.right())) / span;
+    int lastY = static_cast<int>(qCeil(exposed.bottom())) / span;
+    QRect canvasRect(QPoint(0, 0), m_canvasSize);
+
+    for (int ty = firstY; ty <= lastY; ++ty) {
+        for (int tx = firstX; tx <= lastX; ++tx) {
+            QRect tileRect = QRect(tx * span, ty * span, span, span).intersected(canvasRect);
+            if (tileRect.isEmpty()) {
+                continue;
+            }
+
+            quint64 key = tileKey(level, tx, ty);
+            QImage *tile = m_tiles.object(key);
+            if (!tile) {
+                QImage rendered = m_renderer(tileRect, level);
+                if (rendered.isNull()) {
+                    continue;
+                }
+                tile = new QImage(rendered);
+                int cost = qMax(1, static_cast<int>(tile->sizeInBytes() / 1024));
+                if (!m_tiles.insert(key, tile, cost)) {
+                    // 超出缓存上限时 insert 已删除 tile，直接绘制本次结果
+                    painter->drawImage(QRectF(tileRect), rendered);
+                    continue;
+                }
+            }
+            painter->drawImage(QRectF(tileRect), *tile);
+        }
+    }
+}
+
+QImage TiledImageItem::renderMatTile(const cv::Mat &image, const QRect &sourceRect, int level)
+{
+    if (image.empty()) {
+        return QImage();
+    }
+
+    cv::Rect roi(sourceRect.x(), sourceRect.y(), sourceRect.width(), sourceRect.height());
+    roi &= cv::Rect(0, 0, image.cols, image.rows);
+    if (roi.empty()) {
+        return QImage();
+    }
+
+    cv::Mat region = image(roi);
+    if (level > 1) {
+        cv::Size scaledSize((roi.width + level - 1) / level, (roi.height + level - 1) / level);
+        cv::Mat scaled;
+        cv::resize(region, scaled, scaledSize, 0, 0, cv::INTER_AREA);
+        return cvMatToQImage(scaled);
+    }
+    return cvMatToQImage(region);
+}
@@ -0,0 +1,54 @@
+#ifndef TILEDIMAGEITEM_H
+#define TILEDIMAGEITEM_H
+
+#include <QGraphicsItem>
+#include <QCache>
+#include <QImage>
+#include <QRect>
+#include <QSize>
+#include <functional>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief 按需渲染可见瓦片的图像项
+ *
+ * 不持有整图像素，只在绘制时按当前显示分辨率渲染可见区域的瓦片并缓存。
+ * level 为 2 的幂降采样倍数，瓦片覆盖 kTileSize * level 个画布像素。
+ */
+class TiledImageItem : public QGraphicsItem
+{
+public:
+    // sourceRect 为画布坐标，返回尺寸约为 sourceRect.size() / level 的图像
+    using TileRenderer = std::function<QImage(const QRect &sourceRect, int level)>;
+
+    explicit TiledImageItem(const QSize &canvasSize = QSize(), QGraphicsItem *parent = nullptr);
+
+    void setCanvasSize(const QSize &canvasSize);
+    QSize canvasSize() const;
+
+    void setRenderer(const TileRenderer &renderer);
+
+    // 清除全部瓦片缓存并重绘
+    void invalidate();
+    // 只清除与 canvasRect 相交的瓦片
+    void invalidateRect(const QRect &canvasRect);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = nullptr) override;
+
+    // 从 cv::Mat 中截取 sourceRect 并降采样 level 倍
+    static QImage renderMatTile(const cv::Mat &image, const QRect &sourceRect, int level);
+
+    static int levelForScale(qreal deviceScale);
+
+    static constexpr int kTileSize = 256;
+
+private:
+    static quint64 tileKey(int level, int tx, int ty);
+
+    QSize m_canvasSize;
+    TileRenderer m_renderer;
+    QCache<quint64, QImage> m_tiles;
+};
+
+#endif
@@ -0,0 +1,262 @@
+#include "compareview.h"
+
+#include <QGraphicsScene>
+#include <QGridLayout>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QComboBox>
+#include <QLabel>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QMessageBox>
+
+#include "core/imagegraphicsview.h"
+#include "core/imagecache.h"
+#include "core/tiledimageitem.h"
+
+CompareView::CompareView(QWidget *parent)
+    : QWidget(parent)
+    , m_grid(nullptr)
+    , m_layoutCombo(nullptr)
+    , m_layoutMode(Layout1x2)
+    , m_syncing(false)
+{
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+    mainLayout->setContentsMargins(0, 0, 0, 0);
+    mainLayout->setSpacing(2);
+
+    QHBoxLayout *topLayout = new QHBoxLayout();
+    topLayout->setContentsMargins(6, 4, 6, 0);
+    topLayout->addWidget(new QLabel("布局:"));
+    m_layoutCombo = new QComboBox();
+    m_layoutCombo->addItem("1x2", Layout1x2);
+    m_layoutCombo->addItem("2x2", Layout2x2);
+    topLayout->addWidget(m_layoutCombo);
+    QPushButton *fitButton = new QPushButton("适应窗口");
+    topLayout->addWidget(fitButton);
+    topLayout->addStretch();
+    mainLayout->addLayout(topLayout);
+
+    m_grid = new QGridLayout();
+    m_grid->setContentsMargins(0, 0, 0, 0);
+    m_grid->setSpacing(2);
+    mainLayout->addLayout(m_grid, 1);
+
+    m_panes.resize(kMaxPanes);
+    for (int i = 0; i < kMaxPanes; ++i) {
+        createPane(i);
+    }
+
+    connect(m_layoutCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        setLayoutMode(static_cast<LayoutMode>(m_layoutCombo->itemData(index).toInt()));
+    });
+    connect(fitButton, &QPushButton::clicked, this, &CompareView::fitAll);
+
+    relayout();
+}
+
+void CompareView::createPane(int index)
+{
+    Pane &pane = m_panes[index];
+
+    pane.container = new QWidget(this);
+    QVBoxLayout *layout = new QVBoxLayout(pane.container);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(0);
+
+    QHBoxLayout *headerLayout = new QHBoxLayout();
+    headerLayout->setContentsMargins(6, 2, 6, 2);
+    pane.titleLabel = new QLabel(tr("窗格 %1: 未加载").arg(index + 1));
+    pane.openButton = new QPushButton("打开");
+    headerLayout->addWidget(pane.titleLabel, 1);
+    headerLayout->addWidget(pane.openButton);
+    layout->addLayout(headerLayout);
+
+    pane.scene = new QGraphicsScene(pane.container);
+    pane.view = new ImageGraphicsView(pane.container);
+    pane.view->setScene(pane.scene);
+    pane.view->setResizeAnchor(QGraphicsView::AnchorViewCenter);
+    pane.view->setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
+    layout->addWidget(pane.view, 1);
+
+    pane.item = new TiledImageItem();
+    pane.scene->addItem(pane.item);
+
+    connect(pane.openButton, &QPushButton::clicked, this, [this, index]() {
+        openPaneImage(index);
+    });
+    connect(pane.view->horizontalScrollBar(), &QScrollBar::valueChanged, this, [this, index]() {
+        syncFrom(index);
+    });
+    connect(pane.view->verticalScrollBar(), &QScrollBar::valueChanged, this, [this, index]() {
+        syncFrom(index);
+    });
+    connect(pane.view, &ImageGraphicsView::scaleChanged, this, [this, index]() {
+        syncFrom(index);
+    });
+    connect(pane.view, &ImageGraphicsView::mouseMoved, this, [this, index](QPointF scenePos) {
+        updateSharedCrosshair(index, scenePos);
+    });
+    connect(pane.view, &ImageGraphicsView::mouseLeft, this, [this, index]() {
+        clearSharedCrosshair(index);
+    });
+}
+
+void CompareView::setLayoutMode(LayoutMode mode)
+{
+    m_layoutMode = mode;
+    int comboIndex = m_layoutCombo->findData(mode);
+    if (comboIndex >= 0 && comboIndex != m_layoutCombo->currentIndex()) {
+        m_layoutCombo->blockSignals(true);
+        m_layoutCombo->setCurrentIndex(comboIndex);
+        m_layoutCombo->blockSignals(false);
+    }
+    relayout();
+}
+
+CompareView::LayoutMode CompareView::layoutMode() const
+{
+    return m_layoutMode;
+}
+
+int CompareView::visiblePaneCount() const
+{
+    return m_layoutMode == Layout2x2 ? 4 : 2;
+}
+
+void CompareView::relayout()
+{
+    for (const Pane &pane : m_panes) {
+        m_grid->removeWidget(pane.container);
+    }
+
+    int count = visiblePaneCount();
+    for (int i = 0; i < kMaxPanes; ++i) {
+        Pane &pane = m_panes[i];
+        if (i < count) {
+            m_grid->addWidget(pane.container, i / 2, i % 2);
+            pane.container->show();
+        } else {
+            pane.container->hide();
+        }
+    }
+}
+
+bool CompareView::setPaneImage(int index, const QString &fileName)
+{
+    if (index < 0 || index >= kMaxPanes || fileName.isEmpty()) {
+        return false;
+    }
+
+    // 与主视图共用解码缓存，cv::Mat 按引用计数共享像素数据
+    ImageCache::Entry entry;
+    ImageCache::Status status = ImageCache::instance().load(fileName, entry);
+    if (status != ImageCache::Loaded) {
+        QMessageBox::warning(this, tr("错误"), tr("无法打开图片文件: %1").arg(fileName));
+        return false;
+    }
+
+    Pane &pane = m_panes[index];
+    pane.image = entry.image;
+    pane.fileName = fileName;
+    pane.titleLabel->setText(tr("窗格 %1: %2").arg(index + 1).arg(QFileInfo(fileName).fileName()));
+
+    cv::Mat image = pane.image;
+    pane.item->setCanvasSize(QSize(image.cols, image.rows));
+    pane.item->setRenderer([image](const QRect &sourceRect, int level) {
+        return TiledImageItem::renderMatTile(image, sourceRect, level);
+    });
+    pane.scene->setSceneRect(pane.item->boundingRect());
+
+    // 以第一个已加载的窗格为准，新窗格跟随其视图
+    int reference = -1;
+    for (int i = 0; i < kMaxPanes; ++i) {
+        if (i != index && !m_panes[i].image.empty()) {
+            reference = i;
+            break;
+        }
+    }
+    if (reference >= 0) {
+        syncFrom(reference);
+    } else {
+        pane.view->fitInView(pane.item, Qt::KeepAspectRatio);
+        syncFrom(index);
+    }
+    return true;
+}
+
+QString CompareView::paneImage(int index) const
+{
+    if (index < 0 || index >= kMaxPanes) {
+        return QString();
+    }
+    return m_panes[index].fileName;
+}
+
+void CompareView::fitAll()
+{
+    for (int i = 0; i < kMaxPanes; ++i) {
+        if (!m_panes[i].image.empty()) {
+            m_panes[i].view->fitInView(m_panes[i].item, Qt::KeepAspectRatio);
+            syncFrom(i);
+            return;
+        }
+    }
+}
+
+void CompareView::openPaneImage(int index)
+{
+    QString fileName = QFileDialog::getOpenFileName(
+        this,
+        tr("打开图片"),
+        QString(),
+        tr("图片文件 (*.png *.jpg *.jpeg *.bmp *.tiff *.tif *.webp);;所有文件 (*.*)")
+    );
+
+    if (!fileName.isEmpty()) {
+        setPaneImage(index, fileName);
+    }
+}
+
+void CompareView::syncFrom(int index)
+{
+    if (m_syncing) {
+        return;
+    }
+    m_syncing = true;
+
+    ImageGraphicsView *source = m_panes[index].view;
+    QTransform transform = source->transform();
+    QPointF center = source->mapToScene(source->viewport()->rect().center());
+
+    for (int i = 0; i < kMaxPanes; ++i) {
+        if (i == index || m_panes[i].image.empty()) {
+            continue;
+        }
+        ImageGraphicsView *target = m_panes[i].view;
+        target->setTransform(transform);
+        target->centerOn(center);
+    }
+
+    m_syncing = false;
+}
+
+void CompareView::updateSharedCrosshair(int sourceIndex, const QPointF &scenePos)
+{
+    for (int i = 0; i < kMaxPanes; ++i) {
+        if (i != sourceIndex) {
+            m_panes[i].view->setSharedCrosshair(scenePos);
+        }
+    }
+}
+
+void CompareView::clearSharedCrosshair(int sourceIndex)
+{
+    for (int i = 0; i < kMaxPanes; ++i) {
+        if (i != sourceIndex) {
+            m_panes[i].view->clearSharedCrosshair();
+        }
+    }
+}
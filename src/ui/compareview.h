@@ -0,0 +1,72 @@
+#ifndef COMPAREVIEW_H
+#define COMPAREVIEW_H
+
+#include <QWidget>
+#include <QVector>
+#include <QString>
+#include <QPointF>
+#include <opencv2/opencv.hpp>
+
+class QGraphicsScene;
+class QGridLayout;
+class QComboBox;
+class QLabel;
+class QPushButton;
+class ImageGraphicsView;
+class TiledImageItem;
+
+/**
+ * @brief 多窗格同步对比视图 (1x2 / 2x2)
+ *
+ * 各窗格共享解码缓存中的图像数据，只按需渲染可见瓦片，
+ * 缩放、平移和十字线在所有窗格间同步。
+ */
+class CompareView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    enum LayoutMode {
+        Layout1x2 = 0,
+        Layout2x2
+    };
+
+    explicit CompareView(QWidget *parent = nullptr);
+
+    void setLayoutMode(LayoutMode mode);
+    LayoutMode layoutMode() const;
+
+    bool setPaneImage(int index, const QString &fileName);
+    QString paneImage(int index) const;
+    void fitAll();
+
+    static constexpr int kMaxPanes = 4;
+
+private:
+    struct Pane {
+        QWidget *container = nullptr;
+        QLabel *titleLabel = nullptr;
+        QPushButton *openButton = nullptr;
+        ImageGraphicsView *view = nullptr;
+        QGraphicsScene *scene = nullptr;
+        TiledImageItem *item = nullptr;
+        cv::Mat image;
+        QString fileName;
+    };
+
+    void createPane(int index);
+    void relayout();
+    int visiblePaneCount() const;
+    void openPaneImage(int index);
+    void syncFrom(int index);
+    void updateSharedCrosshair(int sourceIndex, const QPointF &scenePos);
+    void clearSharedCrosshair(int sourceIndex);
+
+    QVector<Pane> m_panes;
+    QGridLayout *m_grid;
+    QComboBox *m_layoutCombo;
+    LayoutMode m_layoutMode;
+    bool m_syncing;
+};
+
+#endif
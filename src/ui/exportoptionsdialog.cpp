@@ -0,0 +1,166 @@
+#include "exportoptionsdialog.h"
+
+#include <QVBoxLayout>
+#include <QFormLayout>
+#include <QDialogButtonBox>
+#include <QSpinBox>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QLabel>
+#include <QTimer>
+#include <QSettings>
+#include <QLocale>
+
+#include "core/imageviewer.h"
+
+ExportOptionsDialog::ExportOptionsDialog(ImageViewer *viewer, const QString &suffix, QWidget *parent)
+    : QDialog(parent)
+    , m_viewer(viewer)
+    , m_suffix(suffix.toLower())
+    , m_jpegQuality(new QSpinBox(this))
+    , m_jpegLossless(new QCheckBox(tr("只改写 EXIF 方向（无损，不重新编码）"), this))
+    , m_pngCompression(new QSpinBox(this))
+    , m_webpQuality(new QSpinBox(this))
+    , m_webpLossless(new QCheckBox(tr("无损"), this))
+    , m_tiffCompression(new QComboBox(this))
+    , m_estimateLabel(new QLabel(this))
+    , m_estimateTimer(new QTimer(this))
+{
+    setWindowTitle(tr("导出选项"));
+
+    m_jpegQuality->setRange(0, 100);
+    m_pngCompression->setRange(0, 9);
+    m_webpQuality->setRange(1, 100);
+    m_tiffCompression->addItem(tr("Deflate"), static_cast<int>(TiffCompression::Deflate));
+    m_tiffCompression->addItem(tr("不压缩"), static_cast<int>(TiffCompression::None));
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    QFormLayout *form = new QFormLayout();
+    if (m_suffix == "jpg" || m_suffix == "jpeg") {
+        form->addRow(tr("质量:"), m_jpegQuality);
+        // 只做了旋转/翻转的 JPEG 源图可以直接复制源文件
+        if (m_viewer->canExportJpegLosslessly()) {
+            form->addRow(QString(), m_jpegLossless);
+        }
+    } else if (m_suffix == "png") {
+        m_pngCompression->setToolTip(tr("0 最快，9 文件最小"));
+        form->addRow(tr("压缩级别:"), m_pngCompression);
+    } else if (m_suffix == "webp") {
+        form->addRow(tr("质量:"), m_webpQuality);
+        form->addRow(QString(), m_webpLossless);
+    } else if (m_suffix == "tif" || m_suffix == "tiff") {
+        form->addRow(tr("压缩:"), m_tiffCompression);
+    } else {
+        form->addRow(new QLabel(tr("该格式没有可调整的编码参数"), this));
+    }
+    // 其他格式的控件不显示，只用于原样保存这些格式的参数
+    const QList<QWidget *> editors = {m_jpegQuality, m_jpegLossless, m_pngCompression, m_webpQuality,
+                                      m_webpLossless, m_tiffCompression};
+    for (QWidget *editor : editors) {
+        if (form->indexOf(editor) < 0) {
+            editor->hide();
+        }
+    }
+    layout->addLayout(form);
+
+    m_estimateLabel->setText(tr("正在估计..."));
+    layout->addWidget(m_estimateLabel);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
+    layout->addWidget(buttons);
+    connect(buttons, &QDialogButtonBox::accepted, this, &ExportOptionsDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, this, &ExportOptionsDialog::reject);
+
+    loadOptions();
+
+    m_estimateTimer->setSingleShot(true);
+    m_estimateTimer->setInterval(150);
+    connect(m_estimateTimer, &QTimer::timeout, this, [this]() {
+        m_viewer->requestExportEstimate(m_suffix, options());
+    });
+    connect(m_jpegQuality, &QSpinBox::valueChanged, this, &ExportOptionsDialog::scheduleEstimate);
+    connect(m_jpegLossless, &QCheckBox::toggled, this, [this](bool lossless) {
+        m_jpegQuality->setEnabled(!lossless || m_jpegLossless->isHidden());
+        scheduleEstimate();
+    });
+    connect(m_pngCompression, &QSpinBox::valueChanged, this, &ExportOptionsDialog::scheduleEstimate);
+    connect(m_webpQuality, &QSpinBox::valueChanged, this, &ExportOptionsDialog::scheduleEstimate);
+    connect(m_webpLossless, &QCheckBox::toggled, this, [this](bool lossless) {
+        m_webpQuality->setEnabled(!lossless);
+        scheduleEstimate();
+    });
+    connect(m_tiffCompression, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &ExportOptionsDialog::scheduleEstimate);
+    connect(m_viewer, &ImageViewer::exportEstimateReady, this, &ExportOptionsDialog::onEstimateReady);
+
+    m_jpegQuality->setEnabled(!m_jpegLossless->isChecked() || m_jpegLossless->isHidden());
+    m_webpQuality->setEnabled(!m_webpLossless->isChecked());
+    m_viewer->requestExportEstimate(m_suffix, options());
+}
+
+ExportOptions ExportOptionsDialog::options() const
+{
+    ExportOptions options;
+    options.jpegQuality = m_jpegQuality->value();
+    options.jpegLosslessOrientation = m_jpegLossless->isChecked();
+    options.pngCompression = m_pngCompression->value();
+    options.webpQuality = m_webpQuality->value();
+    options.webpLossless = m_webpLossless->isChecked();
+    options.tiffCompression = static_cast<TiffCompression>(m_tiffCompression->currentData().toInt());
+    return options;
+}
+
+void ExportOptionsDialog::accept()
+{
+    saveOptions();
+    QDialog::accept();
+}
+
+void ExportOptionsDialog::loadOptions()
+{
+    ExportOptions defaults;
+    QSettings settings("ZivImageViewer", "ImageViewer");
+    settings.beginGroup("Export");
+    m_jpegQuality->setValue(settings.value("jpegQuality", defaults.jpegQuality).toInt());
+    m_jpegLossless->setChecked(settings.value("jpegLosslessOrientation", defaults.jpegLosslessOrientation).toBool());
+    m_pngCompression->setValue(settings.value("pngCompression", defaults.pngCompression).toInt());
+    m_webpQuality->setValue(settings.value("webpQuality", defaults.webpQuality).toInt());
+    m_webpLossless->setChecked(settings.value("webpLossless", defaults.webpLossless).toBool());
+    int tiff = settings.value("tiffCompression", static_cast<int>(defaults.tiffCompression)).toInt();
+    m_tiffCompression->setCurrentIndex(qMax(0, m_tiffCompression->findData(tiff)));
+    settings.endGroup();
+}
+
+void ExportOptionsDialog::saveOptions() const
+{
+    ExportOptions current = options();
+    QSettings settings("ZivImageViewer", "ImageViewer");
+    settings.beginGroup("Export");
+    settings.setValue("jpegQuality", current.jpegQuality);
+    settings.setValue("jpegLosslessOrientation", current.jpegLosslessOrientation);
+    settings.setValue("pngCompression", current.pngCompression);
+    settings.setValue("webpQuality", current.webpQuality);
+    settings.setValue("webpLossless", current.webpLossless);
+    settings.setValue("tiffCompression", static_cast<int>(current.tiffCompression));
+    settings.endGroup();
+}
+
+void ExportOptionsDialog::scheduleEstimate()
+{
+    m_estimateLabel->setText(tr("正在估计..."));
+    m_estimateTimer->start();
+}
+
+void ExportOptionsDialog::onEstimateReady(const ExportEstimate &estimate)
+{
+    if (m_estimateTimer->isActive()) {
+        return;
+    }
+    if (!estimate.valid) {
+        m_estimateLabel->setText(tr("无法估计导出大小"));
+        return;
+    }
+    m_estimateLabel->setText(tr("预计大小: %1，编码约 %2 秒")
+                             .arg(QLocale().formattedDataSize(estimate.bytes))
+                             .arg(estimate.seconds, 0, 'f', estimate.seconds < 10.0 ? 1 : 0));
+}
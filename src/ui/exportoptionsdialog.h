@@ -0,0 +1,52 @@
+#ifndef EXPORTOPTIONSDIALOG_H
+#define EXPORTOPTIONSDIALOG_H
+
+#include <QDialog>
+#include <QString>
+
+#include "utils/exportencoder.h"
+
+class QSpinBox;
+class QCheckBox;
+class QComboBox;
+class QLabel;
+class QTimer;
+class ImageViewer;
+
+/**
+ * @brief 导出编码参数对话框
+ *
+ * 只显示当前格式适用的参数；参数变化后由 ImageViewer 在后台对样本行带试编码，
+ * 显示预计的文件大小和编码耗时。确认后的参数保存到设置中作为下次的默认值。
+ */
+class ExportOptionsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    ExportOptionsDialog(ImageViewer *viewer, const QString &suffix, QWidget *parent = nullptr);
+
+    ExportOptions options() const;
+
+    void accept() override;
+
+private:
+    void loadOptions();
+    void saveOptions() const;
+    void scheduleEstimate();
+    void onEstimateReady(const ExportEstimate &estimate);
+
+    ImageViewer *m_viewer;
+    QString m_suffix;
+    QSpinBox *m_jpegQuality;
+    QCheckBox *m_jpegLossless;
+    QSpinBox *m_pngCompression;
+    QSpinBox *m_webpQuality;
+    QCheckBox *m_webpLossless;
+    QComboBox *m_tiffCompression;
+    QLabel *m_estimateLabel;
+    // 连续拖动数值时合并为一次估计请求
+    QTimer *m_estimateTimer;
+};
+
+#endif
@@ -13,9 +13,7 @@
 #include <QIcon>
 #include <QHBoxLayout>
 #include <QProgressDialog>
-#include <QThread>
 #include <QtConcurrent>
-#include <QCoreApplication>
 #include <QMap>
 #include <QGuiApplication>
 #include <QShortcut>
@@ -24,6 +22,17 @@
 #include <QStackedWidget>
 #include <QGroupBox>
 #include <QFrame>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QDoubleSpinBox>
+#include <QSignalBlocker>
+#include <QScrollBar>
+#include <QFutureWatcher>
+#include <QProgressBar>
+#include <QListWidget>
+#include <QDir>
+#include <QFileInfo>
+#include <cmath>
 
 #include "core/imagegraphicsview.h"
 #include "core/imageviewer.h"
@@ -31,11 +40,17 @@
 #include "core/anglemeasurementtool.h"
 #include "core/colorpickertool.h"
 #include "core/brushtool.h"
+#include "core/deskewtool.h"
+#include "ui/navigatorwidget.h"
+#include "ui/compareview.h"
+#include "ui/exportoptionsdialog.h"
 #include "utils/panelstyle.h"
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
+    , m_centralStack(nullptr)
     , m_graphicsView(nullptr)
+    , m_compareView(nullptr)
     , m_graphicsScene(nullptr)
     , m_coordinateIconLabel(nullptr)
     , m_coordinateLabel(nullptr)
@@ -46,10 +61,14 @@ MainWindow::MainWindow(QWidget *parent)
     , m_angleAction(nullptr)
     , m_colorPickerAction(nullptr)
     , m_brushAction(nullptr)
+    , m_deskewAction(nullptr)
+    , m_perfHudAction(nullptr)
+    , m_compareViewAction(nullptr)
     , m_imageViewer(nullptr)
     , m_measurementTool(nullptr)
     , m_colorPickerTool(nullptr)
     , m_brushTool(nullptr)
+    , m_deskewTool(nullptr)
     , m_zoomSlider(nullptr)
     , m_zoomSpinBox(nullptr)
     , m_isDarkTheme(false)
@@ -60,6 +79,8 @@ MainWindow::MainWindow(QWidget *parent)
     , m_toolsDock(nullptr)
     , m_toolsPanel(nullptr)
     , m_toolsStack(nullptr)
+    , m_navigatorDock(nullptr)
+    , m_navigator(nullptr)
     , m_image2PathLabel(nullptr)
     , m_loadImage2Button(nullptr)
     , m_clearImage2Button(nullptr)
@@ -69,7 +90,15 @@ MainWindow::MainWindow(QWidget *parent)
     , m_alpha2Label(nullptr)
     , m_alpha2Slider(nullptr)
     , m_alpha2SpinBox(nullptr)
+    , m_compareModeCombo(nullptr)
+    , m_compareOptionsStack(nullptr)
+    , m_swipeSlider(nullptr)
+    , m_layerList(nullptr)
+    , m_layerOpacitySlider(nullptr)
+    , m_layerBlendCombo(nullptr)
+    , m_layerOptions(nullptr)
     , m_overlaySettingsPanel(nullptr)
+    , m_exportProgressDialog(nullptr)
 {
     m_isDarkTheme = isSystemDarkTheme();
 
@@ -91,6 +120,7 @@ MainWindow::~MainWindow()
     delete m_angleMeasurementTool;
     delete m_colorPickerTool;
     delete m_brushTool;
+    delete m_deskewTool;
 }
 
 void MainWindow::openFile(const QString &fileName)
@@ -122,17 +152,24 @@ void MainWindow::setupUI()
     m_graphicsView->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
     m_graphicsView->setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
     
-    centralLayout->addWidget(m_graphicsView);
+    // 多窗格对比视图与主视图共用中央区域
+    m_compareView = new CompareView(this);
+    m_centralStack = new QStackedWidget(this);
+    m_centralStack->addWidget(m_graphicsView);
+    m_centralStack->addWidget(m_compareView);
+    centralLayout->addWidget(m_centralStack);
     
     // 创建工具
     m_measurementTool = new MeasurementTool(m_graphicsScene, m_graphicsView, this);
     m_angleMeasurementTool = new AngleMeasurementTool(m_graphicsScene, m_graphicsView, this);
     m_colorPickerTool = new ColorPickerTool(m_graphicsScene, m_graphicsView, this);
     m_brushTool = new BrushTool(m_graphicsScene, m_graphicsView, this);
+    m_deskewTool = new DeskewTool(this);
     m_colorPickerTool->updateTheme(m_isDarkTheme);
     m_measurementTool->updateTheme(m_isDarkTheme);
     m_angleMeasurementTool->updateTheme(m_isDarkTheme);
     m_brushTool->updateTheme(m_isDarkTheme);
+    m_deskewTool->updateTheme(m_isDarkTheme);
     
     // 创建右侧工具栏 DockWidget (放在上方)
     m_toolsBarDock = new QDockWidget("", this);
@@ -194,6 +231,8 @@ void MainWindow::setupUI()
     // 创建叠加控制面板（也放在工具面板中）
     createOverlayControlPanel();
     m_toolsStack->addWidget(m_overlaySettingsPanel);
+    // 添加自由旋转面板
+    m_toolsStack->addWidget(m_deskewTool->getInfoPanel());
     
     toolsLayout->addWidget(m_toolsStack);
     toolsLayout->addStretch();
@@ -211,6 +250,17 @@ void MainWindow::setupUI()
     // 默认显示测量工具面板（但不激活测量模式）
     m_toolsStack->setCurrentIndex(0);
     
+    // 导航器 (默认隐藏，放在工具面板下方)
+    m_navigatorDock = new QDockWidget("导航器", this);
+    m_navigatorDock->setObjectName("navigatorDock");
+    m_navigatorDock->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+    m_navigatorDock->setFeatures(QDockWidget::DockWidgetClosable | QDockWidget::DockWidgetMovable | QDockWidget::DockWidgetFloatable);
+    m_navigator = new NavigatorWidget();
+    m_navigatorDock->setWidget(m_navigator);
+    addDockWidget(Qt::RightDockWidgetArea, m_navigatorDock);
+    splitDockWidget(m_toolsDock, m_navigatorDock, Qt::Vertical);
+    m_navigatorDock->setVisible(false);
+    
     // 状态栏
     m_coordinateIconLabel = new QLabel(this);
     m_coordinateIconLabel->setFixedSize(20, 20);
@@ -357,6 +407,40 @@ void MainWindow::setupActions()
     viewMenu->addSeparator();
     viewMenu->addAction(m_fitToWindowAction);
     viewMenu->addAction(originalSizeAction);
+    viewMenu->addSeparator();
+    
+    m_compareViewAction = new QAction("对比视图", this);
+    m_compareViewAction->setCheckable(true);
+    m_compareViewAction->setShortcut(tr("Ctrl+K"));
+    viewMenu->addAction(m_compareViewAction);
+    
+    QAction *navigatorAction = m_navigatorDock->toggleViewAction();
+    navigatorAction->setText("导航器");
+    navigatorAction->setShortcut(tr("Ctrl+N"));
+    viewMenu->addAction(navigatorAction);
+    
+    QAction *previousRegionAction = new QAction("上一处差异", this);
+    previousRegionAction->setShortcut(tr("Shift+F8"));
+    viewMenu->addAction(previousRegionAction);
+    connect(previousRegionAction, &QAction::triggered, this, [this]() {
+        if (m_imageViewer->isOverlayMode()) {
+            m_imageViewer->goToPreviousRegion();
+        }
+    });
+    
+    QAction *nextRegionAction = new QAction("下一处差异", this);
+    nextRegionAction->setShortcut(Qt::Key_F8);
+    viewMenu->addAction(nextRegionAction);
+    connect(nextRegionAction, &QAction::triggered, this, [this]() {
+        if (m_imageViewer->isOverlayMode()) {
+            m_imageViewer->goToNextRegion();
+        }
+    });
+    
+    m_perfHudAction = new QAction("性能监视", this);
+    m_perfHudAction->setCheckable(true);
+    m_perfHudAction->setShortcut(Qt::Key_F12);
+    viewMenu->addAction(m_perfHudAction);
     
     // === 工具操作 ===
     m_measureAction = new QAction("测量", this);
@@ -389,11 +473,16 @@ void MainWindow::setupActions()
     m_brushAction->setShortcut(tr("Ctrl+B"));
     m_iconActions["brush"] = m_brushAction;
     
+    m_deskewAction = new QAction("自由旋转", this);
+    m_deskewAction->setCheckable(true);
+    m_deskewAction->setShortcut(tr("Ctrl+D"));
+    
     toolsMenu->addAction(m_measureAction);
     toolsMenu->addAction(m_angleAction);
     toolsMenu->addAction(m_colorPickerAction);
     toolsMenu->addAction(m_brushAction);
     toolsMenu->addAction(m_overlayModeAction);
+    toolsMenu->addAction(m_deskewAction);
     
     // === 左侧工具栏 (文件和视图操作) ===
     QToolBar *leftToolBar = new QToolBar("查看工具栏", this);
@@ -442,9 +531,12 @@ void MainWindow::setupActions()
     connect(m_angleAction, &QAction::triggered, this, &MainWindow::toggleAngleMode);
     connect(m_colorPickerAction, &QAction::triggered, this, &MainWindow::toggleColorPickerMode);
     connect(m_brushAction, &QAction::triggered, this, &MainWindow::toggleBrushMode);
+    connect(m_deskewAction, &QAction::triggered, this, &MainWindow::toggleDeskewMode);
     connect(m_fitToWindowAction, &QAction::triggered, this, &MainWindow::fitToWindow);
     connect(originalSizeAction, &QAction::triggered, this, &MainWindow::originalSize);
     connect(m_overlayModeAction, &QAction::triggered, this, &MainWindow::toggleOverlayMode);
+    connect(m_perfHudAction, &QAction::triggered, this, &MainWindow::togglePerfHud);
+    connect(m_compareViewAction, &QAction::triggered, this, &MainWindow::toggleCompareView);
     
     updateThemeIcons();
 }
@@ -467,10 +559,24 @@ void MainWindow::setupConnections()
             m_measurementTool->handleMouseMove(scenePos);
             m_angleMeasurementTool->handleMouseMove(scenePos);
             m_colorPickerTool->handleMouseMove(scenePos);
-            m_brushTool->handleMouseMove(scenePos);
         }
     });
     
+    connect(m_graphicsView, &ImageGraphicsView::mouseMovedPath, this, [this](const QVector<QPointF> &scenePoints) {
+        if (!m_imageViewer->pixmapItem()) {
+            return;
+        }
+        QRectF sceneRect = m_graphicsScene->sceneRect();
+        QVector<QPointF> points;
+        points.reserve(scenePoints.size());
+        for (const QPointF &point : scenePoints) {
+            if (sceneRect.contains(point)) {
+                points.append(point);
+            }
+        }
+        m_brushTool->handleMouseMovePath(points);
+    });
+    
     connect(m_graphicsView, &ImageGraphicsView::mousePressed, this, [this](QPointF scenePos) {
         if (m_imageViewer->pixmapItem() && m_graphicsScene->sceneRect().contains(scenePos)) {
             m_measurementTool->handleMousePress(scenePos);
@@ -495,6 +601,8 @@ void MainWindow::setupConnections()
     connect(m_imageViewer, &ImageViewer::fitToWindowChanged, this, [this](bool fit) {
         m_fitToWindowAction->setChecked(fit);
     });
+
+    connect(m_imageViewer, &ImageViewer::exportFinished, this, &MainWindow::onExportFinished);
     
     connect(m_graphicsView, &ImageGraphicsView::shiftPressed, this, [this]() {
         m_measurementTool->setShiftPressed(true);
@@ -558,7 +666,9 @@ void MainWindow::setupConnections()
         // 更新取色器的图像数据
         if (m_imageViewer->pixmapItem()) {
             m_colorPickerTool->setImage(m_imageViewer->originalPixmap().toImage());
+            m_colorPickerTool->setImageTransform(m_imageViewer->sceneToImageTransform());
         }
+        m_deskewTool->setAngle(0.0);
         setWindowTitle(tr("ziv - %1").arg(fileName));
     });
     
@@ -595,6 +705,54 @@ void MainWindow::setupConnections()
     connect(m_alpha1SpinBox, QOverload<int>::of(&QSpinBox::valueChanged), m_alpha1Slider, &QSlider::setValue);
     connect(m_alpha2SpinBox, QOverload<int>::of(&QSpinBox::valueChanged), m_alpha2Slider, &QSlider::setValue);
     
+    // 导航器：缩略图来自解码缓存，视口框随滚动和缩放更新
+    connect(m_imageViewer, &ImageViewer::thumbnailChanged, this, &MainWindow::updateNavigatorThumbnail);
+    connect(m_imageViewer, &ImageViewer::orientationChanged, this, [this]() {
+        m_colorPickerTool->setImageTransform(m_imageViewer->sceneToImageTransform());
+    });
+    
+    connect(m_imageViewer, &ImageViewer::swipePositionChanged, this, [this](double fraction) {
+        QSignalBlocker blocker(m_swipeSlider);
+        m_swipeSlider->setValue(qRound(fraction * 1000));
+    });
+    
+    connect(m_deskewTool, &DeskewTool::modeChanged, this, [this](bool enabled) {
+        if (!enabled) {
+            m_imageViewer->clearRotationPreview();
+        }
+    });
+    connect(m_deskewTool, &DeskewTool::angleChanged, m_imageViewer, &ImageViewer::setPreviewRotation);
+    connect(m_deskewTool, &DeskewTool::applyRequested, m_imageViewer, &ImageViewer::commitRotation);
+    connect(m_imageViewer, &ImageViewer::rotationCommitted, this, [this]() {
+        m_colorPickerTool->setImage(m_imageViewer->originalPixmap().toImage());
+        m_colorPickerTool->setImageTransform(m_imageViewer->sceneToImageTransform());
+        m_deskewTool->setBusy(false, tr("旋转已应用"));
+        m_deskewTool->setAngle(0.0);
+    });
+    connect(m_deskewTool, &DeskewTool::autoDetectRequested, this, [this]() {
+        auto *watcher = new QFutureWatcher<double>(this);
+        connect(watcher, &QFutureWatcher<double>::finished, this, [this, watcher]() {
+            double angle = watcher->result();
+            m_deskewTool->setBusy(false, tr("检测到倾斜角: %1°").arg(angle, 0, 'f', 1));
+            m_deskewTool->setAngle(angle);
+            watcher->deleteLater();
+        });
+        watcher->setFuture(m_imageViewer->estimateSkewAsync());
+    });
+    connect(m_graphicsView->horizontalScrollBar(), &QScrollBar::valueChanged, this, &MainWindow::updateNavigatorViewport);
+    connect(m_graphicsView->verticalScrollBar(), &QScrollBar::valueChanged, this, &MainWindow::updateNavigatorViewport);
+    connect(m_graphicsView->horizontalScrollBar(), &QScrollBar::rangeChanged, this, &MainWindow::updateNavigatorViewport);
+    connect(m_graphicsView->verticalScrollBar(), &QScrollBar::rangeChanged, this, &MainWindow::updateNavigatorViewport);
+    connect(m_graphicsView, &ImageGraphicsView::scaleChanged, this, &MainWindow::updateNavigatorViewport);
+    connect(m_navigatorDock, &QDockWidget::visibilityChanged, this, [this](bool visible) {
+        if (visible) {
+            updateNavigatorThumbnail();
+        }
+    });
+    connect(m_navigator, &NavigatorWidget::navigateRequested, this, [this](QPointF scenePos) {
+        m_graphicsView->centerOn(scenePos);
+    });
+    
     QShortcut *undoShortcut = new QShortcut(QKeySequence::Undo, this);
     connect(undoShortcut, &QShortcut::activated, this, [this]() {
         if (m_brushTool->canUndo()) {
@@ -608,6 +766,37 @@ void MainWindow::setupConnections()
             m_brushTool->redo();
         }
     });
+    
+    // 叠加模式下手动微调第二张图片
+    struct NudgeShortcut {
+        QKeySequence key;
+        double dx;
+        double dy;
+        double angle;
+        double scaleFactor;
+    };
+    const NudgeShortcut nudgeShortcuts[] = {
+        {QKeySequence(Qt::ALT | Qt::Key_Left), -1.0, 0.0, 0.0, 1.0},
+        {QKeySequence(Qt::ALT | Qt::Key_Right), 1.0, 0.0, 0.0, 1.0},
+        {QKeySequence(Qt::ALT | Qt::Key_Up), 0.0, -1.0, 0.0, 1.0},
+        {QKeySequence(Qt::ALT | Qt::Key_Down), 0.0, 1.0, 0.0, 1.0},
+        {QKeySequence(Qt::ALT | Qt::SHIFT | Qt::Key_Left), -0.1, 0.0, 0.0, 1.0},
+        {QKeySequence(Qt::ALT | Qt::SHIFT | Qt::Key_Right), 0.1, 0.0, 0.0, 1.0},
+        {QKeySequence(Qt::ALT | Qt::SHIFT | Qt::Key_Up), 0.0, -0.1, 0.0, 1.0},
+        {QKeySequence(Qt::ALT | Qt::SHIFT | Qt::Key_Down), 0.0, 0.1, 0.0, 1.0},
+        {QKeySequence(Qt::ALT | Qt::Key_BracketLeft), 0.0, 0.0, -0.1, 1.0},
+        {QKeySequence(Qt::ALT | Qt::Key_BracketRight), 0.0, 0.0, 0.1, 1.0},
+        {QKeySequence(Qt::ALT | Qt::Key_Equal), 0.0, 0.0, 0.0, 1.001},
+        {QKeySequence(Qt::ALT | Qt::Key_Minus), 0.0, 0.0, 0.0, 1.0 / 1.001},
+    };
+    for (const NudgeShortcut &nudge : nudgeShortcuts) {
+        QShortcut *shortcut = new QShortcut(nudge.key, this);
+        connect(shortcut, &QShortcut::activated, this, [this, nudge]() {
+            if (m_imageViewer->isOverlayMode()) {
+                m_imageViewer->nudgeManualAlignment(nudge.dx, nudge.dy, nudge.angle, nudge.scaleFactor);
+            }
+        });
+    }
 }
 
 void MainWindow::openImage()
@@ -628,6 +817,10 @@ void MainWindow::exportImage()
         QMessageBox::warning(this, tr("警告"), tr("没有可导出的图片"));
         return;
     }
+    if (m_imageViewer->isExporting()) {
+        QMessageBox::information(this, tr("提示"), tr("上一次导出尚未完成"));
+        return;
+    }
     
     QString fileName = QFileDialog::getSaveFileName(
         this,
@@ -640,22 +833,45 @@ void MainWindow::exportImage()
         return;
     }
     
-    QProgressDialog progressDialog(tr("正在保存图片..."), tr("取消"), 0, 0, this);
-    progressDialog.setWindowModality(Qt::WindowModal);
-    progressDialog.setCancelButton(nullptr);
-    progressDialog.setRange(0, 0);
-    progressDialog.show();
-    
-    QFuture<bool> future = m_imageViewer->exportImageAsync(fileName);
-    
-    while (!future.isFinished()) {
-        QCoreApplication::processEvents();
-        QThread::msleep(50);
+    ExportOptionsDialog optionsDialog(m_imageViewer, QFileInfo(fileName).suffix(), this);
+    if (optionsDialog.exec() != QDialog::Accepted) {
+        return;
     }
-    
-    progressDialog.close();
-    
-    if (future.result()) {
+
+    if (!m_imageViewer->startExport(fileName, optionsDialog.options())) {
+        QMessageBox::warning(this, tr("错误"), tr("导出图片失败"));
+        return;
+    }
+
+    // 导出在后台进行，对话框只显示进度和取消，不阻塞事件循环
+    if (!m_exportProgressDialog) {
+        m_exportProgressDialog = new QProgressDialog(tr("正在保存图片..."), tr("取消"), 0, 100, this);
+        m_exportProgressDialog->setWindowModality(Qt::WindowModal);
+        m_exportProgressDialog->setMinimumDuration(0);
+        m_exportProgressDialog->setAutoClose(false);
+        m_exportProgressDialog->setAutoReset(false);
+        connect(m_exportProgressDialog, &QProgressDialog::canceled, m_imageViewer, &ImageViewer::cancelExport);
+        connect(m_imageViewer, &ImageViewer::exportProgress, this, [this](int percent) {
+            // 取消后对话框已隐藏，剩余的进度通知不能让它重新弹出
+            if (!m_exportProgressDialog->wasCanceled()) {
+                m_exportProgressDialog->setValue(percent);
+            }
+        });
+    }
+    m_exportProgressDialog->reset();
+    m_exportProgressDialog->setValue(0);
+    m_exportProgressDialog->show();
+}
+
+void MainWindow::onExportFinished(bool success, bool cancelled, const QString &fileName)
+{
+    if (m_exportProgressDialog) {
+        m_exportProgressDialog->hide();
+    }
+
+    if (cancelled) {
+        statusBar()->showMessage(tr("导出已取消"), 3000);
+    } else if (success) {
         QMessageBox::information(this, tr("成功"), tr("图片已成功导出到:\n%1").arg(fileName));
     } else {
         QMessageBox::warning(this, tr("错误"), tr("导出图片失败"));
@@ -733,6 +949,8 @@ void MainWindow::toggleMeasureMode()
         m_brushTool->toggleBrushMode(false);
         m_overlayModeAction->setChecked(false);
         m_imageViewer->enableOverlayMode(false);
+        m_deskewAction->setChecked(false);
+        m_deskewTool->toggleDeskewMode(false);
         updateToolsPanel(0);  // 显示测量面板
     }
     // 右侧面板始终显示，不隐藏
@@ -756,6 +974,8 @@ void MainWindow::toggleAngleMode()
         m_brushTool->toggleBrushMode(false);
         m_overlayModeAction->setChecked(false);
         m_imageViewer->enableOverlayMode(false);
+        m_deskewAction->setChecked(false);
+        m_deskewTool->toggleDeskewMode(false);
         updateToolsPanel(1);  // 显示测角面板
     }
     // 右侧面板始终显示，不隐藏
@@ -781,6 +1001,9 @@ void MainWindow::toggleColorPickerMode()
         m_imageViewer->enableOverlayMode(false);
 
         m_colorPickerTool->setImage(m_imageViewer->originalPixmap().toImage());
+        m_colorPickerTool->setImageTransform(m_imageViewer->sceneToImageTransform());
+        m_deskewAction->setChecked(false);
+        m_deskewTool->toggleDeskewMode(false);
         updateToolsPanel(2);  // 显示取色器面板
     }
     // 右侧面板始终显示，不隐藏
@@ -805,12 +1028,39 @@ void MainWindow::toggleBrushMode()
         m_colorPickerTool->toggleColorPickerMode(false);
         m_overlayModeAction->setChecked(false);
         m_imageViewer->enableOverlayMode(false);
+        m_deskewAction->setChecked(false);
+        m_deskewTool->toggleDeskewMode(false);
         updateToolsPanel(3);  // 显示画笔面板
     }
 
     m_brushTool->toggleBrushMode(m_brushAction->isChecked());
 }
 
+void MainWindow::toggleDeskewMode()
+{
+    if (!m_imageViewer->isEnabled()) {
+        m_deskewAction->setChecked(false);
+        QMessageBox::warning(this, tr("警告"), tr("请先打开一张图片"));
+        return;
+    }
+
+    if (m_deskewAction->isChecked()) {
+        m_measureAction->setChecked(false);
+        m_measurementTool->toggleMeasureMode(false);
+        m_angleAction->setChecked(false);
+        m_angleMeasurementTool->toggleAngleMode(false);
+        m_colorPickerAction->setChecked(false);
+        m_colorPickerTool->toggleColorPickerMode(false);
+        m_brushAction->setChecked(false);
+        m_brushTool->toggleBrushMode(false);
+        m_overlayModeAction->setChecked(false);
+        m_imageViewer->enableOverlayMode(false);
+        updateToolsPanel(5);  // 显示自由旋转面板
+    }
+
+    m_deskewTool->toggleDeskewMode(m_deskewAction->isChecked());
+}
+
 void MainWindow::nextImage()
 {
     m_imageViewer->nextImage();
@@ -829,6 +1079,7 @@ void MainWindow::onPaletteChanged()
     m_measurementTool->updateTheme(m_isDarkTheme);
     m_angleMeasurementTool->updateTheme(m_isDarkTheme);
     m_brushTool->updateTheme(m_isDarkTheme);
+    m_deskewTool->updateTheme(m_isDarkTheme);
     updateOverlayPanelTheme();
     
     QString coordIconPath = m_isDarkTheme ? ":/icons/dark/coordinate.png" : ":/icons/light/coordinate.png";
@@ -923,11 +1174,62 @@ void MainWindow::createOverlayControlPanel()
     btnLayout->addWidget(m_clearImage2Button);
     layout->addLayout(btnLayout);
     
+    // A/B 配对目录：切换图片时自动加载同名的第二张图片
+    QHBoxLayout *pairedLayout = new QHBoxLayout();
+    QLabel *pairedLabel = style.createEmphasisLabel("配对目录:", m_isDarkTheme);
+    QLabel *pairedPathLabel = style.createContentLabel("未设置", m_isDarkTheme);
+    pairedLayout->addWidget(pairedLabel);
+    pairedLayout->addWidget(pairedPathLabel, 1);
+    layout->addLayout(pairedLayout);
+    
+    QHBoxLayout *pairedBtnLayout = new QHBoxLayout();
+    QPushButton *choosePairedButton = new QPushButton("选择目录");
+    QPushButton *clearPairedButton = new QPushButton("取消配对");
+    clearPairedButton->setEnabled(false);
+    pairedBtnLayout->addWidget(choosePairedButton);
+    pairedBtnLayout->addWidget(clearPairedButton);
+    layout->addLayout(pairedBtnLayout);
+    
+    connect(choosePairedButton, &QPushButton::clicked, this, [this]() {
+        QString directory = QFileDialog::getExistingDirectory(this, tr("选择配对目录"), m_imageViewer->pairedDirectory());
+        if (!directory.isEmpty()) {
+            m_imageViewer->setPairedDirectory(directory);
+        }
+    });
+    connect(clearPairedButton, &QPushButton::clicked, this, [this]() {
+        m_imageViewer->setPairedDirectory(QString());
+    });
+    connect(m_imageViewer, &ImageViewer::pairedDirectoryChanged, this,
+            [pairedPathLabel, clearPairedButton](const QString &directoryPath) {
+        pairedPathLabel->setText(directoryPath.isEmpty() ? QString("未设置") : QDir(directoryPath).dirName());
+        pairedPathLabel->setToolTip(directoryPath);
+        clearPairedButton->setEnabled(!directoryPath.isEmpty());
+    });
+    
     QFrame *line1 = style.createSeparator(m_isDarkTheme);
     layout->addWidget(line1);
     
+    QLabel *compareTitle = style.createSectionLabel("对比方式", m_isDarkTheme);
+    layout->addWidget(compareTitle);
+    
+    m_compareModeCombo = new QComboBox();
+    m_compareModeCombo->addItem("混合", ImageViewer::CompareBlend);
+    m_compareModeCombo->addItem("差异热图", ImageViewer::CompareDifference);
+    m_compareModeCombo->addItem("卷帘", ImageViewer::CompareSwipe);
+    m_compareModeCombo->addItem("棋盘格", ImageViewer::CompareCheckerboard);
+    m_compareModeCombo->addItem("闪烁", ImageViewer::CompareFlicker);
+    layout->addWidget(m_compareModeCombo);
+    
+    // 各对比方式的参数页
+    m_compareOptionsStack = new QStackedWidget();
+    
+    QWidget *blendPage = new QWidget();
+    QVBoxLayout *blendLayout = new QVBoxLayout(blendPage);
+    blendLayout->setContentsMargins(0, 0, 0, 0);
+    blendLayout->setSpacing(6);
+    
     QLabel *alphaTitle = style.createSectionLabel("透明度控制", m_isDarkTheme);
-    layout->addWidget(alphaTitle);
+    blendLayout->addWidget(alphaTitle);
     
     QHBoxLayout *alpha1Layout = new QHBoxLayout();
     m_alpha1Label = style.createContentLabel("图片1:", m_isDarkTheme);
@@ -944,7 +1246,7 @@ void MainWindow::createOverlayControlPanel()
     alpha1Layout->addWidget(m_alpha1Label);
     alpha1Layout->addWidget(m_alpha1Slider, 1);
     alpha1Layout->addWidget(m_alpha1SpinBox);
-    layout->addLayout(alpha1Layout);
+    blendLayout->addLayout(alpha1Layout);
 
     QHBoxLayout *alpha2Layout = new QHBoxLayout();
     m_alpha2Label = style.createContentLabel("图片2:", m_isDarkTheme);
@@ -961,7 +1263,468 @@ void MainWindow::createOverlayControlPanel()
     alpha2Layout->addWidget(m_alpha2Label);
     alpha2Layout->addWidget(m_alpha2Slider, 1);
     alpha2Layout->addWidget(m_alpha2SpinBox);
-    layout->addLayout(alpha2Layout);
+    blendLayout->addLayout(alpha2Layout);
+    
+    m_compareOptionsStack->addWidget(blendPage);
+    
+    QWidget *differencePage = new QWidget();
+    QVBoxLayout *differenceLayout = new QVBoxLayout(differencePage);
+    differenceLayout->setContentsMargins(0, 0, 0, 0);
+    differenceLayout->setSpacing(6);
+    QHBoxLayout *gainLayout = new QHBoxLayout();
+    QLabel *gainLabel = style.createContentLabel("增益:", m_isDarkTheme);
+    QSlider *gainSlider = new QSlider(Qt::Horizontal);
+    gainSlider->setRange(1, 32);
+    gainSlider->setValue(4);
+    QSpinBox *gainSpinBox = new QSpinBox();
+    gainSpinBox->setRange(1, 32);
+    gainSpinBox->setValue(4);
+    gainSpinBox->setSuffix("x");
+    gainSpinBox->setFixedWidth(60);
+    gainLayout->addWidget(gainLabel);
+    gainLayout->addWidget(gainSlider, 1);
+    gainLayout->addWidget(gainSpinBox);
+    differenceLayout->addLayout(gainLayout);
+    QCheckBox *heatmapCheckBox = new QCheckBox("伪彩色热图");
+    heatmapCheckBox->setChecked(true);
+    differenceLayout->addWidget(heatmapCheckBox);
+    m_compareOptionsStack->addWidget(differencePage);
+    
+    connect(gainSlider, &QSlider::valueChanged, this, [this, gainSpinBox](int value) {
+        QSignalBlocker blocker(gainSpinBox);
+        gainSpinBox->setValue(value);
+        m_imageViewer->setDifferenceGain(value);
+    });
+    connect(gainSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, [gainSlider](int value) {
+        gainSlider->setValue(value);
+    });
+    connect(heatmapCheckBox, &QCheckBox::toggled, this, [this](bool checked) {
+        m_imageViewer->setDifferenceHeatmap(checked);
+    });
+    
+    QWidget *swipePage = new QWidget();
+    QVBoxLayout *swipeLayout = new QVBoxLayout(swipePage);
+    swipeLayout->setContentsMargins(0, 0, 0, 0);
+    swipeLayout->setSpacing(6);
+    QHBoxLayout *swipeSliderLayout = new QHBoxLayout();
+    QLabel *swipeLabel = style.createContentLabel("分割线:", m_isDarkTheme);
+    m_swipeSlider = new QSlider(Qt::Horizontal);
+    m_swipeSlider->setRange(0, 1000);
+    m_swipeSlider->setValue(500);
+    swipeSliderLayout->addWidget(swipeLabel);
+    swipeSliderLayout->addWidget(m_swipeSlider, 1);
+    swipeLayout->addLayout(swipeSliderLayout);
+    QLabel *swipeHint = style.createContentLabel("也可以直接在图片上拖动分割线", m_isDarkTheme);
+    swipeHint->setWordWrap(true);
+    swipeLayout->addWidget(swipeHint);
+    m_compareOptionsStack->addWidget(swipePage);
+    
+    connect(m_swipeSlider, &QSlider::valueChanged, this, [this](int value) {
+        m_imageViewer->setSwipePosition(value / 1000.0);
+    });
+    
+    QWidget *checkerPage = new QWidget();
+    QHBoxLayout *checkerLayout = new QHBoxLayout(checkerPage);
+    checkerLayout->setContentsMargins(0, 0, 0, 0);
+    QLabel *checkerLabel = style.createContentLabel("格子大小:", m_isDarkTheme);
+    QSpinBox *checkerSpinBox = new QSpinBox();
+    checkerSpinBox->setRange(4, 2048);
+    checkerSpinBox->setValue(64);
+    checkerSpinBox->setSuffix(" px");
+    checkerLayout->addWidget(checkerLabel);
+    checkerLayout->addWidget(checkerSpinBox, 1);
+    m_compareOptionsStack->addWidget(checkerPage);
+    
+    connect(checkerSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int value) {
+        m_imageViewer->setCheckerSize(value);
+    });
+    
+    QWidget *flickerPage = new QWidget();
+    QHBoxLayout *flickerLayout = new QHBoxLayout(flickerPage);
+    flickerLayout->setContentsMargins(0, 0, 0, 0);
+    QLabel *flickerLabel = style.createContentLabel("切换频率:", m_isDarkTheme);
+    QDoubleSpinBox *flickerSpinBox = new QDoubleSpinBox();
+    flickerSpinBox->setRange(0.5, 20.0);
+    flickerSpinBox->setSingleStep(0.5);
+    flickerSpinBox->setValue(2.0);
+    flickerSpinBox->setSuffix(" 次/秒");
+    flickerLayout->addWidget(flickerLabel);
+    flickerLayout->addWidget(flickerSpinBox, 1);
+    m_compareOptionsStack->addWidget(flickerPage);
+    
+    connect(flickerSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this](double value) {
+        m_imageViewer->setFlickerRate(value);
+    });
+    
+    layout->addWidget(m_compareOptionsStack);
+    
+    connect(m_compareModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        m_compareOptionsStack->setCurrentIndex(index);
+        m_imageViewer->setCompareMode(static_cast<ImageViewer::CompareMode>(m_compareModeCombo->itemData(index).toInt()));
+    });
+    
+    QHBoxLayout *exposureLayout = new QHBoxLayout();
+    QLabel *exposureLabel = style.createContentLabel("曝光归一化:", m_isDarkTheme);
+    QComboBox *exposureCombo = new QComboBox();
+    exposureCombo->addItem("无", static_cast<int>(ExposureMatchMode::None));
+    exposureCombo->addItem("直方图匹配", static_cast<int>(ExposureMatchMode::Histogram));
+    exposureCombo->addItem("均值/标准差", static_cast<int>(ExposureMatchMode::MeanStd));
+    exposureLayout->addWidget(exposureLabel);
+    exposureLayout->addWidget(exposureCombo, 1);
+    layout->addLayout(exposureLayout);
+    
+    connect(exposureCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this, exposureCombo](int index) {
+        m_imageViewer->setExposureMatchMode(static_cast<ExposureMatchMode>(exposureCombo->itemData(index).toInt()));
+    });
+    
+    QFrame *alignmentLine = style.createSeparator(m_isDarkTheme);
+    layout->addWidget(alignmentLine);
+    
+    QLabel *alignmentTitle = style.createSectionLabel("手动对齐", m_isDarkTheme);
+    layout->addWidget(alignmentTitle);
+    
+    auto createAlignmentSpinBox = [](double minimum, double maximum, double step, int decimals, const QString &suffix) {
+        QDoubleSpinBox *spinBox = new QDoubleSpinBox();
+        spinBox->setRange(minimum, maximum);
+        spinBox->setSingleStep(step);
+        spinBox->setDecimals(decimals);
+        spinBox->setSuffix(suffix);
+        return spinBox;
+    };
+    QDoubleSpinBox *offsetXSpinBox = createAlignmentSpinBox(-100000.0, 100000.0, 0.1, 2, " px");
+    QDoubleSpinBox *offsetYSpinBox = createAlignmentSpinBox(-100000.0, 100000.0, 0.1, 2, " px");
+    QDoubleSpinBox *angleSpinBox = createAlignmentSpinBox(-180.0, 180.0, 0.05, 2, "°");
+    QDoubleSpinBox *scaleSpinBox = createAlignmentSpinBox(1.0, 10000.0, 0.1, 3, "%");
+    scaleSpinBox->setValue(100.0);
+    
+    QHBoxLayout *offsetLayout = new QHBoxLayout();
+    offsetLayout->addWidget(style.createContentLabel("X:", m_isDarkTheme));
+    offsetLayout->addWidget(offsetXSpinBox, 1);
+    offsetLayout->addWidget(style.createContentLabel("Y:", m_isDarkTheme));
+    offsetLayout->addWidget(offsetYSpinBox, 1);
+    layout->addLayout(offsetLayout);
+    
+    QHBoxLayout *angleScaleLayout = new QHBoxLayout();
+    angleScaleLayout->addWidget(style.createContentLabel("旋转:", m_isDarkTheme));
+    angleScaleLayout->addWidget(angleSpinBox, 1);
+    angleScaleLayout->addWidget(style.createContentLabel("缩放:", m_isDarkTheme));
+    angleScaleLayout->addWidget(scaleSpinBox, 1);
+    layout->addLayout(angleScaleLayout);
+    
+    QHBoxLayout *alignmentBtnLayout = new QHBoxLayout();
+    QPushButton *resetAlignmentButton = new QPushButton("重置");
+    alignmentBtnLayout->addWidget(resetAlignmentButton);
+    layout->addLayout(alignmentBtnLayout);
+    
+    QLabel *alignmentHint = style.createContentLabel("Alt+方向键平移 1 px，加 Shift 为 0.1 px；Alt+[ ] 旋转，Alt+= - 缩放", m_isDarkTheme);
+    alignmentHint->setWordWrap(true);
+    layout->addWidget(alignmentHint);
+    
+    // 只提交被编辑的字段，其余字段保持原值，不被输入框的显示精度截断
+    connect(offsetXSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this](double value) {
+        ImageViewer::ManualAlignment alignment = m_imageViewer->manualAlignment();
+        alignment.dx = value;
+        m_imageViewer->setManualAlignment(alignment);
+    });
+    connect(offsetYSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this](double value) {
+        ImageViewer::ManualAlignment alignment = m_imageViewer->manualAlignment();
+        alignment.dy = value;
+        m_imageViewer->setManualAlignment(alignment);
+    });
+    connect(angleSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this](double value) {
+        ImageViewer::ManualAlignment alignment = m_imageViewer->manualAlignment();
+        alignment.angle = value;
+        m_imageViewer->setManualAlignment(alignment);
+    });
+    connect(scaleSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this](double value) {
+        ImageViewer::ManualAlignment alignment = m_imageViewer->manualAlignment();
+        alignment.scale = value / 100.0;
+        m_imageViewer->setManualAlignment(alignment);
+    });
+    connect(resetAlignmentButton, &QPushButton::clicked, m_imageViewer, &ImageViewer::resetManualAlignment);
+    connect(m_imageViewer, &ImageViewer::manualAlignmentChanged, this,
+            [this, offsetXSpinBox, offsetYSpinBox, angleSpinBox, scaleSpinBox]() {
+        ImageViewer::ManualAlignment alignment = m_imageViewer->manualAlignment();
+        QSignalBlocker blockerX(offsetXSpinBox);
+        QSignalBlocker blockerY(offsetYSpinBox);
+        QSignalBlocker blockerAngle(angleSpinBox);
+        QSignalBlocker blockerScale(scaleSpinBox);
+        offsetXSpinBox->setValue(alignment.dx);
+        offsetYSpinBox->setValue(alignment.dy);
+        angleSpinBox->setValue(alignment.angle);
+        scaleSpinBox->setValue(alignment.scale * 100.0);
+    });
+    
+    QFrame *line2 = style.createSeparator(m_isDarkTheme);
+    layout->addWidget(line2);
+    
+    QLabel *registrationTitle = style.createSectionLabel("自动配准", m_isDarkTheme);
+    layout->addWidget(registrationTitle);
+    
+    QHBoxLayout *modelLayout = new QHBoxLayout();
+    QLabel *modelLabel = style.createContentLabel("模型:", m_isDarkTheme);
+    QComboBox *modelCombo = new QComboBox();
+    modelCombo->addItem("平移", static_cast<int>(RegistrationModel::Translation));
+    modelCombo->addItem("仿射", static_cast<int>(RegistrationModel::Affine));
+    modelCombo->addItem("透视", static_cast<int>(RegistrationModel::Homography));
+    modelCombo->setCurrentIndex(1);
+    modelLayout->addWidget(modelLabel);
+    modelLayout->addWidget(modelCombo, 1);
+    layout->addLayout(modelLayout);
+    
+    QHBoxLayout *registrationBtnLayout = new QHBoxLayout();
+    QPushButton *registerButton = new QPushButton("配准");
+    QPushButton *cancelRegistrationButton = new QPushButton("取消");
+    QPushButton *resetRegistrationButton = new QPushButton("重置");
+    cancelRegistrationButton->setEnabled(false);
+    resetRegistrationButton->setEnabled(false);
+    registrationBtnLayout->addWidget(registerButton);
+    registrationBtnLayout->addWidget(cancelRegistrationButton);
+    registrationBtnLayout->addWidget(resetRegistrationButton);
+    layout->addLayout(registrationBtnLayout);
+    
+    QProgressBar *registrationProgress = new QProgressBar();
+    registrationProgress->setRange(0, 100);
+    registrationProgress->setValue(0);
+    registrationProgress->setVisible(false);
+    layout->addWidget(registrationProgress);
+    
+    QLabel *registrationStatus = style.createContentLabel("未配准", m_isDarkTheme);
+    registrationStatus->setWordWrap(true);
+    layout->addWidget(registrationStatus);
+    
+    connect(registerButton, &QPushButton::clicked, this, [=]() {
+        if (m_imageViewer->secondImageFileName().isEmpty()) {
+            registrationStatus->setText("请先加载第二张图片");
+            return;
+        }
+        registerButton->setEnabled(false);
+        cancelRegistrationButton->setEnabled(true);
+        registrationProgress->setValue(0);
+        registrationProgress->setVisible(true);
+        registrationStatus->setText("正在配准...");
+        if (!m_imageViewer->startRegistration(static_cast<RegistrationModel>(modelCombo->currentData().toInt()))) {
+            // 未启动时不会收到 registrationFinished，在这里恢复面板
+            registerButton->setEnabled(true);
+            cancelRegistrationButton->setEnabled(false);
+            registrationProgress->setVisible(false);
+            registrationStatus->setText("无法配准：请先加载两张图片");
+        }
+    });
+    connect(cancelRegistrationButton, &QPushButton::clicked, this, [this, registrationStatus]() {
+        m_imageViewer->cancelRegistration();
+        registrationStatus->setText("正在取消...");
+    });
+    connect(resetRegistrationButton, &QPushButton::clicked, this, [this]() {
+        m_imageViewer->clearRegistration();
+    });
+    connect(m_imageViewer, &ImageViewer::registrationProgress, registrationProgress, &QProgressBar::setValue);
+    connect(m_imageViewer, &ImageViewer::registrationFinished, this,
+            [=](bool, const QString &message) {
+        registerButton->setEnabled(true);
+        cancelRegistrationButton->setEnabled(false);
+        registrationProgress->setVisible(false);
+        resetRegistrationButton->setEnabled(m_imageViewer->hasRegistration());
+        registrationStatus->setText(message);
+    });
+    connect(m_imageViewer, &ImageViewer::registrationCleared, this,
+            [resetRegistrationButton, registrationStatus]() {
+        resetRegistrationButton->setEnabled(false);
+        registrationStatus->setText("未配准");
+    });
+    
+    QFrame *metricsLine = style.createSeparator(m_isDarkTheme);
+    layout->addWidget(metricsLine);
+    
+    QLabel *metricsTitle = style.createSectionLabel("画质指标", m_isDarkTheme);
+    layout->addWidget(metricsTitle);
+    
+    QLabel *wholeMetricsLabel = style.createContentLabel("整图: -", m_isDarkTheme);
+    QLabel *visibleMetricsLabel = style.createContentLabel("可见区域: -", m_isDarkTheme);
+    wholeMetricsLabel->setWordWrap(true);
+    visibleMetricsLabel->setWordWrap(true);
+    layout->addWidget(wholeMetricsLabel);
+    layout->addWidget(visibleMetricsLabel);
+    
+    connect(m_imageViewer, &ImageViewer::qualityMetricsChanged, this, [this, wholeMetricsLabel, visibleMetricsLabel]() {
+        auto format = [](const QualityMetrics &metrics) {
+            if (!metrics.valid) {
+                return QString("-");
+            }
+            QString psnr = std::isinf(metrics.psnr) ? QString("∞") : QString::number(metrics.psnr, 'f', 2);
+            return QString("MSE %1  PSNR %2 dB  SSIM %3")
+                .arg(metrics.mse, 0, 'f', 2)
+                .arg(psnr)
+                .arg(metrics.ssim, 0, 'f', 4);
+        };
+        if (m_imageViewer->isComputingMetrics()) {
+            wholeMetricsLabel->setText("整图: 计算中...");
+            visibleMetricsLabel->setText("可见区域: 计算中...");
+            return;
+        }
+        wholeMetricsLabel->setText("整图: " + format(m_imageViewer->wholeImageMetrics()));
+        visibleMetricsLabel->setText("可见区域: " + format(m_imageViewer->visibleMetrics()));
+    });
+    
+    QFrame *regionsLine = style.createSeparator(m_isDarkTheme);
+    layout->addWidget(regionsLine);
+    
+    QLabel *regionsTitle = style.createSectionLabel("差异区域", m_isDarkTheme);
+    layout->addWidget(regionsTitle);
+    
+    QHBoxLayout *regionParamsLayout = new QHBoxLayout();
+    QLabel *regionThresholdLabel = style.createContentLabel("阈值:", m_isDarkTheme);
+    QSpinBox *regionThresholdSpinBox = new QSpinBox();
+    regionThresholdSpinBox->setRange(0, 254);
+    regionThresholdSpinBox->setValue(16);
+    QLabel *regionMinAreaLabel = style.createContentLabel("最小面积:", m_isDarkTheme);
+    QSpinBox *regionMinAreaSpinBox = new QSpinBox();
+    regionMinAreaSpinBox->setRange(1, 1000000);
+    regionMinAreaSpinBox->setValue(16);
+    regionMinAreaSpinBox->setSuffix(" px");
+    regionParamsLayout->addWidget(regionThresholdLabel);
+    regionParamsLayout->addWidget(regionThresholdSpinBox, 1);
+    regionParamsLayout->addWidget(regionMinAreaLabel);
+    regionParamsLayout->addWidget(regionMinAreaSpinBox, 1);
+    layout->addLayout(regionParamsLayout);
+    
+    QHBoxLayout *regionBtnLayout = new QHBoxLayout();
+    QPushButton *detectRegionsButton = new QPushButton("检测");
+    QPushButton *previousRegionButton = new QPushButton("上一处");
+    QPushButton *nextRegionButton = new QPushButton("下一处");
+    regionBtnLayout->addWidget(detectRegionsButton);
+    regionBtnLayout->addWidget(previousRegionButton);
+    regionBtnLayout->addWidget(nextRegionButton);
+    layout->addLayout(regionBtnLayout);
+    
+    QLabel *regionsStatus = style.createContentLabel("未检测", m_isDarkTheme);
+    regionsStatus->setWordWrap(true);
+    layout->addWidget(regionsStatus);
+    
+    auto analyzeRegions = [this, regionThresholdSpinBox, regionMinAreaSpinBox]() {
+        m_imageViewer->analyzeChangedRegions(regionThresholdSpinBox->value(), regionMinAreaSpinBox->value());
+    };
+    connect(detectRegionsButton, &QPushButton::clicked, this, analyzeRegions);
+    connect(regionThresholdSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, analyzeRegions);
+    connect(regionMinAreaSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, analyzeRegions);
+    connect(previousRegionButton, &QPushButton::clicked, m_imageViewer, &ImageViewer::goToPreviousRegion);
+    connect(nextRegionButton, &QPushButton::clicked, m_imageViewer, &ImageViewer::goToNextRegion);
+    connect(m_imageViewer, &ImageViewer::changedRegionsUpdated, this, [this, regionsStatus]() {
+        if (m_imageViewer->isAnalyzingRegions()) {
+            regionsStatus->setText("正在检测...");
+        } else {
+            regionsStatus->setText(QString("共 %1 处差异").arg(m_imageViewer->changedRegions().size()));
+        }
+    });
+    connect(m_imageViewer, &ImageViewer::currentRegionChanged, this, [this, regionsStatus](int index) {
+        const std::vector<ChangedRegion> &regions = m_imageViewer->changedRegions();
+        const ChangedRegion &region = regions[index];
+        regionsStatus->setText(QString("第 %1 / %2 处  %3 x %4  面积 %5 px")
+                                   .arg(index + 1)
+                                   .arg(regions.size())
+                                   .arg(region.bounds.width())
+                                   .arg(region.bounds.height())
+                                   .arg(region.area));
+    });
+    
+    QFrame *line3 = style.createSeparator(m_isDarkTheme);
+    layout->addWidget(line3);
+    
+    QLabel *layersTitle = style.createSectionLabel("附加图层", m_isDarkTheme);
+    layout->addWidget(layersTitle);
+    
+    m_layerList = new QListWidget();
+    m_layerList->setMaximumHeight(120);
+    layout->addWidget(m_layerList);
+    
+    QHBoxLayout *layerBtnLayout = new QHBoxLayout();
+    QPushButton *addLayerButton = new QPushButton("添加");
+    QPushButton *removeLayerButton = new QPushButton("删除");
+    QPushButton *raiseLayerButton = new QPushButton("上移");
+    QPushButton *lowerLayerButton = new QPushButton("下移");
+    layerBtnLayout->addWidget(addLayerButton);
+    layerBtnLayout->addWidget(removeLayerButton);
+    layerBtnLayout->addWidget(raiseLayerButton);
+    layerBtnLayout->addWidget(lowerLayerButton);
+    layout->addLayout(layerBtnLayout);
+    
+    m_layerOptions = new QWidget();
+    QVBoxLayout *layerOptionsLayout = new QVBoxLayout(m_layerOptions);
+    layerOptionsLayout->setContentsMargins(0, 0, 0, 0);
+    layerOptionsLayout->setSpacing(6);
+    
+    QHBoxLayout *layerOpacityLayout = new QHBoxLayout();
+    QLabel *layerOpacityLabel = style.createContentLabel("不透明度:", m_isDarkTheme);
+    m_layerOpacitySlider = new QSlider(Qt::Horizontal);
+    m_layerOpacitySlider->setRange(0, 100);
+    m_layerOpacitySlider->setValue(100);
+    QSpinBox *layerOpacitySpinBox = new QSpinBox();
+    layerOpacitySpinBox->setRange(0, 100);
+    layerOpacitySpinBox->setValue(100);
+    layerOpacitySpinBox->setSuffix("%");
+    layerOpacitySpinBox->setFixedWidth(60);
+    layerOpacityLayout->addWidget(layerOpacityLabel);
+    layerOpacityLayout->addWidget(m_layerOpacitySlider, 1);
+    layerOpacityLayout->addWidget(layerOpacitySpinBox);
+    layerOptionsLayout->addLayout(layerOpacityLayout);
+    
+    QHBoxLayout *layerBlendLayout = new QHBoxLayout();
+    QLabel *layerBlendLabel = style.createContentLabel("混合:", m_isDarkTheme);
+    m_layerBlendCombo = new QComboBox();
+    m_layerBlendCombo->addItem("正常", static_cast<int>(LayerBlendMode::Normal));
+    m_layerBlendCombo->addItem("正片叠底", static_cast<int>(LayerBlendMode::Multiply));
+    m_layerBlendCombo->addItem("滤色", static_cast<int>(LayerBlendMode::Screen));
+    m_layerBlendCombo->addItem("相加", static_cast<int>(LayerBlendMode::Additive));
+    m_layerBlendCombo->addItem("差值", static_cast<int>(LayerBlendMode::Difference));
+    layerBlendLayout->addWidget(layerBlendLabel);
+    layerBlendLayout->addWidget(m_layerBlendCombo, 1);
+    layerOptionsLayout->addLayout(layerBlendLayout);
+    
+    m_layerOptions->setEnabled(false);
+    layout->addWidget(m_layerOptions);
+    
+    connect(addLayerButton, &QPushButton::clicked, this, &MainWindow::addOverlayLayer);
+    connect(removeLayerButton, &QPushButton::clicked, this, &MainWindow::removeOverlayLayer);
+    // 列表自上而下对应图层自顶向底，上移即序号加一
+    connect(raiseLayerButton, &QPushButton::clicked, this, [this]() {
+        int row = m_layerList->currentRow();
+        int count = m_imageViewer->layerStack().count();
+        if (row > 0) {
+            m_imageViewer->moveLayer(count - 1 - row, count - row);
+            m_layerList->setCurrentRow(row - 1);
+        }
+    });
+    connect(lowerLayerButton, &QPushButton::clicked, this, [this]() {
+        int row = m_layerList->currentRow();
+        int count = m_imageViewer->layerStack().count();
+        if (row >= 0 && row < count - 1) {
+            m_imageViewer->moveLayer(count - 1 - row, count - 2 - row);
+            m_layerList->setCurrentRow(row + 1);
+        }
+    });
+    connect(m_layerList, &QListWidget::currentRowChanged, this, &MainWindow::onLayerSelectionChanged);
+    connect(m_layerList, &QListWidget::itemChanged, this, [this](QListWidgetItem *item) {
+        int row = m_layerList->row(item);
+        int count = m_imageViewer->layerStack().count();
+        m_imageViewer->setLayerVisible(count - 1 - row, item->checkState() == Qt::Checked);
+    });
+    connect(m_layerOpacitySlider, &QSlider::valueChanged, this, [this, layerOpacitySpinBox](int value) {
+        QSignalBlocker blocker(layerOpacitySpinBox);
+        layerOpacitySpinBox->setValue(value);
+        int row = m_layerList->currentRow();
+        if (row >= 0) {
+            m_imageViewer->setLayerOpacity(m_imageViewer->layerStack().count() - 1 - row, value / 100.0);
+        }
+    });
+    connect(layerOpacitySpinBox, QOverload<int>::of(&QSpinBox::valueChanged), m_layerOpacitySlider, &QSlider::setValue);
+    connect(m_layerBlendCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        int row = m_layerList->currentRow();
+        if (row >= 0) {
+            m_imageViewer->setLayerBlendMode(m_imageViewer->layerStack().count() - 1 - row,
+                                             static_cast<LayerBlendMode>(m_layerBlendCombo->itemData(index).toInt()));
+        }
+    });
+    connect(m_imageViewer, &ImageViewer::layersChanged, this, &MainWindow::refreshLayerList);
     
     layout->addStretch();
     
@@ -1002,6 +1765,8 @@ void MainWindow::toggleOverlayMode()
         m_colorPickerTool->toggleColorPickerMode(false);
         m_brushAction->setChecked(false);
         m_brushTool->toggleBrushMode(false);
+        m_deskewAction->setChecked(false);
+        m_deskewTool->toggleDeskewMode(false);
         updateToolsPanel(4);  // 显示叠加控制面板
     }
     // 右侧面板始终显示，不隐藏
@@ -1026,6 +1791,63 @@ void MainWindow::clearSecondImage()
     m_imageViewer->clearSecondImage();
 }
 
+void MainWindow::addOverlayLayer()
+{
+    QString fileName = QFileDialog::getOpenFileName(
+        this,
+        tr("添加图层"),
+        QString(),
+        tr("图片文件 (*.png *.jpg *.jpeg *.bmp *.tiff *.tif *.webp);;所有文件 (*.*)")
+    );
+
+    if (!fileName.isEmpty() && m_imageViewer->addLayer(fileName)) {
+        m_layerList->setCurrentRow(0);
+    }
+}
+
+void MainWindow::removeOverlayLayer()
+{
+    int row = m_layerList->currentRow();
+    if (row >= 0) {
+        m_imageViewer->removeLayer(m_imageViewer->layerStack().count() - 1 - row);
+    }
+}
+
+void MainWindow::refreshLayerList()
+{
+    const LayerStack &stack = m_imageViewer->layerStack();
+    int row = m_layerList->currentRow();
+
+    QSignalBlocker blocker(m_layerList);
+    m_layerList->clear();
+    for (int i = stack.count() - 1; i >= 0; --i) {
+        const LayerStack::Layer &layer = stack.layer(i);
+        QListWidgetItem *item = new QListWidgetItem(QFileInfo(layer.fileName).fileName());
+        item->setToolTip(layer.fileName);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(layer.visible ? Qt::Checked : Qt::Unchecked);
+        m_layerList->addItem(item);
+    }
+    m_layerList->setCurrentRow(qMin(row, m_layerList->count() - 1));
+    onLayerSelectionChanged();
+}
+
+void MainWindow::onLayerSelectionChanged()
+{
+    int row = m_layerList->currentRow();
+    const LayerStack &stack = m_imageViewer->layerStack();
+    m_layerOptions->setEnabled(row >= 0);
+    if (row < 0) {
+        return;
+    }
+
+    const LayerStack::Layer &layer = stack.layer(stack.count() - 1 - row);
+    // 不透明度未变化时 ImageViewer 不会重绘，这里不屏蔽滑块信号以同步数值框
+    QSignalBlocker blendBlocker(m_layerBlendCombo);
+    m_layerOpacitySlider->setValue(qRound(layer.opacity * 100));
+    m_layerBlendCombo->setCurrentIndex(m_layerBlendCombo->findData(static_cast<int>(layer.mode)));
+}
+
 void MainWindow::onAlpha1Changed(int value)
 {
     m_alpha1SpinBox->blockSignals(true);
@@ -1043,3 +1865,49 @@ void MainWindow::onAlpha2Changed(int value)
 
     m_imageViewer->setAlpha2(value / 100.0);
 }
+
+void MainWindow::togglePerfHud()
+{
+    m_graphicsView->setPerfHudVisible(m_perfHudAction->isChecked());
+}
+
+void MainWindow::updateNavigatorThumbnail()
+{
+    if (!m_navigatorDock->isVisible()) {
+        return;
+    }
+    
+    if (!m_imageViewer->pixmapItem()) {
+        m_navigator->clear();
+        return;
+    }
+    
+    m_navigator->setThumbnail(m_imageViewer->thumbnail(), m_imageViewer->pixmapItem()->sceneBoundingRect());
+    updateNavigatorViewport();
+}
+
+void MainWindow::updateNavigatorViewport()
+{
+    if (!m_navigatorDock->isVisible() || !m_imageViewer->pixmapItem()) {
+        return;
+    }
+    
+    QRectF visibleRect = m_graphicsView->mapToScene(m_graphicsView->viewport()->rect()).boundingRect();
+    m_navigator->setViewportRect(visibleRect);
+}
+
+void MainWindow::toggleCompareView()
+{
+    if (m_compareViewAction->isChecked()) {
+        // 首次进入时用当前图片和第二张图片填充前两个窗格
+        if (m_compareView->paneImage(0).isEmpty() && !m_imageViewer->currentFileName().isEmpty()) {
+            m_compareView->setPaneImage(0, m_imageViewer->currentFileName());
+        }
+        if (m_compareView->paneImage(1).isEmpty() && !m_imageViewer->secondImageFileName().isEmpty()) {
+            m_compareView->setPaneImage(1, m_imageViewer->secondImageFileName());
+        }
+        m_centralStack->setCurrentWidget(m_compareView);
+    } else {
+        m_centralStack->setCurrentWidget(m_graphicsView);
+    }
+}
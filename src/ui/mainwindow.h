@@ -23,7 +23,10 @@ class MeasurementTool;
 class AngleMeasurementTool;
 class ColorPickerTool;
 class BrushTool;
+class DeskewTool;
 class ImageGraphicsView;
+class NavigatorWidget;
+class CompareView;
 
 class MainWindow : public QMainWindow
 {
@@ -47,18 +50,26 @@ private slots:
     void flipHorizontal();
     void flipVertical();
     void exportImage();
+    void onExportFinished(bool success, bool cancelled, const QString &fileName);
     void toggleMeasureMode();
     void toggleAngleMode();
     void toggleColorPickerMode();
     void toggleBrushMode();
+    void toggleDeskewMode();
     void nextImage();
     void previousImage();
     void onPaletteChanged();
     void toggleOverlayMode();
     void loadSecondImage();
     void clearSecondImage();
+    void addOverlayLayer();
+    void removeOverlayLayer();
+    void refreshLayerList();
+    void onLayerSelectionChanged();
     void onAlpha1Changed(int value);
     void onAlpha2Changed(int value);
+    void togglePerfHud();
+    void toggleCompareView();
 
 protected:
     void resizeEvent(QResizeEvent *event) override;
@@ -74,8 +85,12 @@ private:
     void createOverlayControlPanel();
     void updateOverlayPanelTheme();
     void updateToolsPanel(int toolIndex);
+    void updateNavigatorThumbnail();
+    void updateNavigatorViewport();
 
+    class QStackedWidget *m_centralStack;
     ImageGraphicsView *m_graphicsView;
+    CompareView *m_compareView;
     QGraphicsScene *m_graphicsScene;
     QLabel *m_coordinateIconLabel;
     QLabel *m_coordinateLabel;
@@ -89,12 +104,16 @@ private:
     QAction *m_angleAction;
     QAction *m_colorPickerAction;
     QAction *m_brushAction;
+    QAction *m_deskewAction;
+    QAction *m_perfHudAction;
+    QAction *m_compareViewAction;
 
     ImageViewer *m_imageViewer;
     MeasurementTool *m_measurementTool;
     AngleMeasurementTool *m_angleMeasurementTool;
     ColorPickerTool *m_colorPickerTool;
     BrushTool *m_brushTool;
+    DeskewTool *m_deskewTool;
 
     QSlider *m_zoomSlider;
     QSpinBox *m_zoomSpinBox;
@@ -115,6 +134,10 @@ private:
     QWidget *m_toolsPanel;
     class QStackedWidget *m_toolsStack;
     
+    // 导航器 DockWidget
+    QDockWidget *m_navigatorDock;
+    NavigatorWidget *m_navigator;
+    
     QLabel *m_image2PathLabel;
     QPushButton *m_loadImage2Button;
     QPushButton *m_clearImage2Button;
@@ -127,8 +150,21 @@ private:
     QSlider *m_alpha2Slider;
     QSpinBox *m_alpha2SpinBox;
     
+    class QComboBox *m_compareModeCombo;
+    class QStackedWidget *m_compareOptionsStack;
+    QSlider *m_swipeSlider;
+    
+    // 附加图层列表，最上方的行对应最上层
+    class QListWidget *m_layerList;
+    QSlider *m_layerOpacitySlider;
+    class QComboBox *m_layerBlendCombo;
+    QWidget *m_layerOptions;
+    
     // 叠加控制面板容器
     QWidget *m_overlaySettingsPanel;
+
+    // 后台导出期间显示的进度对话框，按行带进度更新，完成信号到达时关闭
+    class QProgressDialog *m_exportProgressDialog;
 };
 
 #endif // MAINWINDOW_H
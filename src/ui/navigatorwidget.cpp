@@ -0,0 +1,122 @@
+#include "navigatorwidget.h"
+
+#include <QPainter>
+#include <QMouseEvent>
+
+NavigatorWidget::NavigatorWidget(QWidget *parent)
+    : QWidget(parent)
+{
+    setMinimumSize(160, 120);
+    setCursor(Qt::PointingHandCursor);
+}
+
+void NavigatorWidget::setThumbnail(const QImage &thumbnail, const QRectF &imageSceneRect)
+{
+    m_thumbnail = thumbnail;
+    m_imageSceneRect = imageSceneRect;
+    update();
+}
+
+void NavigatorWidget::setViewportRect(const QRectF &sceneRect)
+{
+    if (m_viewportSceneRect == sceneRect) {
+        return;
+    }
+    m_viewportSceneRect = sceneRect;
+    update();
+}
+
+void NavigatorWidget::clear()
+{
+    m_thumbnail = QImage();
+    m_imageSceneRect = QRectF();
+    m_viewportSceneRect = QRectF();
+    update();
+}
+
+QSize NavigatorWidget::sizeHint() const
+{
+    return QSize(260, 200);
+}
+
+QRectF NavigatorWidget::thumbnailTargetRect() const
+{
+    if (m_thumbnail.isNull()) {
+        return QRectF();
+    }
+
+    QSizeF target = QSizeF(m_thumbnail.size()).scaled(QSizeF(size()).shrunkBy(QMarginsF(4, 4, 4, 4)),
+                                                      Qt::KeepAspectRatio);
+    QPointF topLeft((width() - target.width()) / 2.0, (height() - target.height()) / 2.0);
+    return QRectF(topLeft, target);
+}
+
+QPointF NavigatorWidget::widgetToScene(const QPointF &widgetPos) const
+{
+    QRectF target = thumbnailTargetRect();
+    if (target.isEmpty() || m_imageSceneRect.isEmpty()) {
+        return QPointF();
+    }
+
+    double rx = qBound(0.0, (widgetPos.x() - target.left()) / target.width(), 1.0);
+    double ry = qBound(0.0, (widgetPos.y() - target.top()) / target.height(), 1.0);
+    return QPointF(m_imageSceneRect.left() + rx * m_imageSceneRect.width(),
+                   m_imageSceneRect.top() + ry * m_imageSceneRect.height());
+}
+
+void NavigatorWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().window());
+
+    QRectF target = thumbnailTargetRect();
+    if (target.isEmpty() || m_imageSceneRect.isEmpty()) {
+        return;
+    }
+
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.drawImage(target, m_thumbnail);
+
+    if (m_viewportSceneRect.isEmpty()) {
+        return;
+    }
+
+    // 场景坐标映射到缩略图坐标
+    double sx = target.width() / m_imageSceneRect.width();
+    double sy = target.height() / m_imageSceneRect.height();
+    QRectF viewRect(target.left() + (m_viewportSceneRect.left() - m_imageSceneRect.left()) * sx,
+                    target.top() + (m_viewportSceneRect.top() - m_imageSceneRect.top()) * sy,
+                    m_viewportSceneRect.width() * sx,
+                    m_viewportSceneRect.height() * sy);
+    viewRect = viewRect.intersected(target);
+    if (viewRect.isEmpty()) {
+        return;
+    }
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(QColor(255, 0, 0, 230), 2));
+    painter.setBrush(QColor(255, 0, 0, 40));
+    painter.drawRect(viewRect);
+}
+
+void NavigatorWidget::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton && !m_thumbnail.isNull()) {
+        emit navigateRequested(widgetToScene(event->position()));
+        event->accept();
+        return;
+    }
+    QWidget::mousePressEvent(event);
+}
+
+void NavigatorWidget::mouseMoveEvent(QMouseEvent *event)
+{
+    if ((event->buttons() & Qt::LeftButton) && !m_thumbnail.isNull()) {
+        emit navigateRequested(widgetToScene(event->position()));
+        event->accept();
+        return;
+    }
+    QWidget::mouseMoveEvent(event);
+}
@@ -0,0 +1,45 @@
+#ifndef NAVIGATORWIDGET_H
+#define NAVIGATORWIDGET_H
+
+#include <QWidget>
+#include <QImage>
+#include <QRectF>
+#include <QPointF>
+
+/**
+ * @brief 导航器小地图
+ *
+ * 显示当前图片的缓存缩略图和视图可见区域，点击或拖动可跳转到对应位置。
+ */
+class NavigatorWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit NavigatorWidget(QWidget *parent = nullptr);
+
+    // imageSceneRect 为缩略图对应的场景区域
+    void setThumbnail(const QImage &thumbnail, const QRectF &imageSceneRect);
+    void setViewportRect(const QRectF &sceneRect);
+    void clear();
+
+    QSize sizeHint() const override;
+
+signals:
+    void navigateRequested(QPointF scenePos);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+private:
+    QRectF thumbnailTargetRect() const;
+    QPointF widgetToScene(const QPointF &widgetPos) const;
+
+    QImage m_thumbnail;
+    QRectF m_imageSceneRect;
+    QRectF m_viewportSceneRect;
+};
+
+#endif
@@ -0,0 +1,125 @@
+#include "annotationlayer.h"
+#include "utils/blendkernel.h"
+
+#include <QRgba64>
+#include <algorithm>
+
+namespace {
+
+template <typename T>
+struct SampleTraits;
+
+template <>
+struct SampleTraits<uchar> {
+    static constexpr double kMax = 255.0;
+    static uchar fromDouble(double v) { return cv::saturate_cast<uchar>(v); }
+};
+
+template <>
+struct SampleTraits<ushort> {
+    static constexpr double kMax = 65535.0;
+    static ushort fromDouble(double v) { return cv::saturate_cast<ushort>(v); }
+};
+
+// 有符号整数按 0..正向最大值取值，负值样本只会被标注颜色覆盖
+template <>
+struct SampleTraits<schar> {
+    static constexpr double kMax = 127.0;
+    static schar fromDouble(double v) { return cv::saturate_cast<schar>(v); }
+};
+
+template <>
+struct SampleTraits<short> {
+    static constexpr double kMax = 32767.0;
+    static short fromDouble(double v) { return cv::saturate_cast<short>(v); }
+};
+
+template <>
+struct SampleTraits<int> {
+    static constexpr double kMax = 2147483647.0;
+    static int fromDouble(double v) { return cv::saturate_cast<int>(v); }
+};
+
+template <>
+struct SampleTraits<float> {
+    static constexpr double kMax = 1.0;
+    static float fromDouble(double v) { return static_cast<float>(v); }
+};
+
+template <>
+struct SampleTraits<double> {
+    static constexpr double kMax = 1.0;
+    static double fromDouble(double v) { return v; }
+};
+
+template <typename T>
+void compositeRows(cv::Mat &target, const QImage &layer, int y0, int y1)
+{
+    using Traits = SampleTraits<T>;
+    // 预乘颜色与不透明度都是 0..65535，换算到目标样本的取值范围
+    constexpr double kScale = Traits::kMax / 65535.0;
+    const int channels = target.channels();
+
+    for (int y = y0; y < y1; ++y) {
+        const QRgba64 *source = reinterpret_cast<const QRgba64 *>(layer.constScanLine(y));
+        T *row = target.ptr<T>(y);
+        for (int x = 0; x < target.cols; ++x, row += channels) {
+            const QRgba64 pixel = source[x];
+            const quint16 alpha = pixel.alpha();
+            if (alpha == 0) {
+                continue;
+            }
+            const double keep = 1.0 - alpha / 65535.0;
+            if (channels == 1) {
+                double luma = 0.299 * pixel.red() + 0.587 * pixel.green() + 0.114 * pixel.blue();
+                row[0] = Traits::fromDouble(row[0] * keep + luma * kScale);
+                continue;
+            }
+            // 目标为 BGR(A) 顺序
+            row[0] = Traits::fromDouble(row[0] * keep + pixel.blue() * kScale);
+            row[1] = Traits::fromDouble(row[1] * keep + pixel.green() * kScale);
+            row[2] = Traits::fromDouble(row[2] * keep + pixel.red() * kScale);
+            if (channels == 4) {
+                row[3] = Traits::fromDouble(row[3] * keep + alpha * kScale);
+            }
+        }
+    }
+}
+
+} // namespace
+
+void compositeAnnotationLayer(cv::Mat &target, const QImage &layer)
+{
+    if (target.empty() || layer.format() != QImage::Format_RGBA64_Premultiplied
+        || layer.width() != target.cols || layer.height() != target.rows) {
+        return;
+    }
+    const int channels = target.channels();
+    if (channels != 1 && channels != 3 && channels != 4) {
+        return;
+    }
+
+    // 没有专门实现的深度（如 CV_16F）先转为 CV_32F 合成，再转回原类型
+    const int depth = target.depth();
+    if (depth != CV_8U && depth != CV_8S && depth != CV_16U && depth != CV_16S
+        && depth != CV_32S && depth != CV_32F && depth != CV_64F) {
+        cv::Mat widened;
+        target.convertTo(widened, CV_32F);
+        compositeAnnotationLayer(widened, layer);
+        widened.convertTo(target, target.type());
+        return;
+    }
+
+    parallelForBands(target.rows, [&](int y0, int y1) {
+        switch (depth) {
+        case CV_8U: compositeRows<uchar>(target, layer, y0, y1); break;
+        case CV_8S: compositeRows<schar>(target, layer, y0, y1); break;
+        case CV_16U: compositeRows<ushort>(target, layer, y0, y1); break;
+        case CV_16S: compositeRows<short>(target, layer, y0, y1); break;
+        case CV_32S: compositeRows<int>(target, layer, y0, y1); break;
+        case CV_32F: compositeRows<float>(target, layer, y0, y1); break;
+        case CV_64F: compositeRows<double>(target, layer, y0, y1); break;
+        default: break;
+        }
+    });
+}
@@ -0,0 +1,16 @@
+#ifndef ANNOTATIONLAYER_H
+#define ANNOTATIONLAYER_H
+
+#include <QImage>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief 把标注层按源图精度一趟合成到 target 上（source-over）
+ *
+ * layer 为与 target 同尺寸的 QImage::Format_RGBA64_Premultiplied，标注以 16 位精度光栅化在其中。
+ * target 可为 1/3/4 通道的任意深度：整数按 0..该类型正向最大值、浮点按 0..1 取值，
+ * 其余深度经 CV_32F 中转；单通道时标注颜色取亮度；不透明度为 0 的像素不做任何运算。
+ */
+void compositeAnnotationLayer(cv::Mat &target, const QImage &layer);
+
+#endif
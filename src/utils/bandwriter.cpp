@@ -0,0 +1,507 @@
+#include "bandwriter.h"
+
+#include <QByteArray>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#ifdef ZIV_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+// 未压缩条带约 256KB：足够让 Deflate 有效压缩，又只占很少的内存
+constexpr qint64 kStripBytes = 256 * 1024;
+// 经典 TIFF 的偏移量为 32 位，数据可能超过时改写 BigTIFF
+constexpr qint64 kClassicTiffLimit = 0xE0000000LL;
+
+template <typename T>
+void appendLittleEndian(QByteArray &out, T value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) {
+        out.append(static_cast<char>((static_cast<quint64>(value) >> (8 * i)) & 0xFF));
+    }
+}
+
+class TiffBandWriter : public BandWriter
+{
+public:
+    explicit TiffBandWriter(TiffCompression compression)
+        : m_compression(compression)
+    {
+    }
+
+    bool supportsType(int type) const override
+    {
+        int depth = CV_MAT_DEPTH(type);
+        int channels = CV_MAT_CN(type);
+        return (depth == CV_8U || depth == CV_16U || depth == CV_32F)
+               && (channels == 1 || channels == 3 || channels == 4);
+    }
+
+protected:
+    bool writeHeader() override
+    {
+        const qint64 rowBytes = static_cast<qint64>(m_width) * CV_ELEM_SIZE(m_type);
+        m_bigTiff = rowBytes * m_height > kClassicTiffLimit;
+        m_rowsPerStrip = static_cast<int>(std::clamp<qint64>(kStripBytes / std::max<qint64>(rowBytes, 1), 1, m_height));
+        m_strip.reserve(static_cast<size_t>(rowBytes * m_rowsPerStrip));
+
+        // IFD 写在文件末尾，先占位，完成时回填偏移
+        QByteArray header("II");
+        if (m_bigTiff) {
+            appendLittleEndian(header, 43, 2);
+            appendLittleEndian(header, 8, 2);
+            appendLittleEndian(header, 0, 2);
+            appendLittleEndian(header, 0, 8);
+        } else {
+            appendLittleEndian(header, 42, 2);
+            appendLittleEndian(header, 0, 4);
+        }
+        return m_device->write(header) == header.size();
+    }
+
+    bool writeRows(const cv::Mat &rows) override
+    {
+        const size_t rowBytes = rows.cols * rows.elemSize();
+        for (int y = 0; y < rows.rows; ++y) {
+            const uchar *row = rows.ptr<uchar>(y);
+            m_strip.insert(m_strip.end(), row, row + rowBytes);
+            if (++m_stripRows == m_rowsPerStrip && !flushStrip()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool writeTrailer() override
+    {
+        if (m_stripRows > 0 && !flushStrip()) {
+            return false;
+        }
+
+        const int channels = CV_MAT_CN(m_type);
+        const int depth = CV_MAT_DEPTH(m_type);
+        const quint64 bits = CV_ELEM_SIZE1(m_type) * 8;
+        const quint64 sampleFormat = depth == CV_32F ? 3 : 1;
+        const quint16 offsetType = m_bigTiff ? kLong8 : kLong;
+        const bool deflate = m_compression == TiffCompression::Deflate;
+
+        // 标签必须按编号升序
+        std::vector<Entry> entries;
+        entries.push_back({256, kLong, {static_cast<quint64>(m_width)}});
+        entries.push_back({257, kLong, {static_cast<quint64>(m_height)}});
+        entries.push_back({258, kShort, std::vector<quint64>(channels, bits)});
+        entries.push_back({259, kShort, {deflate ? 8u : 1u}});                // Deflate / 不压缩
+        entries.push_back({262, kShort, {channels == 1 ? 1u : 2u}});          // 灰度 / RGB
+        entries.push_back({273, offsetType, m_stripOffsets});
+        entries.push_back({277, kShort, {static_cast<quint64>(channels)}});
+        entries.push_back({278, kLong, {static_cast<quint64>(m_rowsPerStrip)}});
+        entries.push_back({279, offsetType, m_stripByteCounts});
+        entries.push_back({284, kShort, {1}});                                  // 像素交错存放
+        if (deflate && depth != CV_32F) {
+            entries.push_back({317, kShort, {2}});                              // 水平差分预测
+        }
+        if (channels == 4) {
+            entries.push_back({338, kShort, {2}});                              // 非预乘 alpha
+        }
+        entries.push_back({339, kShort, std::vector<quint64>(channels, sampleFormat)});
+
+        return writeIfd(entries);
+    }
+
+private:
+    static constexpr quint16 kShort = 3;
+    static constexpr quint16 kLong = 4;
+    static constexpr quint16 kLong8 = 16;
+
+    struct Entry {
+        quint16 tag;
+        quint16 type;
+        std::vector<quint64> values;
+    };
+
+    static int typeSize(quint16 type)
+    {
+        return type == kShort ? 2 : (type == kLong ? 4 : 8);
+    }
+
+    bool alignToWord()
+    {
+        if (m_device->pos() % 2 != 0) {
+            return m_device->write("\0", 1) == 1;
+        }
+        return true;
+    }
+
+    void applyPredictor()
+    {
+        // 每行从右向左做差，整数样本按样本宽度回绕
+        const int channels = CV_MAT_CN(m_type);
+        const size_t rowBytes = static_cast<size_t>(m_width) * CV_ELEM_SIZE(m_type);
+        for (int y = 0; y < m_stripRows; ++y) {
+            uchar *row = m_strip.data() + y * rowBytes;
+            if (CV_MAT_DEPTH(m_type) == CV_8U) {
+                for (size_t i = rowBytes - 1; i >= static_cast<size_t>(channels); --i) {
+                    row[i] = static_cast<uchar>(row[i] - row[i - channels]);
+                }
+            } else {
+                quint16 *samples = reinterpret_cast<quint16 *>(row);
+                for (size_t i = rowBytes / 2 - 1; i >= static_cast<size_t>(channels); --i) {
+                    samples[i] = static_cast<quint16>(samples[i] - samples[i - channels]);
+                }
+            }
+        }
+    }
+
+    bool flushStrip()
+    {
+        if (m_compression == TiffCompression::None) {
+            m_stripOffsets.push_back(static_cast<quint64>(m_device->pos()));
+            m_stripByteCounts.push_back(static_cast<quint64>(m_strip.size()));
+            if (m_device->write(reinterpret_cast<const char *>(m_strip.data()), static_cast<qint64>(m_strip.size()))
+                != static_cast<qint64>(m_strip.size())) {
+                return false;
+            }
+            m_strip.clear();
+            m_stripRows = 0;
+            return true;
+        }
+
+        if (CV_MAT_DEPTH(m_type) != CV_32F) {
+            applyPredictor();
+        }
+        // qCompress 输出为 4 字节长度前缀加标准 zlib 流，TIFF 只需要后者
+        QByteArray compressed = qCompress(m_strip.data(), static_cast<qsizetype>(m_strip.size()));
+        if (compressed.size() <= 4) {
+            return false;
+        }
+        m_stripOffsets.push_back(static_cast<quint64>(m_device->pos()));
+        m_stripByteCounts.push_back(static_cast<quint64>(compressed.size() - 4));
+        if (m_device->write(compressed.constData() + 4, compressed.size() - 4) != compressed.size() - 4) {
+            return false;
+        }
+        m_strip.clear();
+        m_stripRows = 0;
+        return true;
+    }
+
+    bool writeIfd(std::vector<Entry> &entries)
+    {
+        const int inlineBytes = m_bigTiff ? 8 : 4;
+        const int countBytes = m_bigTiff ? 8 : 4;
+
+        // 放不进条目本身的数组先写在 IFD 之前
+        std::vector<quint64> valueOffsets(entries.size(), 0);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const Entry &entry = entries[i];
+            const int size = typeSize(entry.type);
+            if (static_cast<qint64>(entry.values.size()) * size <= inlineBytes) {
+                continue;
+            }
+            if (!alignToWord()) {
+                return false;
+            }
+            valueOffsets[i] = static_cast<quint64>(m_device->pos());
+            QByteArray data;
+            data.reserve(static_cast<qsizetype>(entry.values.size()) * size);
+            for (quint64 value : entry.values) {
+                appendLittleEndian(data, value, size);
+            }
+            if (m_device->write(data) != data.size()) {
+                return false;
+            }
+        }
+
+        if (!alignToWord()) {
+            return false;
+        }
+        const quint64 ifdOffset = static_cast<quint64>(m_device->pos());
+        QByteArray ifd;
+        appendLittleEndian(ifd, entries.size(), m_bigTiff ? 8 : 2);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const Entry &entry = entries[i];
+            const int size = typeSize(entry.type);
+            appendLittleEndian(ifd, entry.tag, 2);
+            appendLittleEndian(ifd, entry.type, 2);
+            appendLittleEndian(ifd, entry.values.size(), countBytes);
+            if (static_cast<qint64>(entry.values.size()) * size <= inlineBytes) {
+                QByteArray value;
+                for (quint64 v : entry.values) {
+                    appendLittleEndian(value, v, size);
+                }
+                value.append(QByteArray(inlineBytes - value.size(), '\0'));
+                ifd.append(value);
+            } else {
+                appendLittleEndian(ifd, valueOffsets[i], inlineBytes);
+            }
+        }
+        appendLittleEndian(ifd, 0, inlineBytes);
+        if (m_device->write(ifd) != ifd.size()) {
+            return false;
+        }
+
+        QByteArray offset;
+        appendLittleEndian(offset, ifdOffset, inlineBytes);
+        return m_device->seek(m_bigTiff ? 8 : 4) && m_device->write(offset) == offset.size();
+    }
+
+    TiffCompression m_compression;
+    bool m_bigTiff = false;
+    int m_rowsPerStrip = 1;
+    int m_stripRows = 0;
+    std::vector<uchar> m_strip;
+    std::vector<quint64> m_stripOffsets;
+    std::vector<quint64> m_stripByteCounts;
+};
+
+#ifdef ZIV_HAVE_ZLIB
+
+// PNG 的 IDAT 是单个 zlib 流，逐行带喂给同一个 deflate 流，输出缓冲区满时写出一个 IDAT 块
+class PngBandWriter : public BandWriter
+{
+public:
+    explicit PngBandWriter(int compressionLevel)
+        : m_compressionLevel(compressionLevel)
+    {
+    }
+
+    ~PngBandWriter() override
+    {
+        if (m_streamInitialized) {
+            deflateEnd(&m_stream);
+        }
+    }
+
+    bool supportsType(int type) const override
+    {
+        int depth = CV_MAT_DEPTH(type);
+        int channels = CV_MAT_CN(type);
+        return (depth == CV_8U || depth == CV_16U) && (channels == 1 || channels == 3 || channels == 4);
+    }
+
+protected:
+    bool writeHeader() override
+    {
+        static const char signature[8] = {'\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n'};
+        if (m_device->write(signature, 8) != 8) {
+            return false;
+        }
+
+        const int channels = CV_MAT_CN(m_type);
+        QByteArray ihdr;
+        appendBigEndian(ihdr, static_cast<quint32>(m_width));
+        appendBigEndian(ihdr, static_cast<quint32>(m_height));
+        ihdr.append(static_cast<char>(CV_ELEM_SIZE1(m_type) * 8));
+        ihdr.append(static_cast<char>(channels == 1 ? 0 : (channels == 3 ? 2 : 6)));
+        ihdr.append(3, '\0');   // 压缩方式、滤波方式、不隔行
+        if (!writeChunk("IHDR", ihdr)) {
+            return false;
+        }
+
+        std::memset(&m_stream, 0, sizeof(m_stream));
+        if (deflateInit(&m_stream, m_compressionLevel) != Z_OK) {
+            return false;
+        }
+        m_streamInitialized = true;
+        m_output.resize(kOutputBytes);
+        m_stream.next_out = reinterpret_cast<Bytef *>(m_output.data());
+        m_stream.avail_out = static_cast<uInt>(m_output.size());
+        return true;
+    }
+
+    bool writeRows(const cv::Mat &rows) override
+    {
+        const int pixelBytes = static_cast<int>(rows.elemSize());
+        const size_t rowBytes = rows.cols * rows.elemSize();
+        const bool wide = rows.elemSize1() == 2;
+        m_row.resize(rowBytes);
+        m_filtered.resize(rowBytes + 1);
+
+        for (int y = 0; y < rows.rows; ++y) {
+            const uchar *source = rows.ptr<uchar>(y);
+            // PNG 的 16 位样本为大端序
+            if (wide) {
+                for (size_t i = 0; i < rowBytes; i += 2) {
+                    m_row[i] = source[i + 1];
+                    m_row[i + 1] = source[i];
+                }
+            } else {
+                std::memcpy(m_row.data(), source, rowBytes);
+            }
+
+            // Sub 滤波：只依赖本行，行带之间不需要保留状态
+            m_filtered[0] = 1;
+            for (size_t i = 0; i < rowBytes; ++i) {
+                uchar left = i >= static_cast<size_t>(pixelBytes) ? m_row[i - pixelBytes] : 0;
+                m_filtered[i + 1] = static_cast<uchar>(m_row[i] - left);
+            }
+            if (!deflateData(m_filtered.data(), m_filtered.size(), Z_NO_FLUSH)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool writeTrailer() override
+    {
+        if (!deflateData(nullptr, 0, Z_FINISH)) {
+            return false;
+        }
+        if (!flushOutput()) {
+            return false;
+        }
+        deflateEnd(&m_stream);
+        m_streamInitialized = false;
+        return writeChunk("IEND", QByteArray());
+    }
+
+private:
+    static constexpr size_t kOutputBytes = 256 * 1024;
+
+    static void appendBigEndian(QByteArray &out, quint32 value)
+    {
+        out.append(static_cast<char>((value >> 24) & 0xFF));
+        out.append(static_cast<char>((value >> 16) & 0xFF));
+        out.append(static_cast<char>((value >> 8) & 0xFF));
+        out.append(static_cast<char>(value & 0xFF));
+    }
+
+    bool writeChunk(const char *type, const QByteArray &data)
+    {
+        QByteArray chunk;
+        chunk.reserve(data.size() + 12);
+        appendBigEndian(chunk, static_cast<quint32>(data.size()));
+        chunk.append(type, 4);
+        chunk.append(data);
+        uLong crc = crc32(0L, reinterpret_cast<const Bytef *>(chunk.constData() + 4),
+                          static_cast<uInt>(data.size() + 4));
+        appendBigEndian(chunk, static_cast<quint32>(crc));
+        return m_device->write(chunk) == chunk.size();
+    }
+
+    bool flushOutput()
+    {
+        size_t produced = m_output.size() - m_stream.avail_out;
+        if (produced > 0) {
+            QByteArray data = QByteArray::fromRawData(m_output.data(), static_cast<qsizetype>(produced));
+            if (!writeChunk("IDAT", data)) {
+                return false;
+            }
+        }
+        m_stream.next_out = reinterpret_cast<Bytef *>(m_output.data());
+        m_stream.avail_out = static_cast<uInt>(m_output.size());
+        return true;
+    }
+
+    bool deflateData(const uchar *data, size_t size, int flush)
+    {
+        m_stream.next_in = const_cast<Bytef *>(data);
+        m_stream.avail_in = static_cast<uInt>(size);
+        while (true) {
+            int status = deflate(&m_stream, flush);
+            if (status == Z_STREAM_ERROR) {
+                return false;
+            }
+            if (m_stream.avail_out == 0) {
+                if (!flushOutput()) {
+                    return false;
+                }
+                continue;
+            }
+            if (flush == Z_FINISH ? status == Z_STREAM_END : m_stream.avail_in == 0) {
+                return true;
+            }
+        }
+    }
+
+    int m_compressionLevel;
+    z_stream m_stream;
+    bool m_streamInitialized = false;
+    std::vector<char> m_output;
+    std::vector<uchar> m_row;
+    std::vector<uchar> m_filtered;
+};
+
+#endif // ZIV_HAVE_ZLIB
+
+} // namespace
+
+BandWriter::~BandWriter() = default;
+
+bool BandWriter::open(const QString &fileName, int width, int height, int type)
+{
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    return open(&m_file, width, height, type);
+}
+
+bool BandWriter::open(QIODevice *device, int width, int height, int type)
+{
+    if (!device || !device->isWritable() || width <= 0 || height <= 0 || !supportsType(type)) {
+        return false;
+    }
+    m_device = device;
+    m_width = width;
+    m_height = height;
+    m_type = type;
+    m_rowsWritten = 0;
+    return writeHeader();
+}
+
+bool BandWriter::writeBand(const cv::Mat &band)
+{
+    if (!m_device || band.type() != m_type || band.cols != m_width
+        || m_rowsWritten + band.rows > m_height) {
+        return false;
+    }
+
+    // 文件按 RGB(A) 顺序存放，转换结果同时保证行连续
+    cv::Mat rows;
+    if (band.channels() == 3) {
+        cv::cvtColor(band, rows, cv::COLOR_BGR2RGB);
+    } else if (band.channels() == 4) {
+        cv::cvtColor(band, rows, cv::COLOR_BGRA2RGBA);
+    } else {
+        rows = band;
+    }
+    if (!writeRows(rows)) {
+        return false;
+    }
+    m_rowsWritten += band.rows;
+    return true;
+}
+
+bool BandWriter::finish()
+{
+    if (!m_device || m_rowsWritten != m_height) {
+        return false;
+    }
+    bool ok = writeTrailer();
+    m_device = nullptr;
+    if (m_file.isOpen()) {
+        if (ok) {
+            ok = m_file.commit();
+        } else {
+            m_file.cancelWriting();
+        }
+    }
+    return ok;
+}
+
+std::unique_ptr<BandWriter> createBandWriter(const QString &suffix, const ExportOptions &options)
+{
+    QString lower = suffix.toLower();
+    if (lower == "tif" || lower == "tiff") {
+        return std::make_unique<TiffBandWriter>(options.tiffCompression);
+    }
+#ifdef ZIV_HAVE_ZLIB
+    if (lower == "png") {
+        return std::make_unique<PngBandWriter>(std::clamp(options.pngCompression, 0, 9));
+    }
+#endif
+    return nullptr;
+}
@@ -0,0 +1,48 @@
+#ifndef BANDWRITER_H
+#define BANDWRITER_H
+
+#include <QIODevice>
+#include <QSaveFile>
+#include <QString>
+#include <memory>
+#include <opencv2/opencv.hpp>
+
+#include "utils/exportencoder.h"
+
+/**
+ * @brief 按自上而下的行带写出图像文件，整幅图像不必同时存在于内存中
+ *
+ * 行带为灰度、BGR 或 BGRA，行数任意，按顺序依次传入；写出器只缓存一个条带，
+ * 编码后立即写入文件或设备（设备需可随机访问）。按文件名打开时先写入同目录的临时文件，
+ * finish() 成功后才替换目标文件；中途失败或放弃时原有文件保持不变。
+ */
+class BandWriter
+{
+public:
+    virtual ~BandWriter();
+
+    virtual bool supportsType(int type) const = 0;
+
+    bool open(const QString &fileName, int width, int height, int type);
+    bool open(QIODevice *device, int width, int height, int type);
+    bool writeBand(const cv::Mat &band);
+    bool finish();
+
+protected:
+    virtual bool writeHeader() = 0;
+    // rows 已转换为文件的通道顺序
+    virtual bool writeRows(const cv::Mat &rows) = 0;
+    virtual bool writeTrailer() = 0;
+
+    QSaveFile m_file;
+    QIODevice *m_device = nullptr;
+    int m_width = 0;
+    int m_height = 0;
+    int m_type = 0;
+    int m_rowsWritten = 0;
+};
+
+// 返回该后缀可流式写出的写出器；不支持的格式返回空指针，调用方退回整幅编码
+std::unique_ptr<BandWriter> createBandWriter(const QString &suffix, const ExportOptions &options);
+
+#endif
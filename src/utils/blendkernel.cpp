@@ -0,0 +1,194 @@
+#include "blendkernel.h"
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ZIV_HAS_SSE2 1
+#include <immintrin.h>
+#endif
+
+#if defined(ZIV_HAS_SSE2) && defined(__GNUC__)
+#define ZIV_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define ZIV_TARGET_AVX2
+#endif
+
+namespace {
+
+// 权重量化到 0..128，两路乘积之和不超过 16 位无符号范围
+constexpr int kWeightShift = 7;
+constexpr int kWeightOne = 1 << kWeightShift;
+constexpr quint32 kOpaqueAlpha = 0xFF000000u;
+
+using BlendRowFunc = void (*)(const uchar *a, const uchar *b, uchar *dst, int pixels, int w1, int w2);
+
+inline uchar blendScalar(uchar a, uchar b, int w1, int w2)
+{
+    int value = (a * w1 + b * w2 + (kWeightOne >> 1)) >> kWeightShift;
+    return static_cast<uchar>(std::min(value, 255));
+}
+
+void blendRowScalar(const uchar *a, const uchar *b, uchar *dst, int pixels, int w1, int w2)
+{
+    for (int i = 0; i < pixels; ++i) {
+        dst[0] = blendScalar(a[0], b[0], w1, w2);
+        dst[1] = blendScalar(a[1], b[1], w1, w2);
+        dst[2] = blendScalar(a[2], b[2], w1, w2);
+        dst[3] = 255;
+        a += 4;
+        b += 4;
+        dst += 4;
+    }
+}
+
+#ifdef ZIV_HAS_SSE2
+
+void blendRowSse2(const uchar *a, const uchar *b, uchar *dst, int pixels, int w1, int w2)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weight1 = _mm_set1_epi16(static_cast<short>(w1));
+    const __m128i weight2 = _mm_set1_epi16(static_cast<short>(w2));
+    const __m128i round = _mm_set1_epi16(kWeightOne >> 1);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(kOpaqueAlpha));
+
+    int i = 0;
+    for (; i + 4 <= pixels; i += 4) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i * 4));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i * 4));
+
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), weight1),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), weight2));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), weight1),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), weight2));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, round), kWeightShift);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, round), kWeightShift);
+
+        __m128i result = _mm_or_si128(_mm_packus_epi16(lo, hi), alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), result);
+    }
+
+    blendRowScalar(a + i * 4, b + i * 4, dst + i * 4, pixels - i, w1, w2);
+}
+
+ZIV_TARGET_AVX2
+void blendRowAvx2(const uchar *a, const uchar *b, uchar *dst, int pixels, int w1, int w2)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i weight1 = _mm256_set1_epi16(static_cast<short>(w1));
+    const __m256i weight2 = _mm256_set1_epi16(static_cast<short>(w2));
+    const __m256i round = _mm256_set1_epi16(kWeightOne >> 1);
+    const __m256i alpha = _mm256_set1_epi32(static_cast<int>(kOpaqueAlpha));
+
+    // unpack 与 packus 都按 128 位通道独立进行，结果顺序与输入一致
+    int i = 0;
+    for (; i + 8 <= pixels; i += 8) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i * 4));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i * 4));
+
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(va, zero), weight1),
+                                      _mm256_mullo_epi16(_mm256_unpacklo_epi8(vb, zero), weight2));
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(va, zero), weight1),
+                                      _mm256_mullo_epi16(_mm256_unpackhi_epi8(vb, zero), weight2));
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, round), kWeightShift);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, round), kWeightShift);
+
+        __m256i result = _mm256_or_si256(_mm256_packus_epi16(lo, hi), alpha);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4), result);
+    }
+
+    blendRowSse2(a + i * 4, b + i * 4, dst + i * 4, pixels - i, w1, w2);
+}
+
+#endif
+
+void lutRow(const uchar *src, const ChannelLut &lut, uchar *dst, int pixels)
+{
+    for (int i = 0; i < pixels; ++i, src += 4, dst += 4) {
+        dst[0] = lut.table[0][src[0]];
+        dst[1] = lut.table[1][src[1]];
+        dst[2] = lut.table[2][src[2]];
+        dst[3] = src[3];
+    }
+}
+
+BlendRowFunc selectBlendRow()
+{
+#ifdef ZIV_HAS_SSE2
+    if (cv::checkHardwareSupport(CV_CPU_AVX2)) {
+        return &blendRowAvx2;
+    }
+    return &blendRowSse2;
+#else
+    return &blendRowScalar;
+#endif
+}
+
+// 指定指令集的实现，不支持时返回空指针
+BlendRowFunc blendRowFor(BlendIsa isa)
+{
+    switch (isa) {
+    case BlendIsa::Scalar:
+        return &blendRowScalar;
+#ifdef ZIV_HAS_SSE2
+    case BlendIsa::Sse2:
+        return &blendRowSse2;
+    case BlendIsa::Avx2:
+        return cv::checkHardwareSupport(CV_CPU_AVX2) ? &blendRowAvx2 : nullptr;
+#endif
+    case BlendIsa::Auto:
+        return selectBlendRow();
+    default:
+        return nullptr;
+    }
+}
+
+} // namespace
+
+bool isBlendIsaSupported(BlendIsa isa)
+{
+    return blendRowFor(isa) != nullptr;
+}
+
+void blendBgra(const cv::Mat &src1, double alpha1, const cv::Mat &src2, double alpha2, cv::Mat &dst,
+               const ChannelLut *lut2, BlendIsa isa)
+{
+    CV_Assert(src1.type() == CV_8UC4 && src2.type() == CV_8UC4 && src1.size() == src2.size());
+    static const BlendRowFunc autoBlendRow = selectBlendRow();
+    const BlendRowFunc blendRow = isa == BlendIsa::Auto ? autoBlendRow : blendRowFor(isa);
+    CV_Assert(blendRow != nullptr);
+    dst.create(src1.size(), CV_8UC4);
+
+    const int w1 = qBound(0, qRound(alpha1 * kWeightOne), kWeightOne);
+    const int w2 = qBound(0, qRound(alpha2 * kWeightOne), kWeightOne);
+    const int width = src1.cols;
+
+    parallelForBands(src1.rows, [&](int y0, int y1) {
+        std::vector<uchar> rowBuffer(lut2 ? static_cast<size_t>(width) * 4 : 0);
+        for (int y = y0; y < y1; ++y) {
+            const uchar *row2 = src2.ptr<uchar>(y);
+            if (lut2) {
+                lutRow(row2, *lut2, rowBuffer.data(), width);
+                row2 = rowBuffer.data();
+            }
+            blendRow(src1.ptr<uchar>(y), row2, dst.ptr<uchar>(y), width, w1, w2);
+        }
+    });
+}
+
+void applyChannelLut(const cv::Mat &src, const ChannelLut &lut, cv::Mat &dst)
+{
+    CV_Assert(src.type() == CV_8UC4);
+    dst.create(src.size(), CV_8UC4);
+
+    parallelForBands(src.rows, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            lutRow(src.ptr<uchar>(y), lut, dst.ptr<uchar>(y), src.cols);
+        }
+    });
+}
+
+cv::Mat wrapQImage(QImage &image)
+{
+    return cv::Mat(image.height(), image.width(), CV_8UC4, image.bits(), image.bytesPerLine());
+}
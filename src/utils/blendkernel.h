@@ -0,0 +1,54 @@
+#ifndef BLENDKERNEL_H
+#define BLENDKERNEL_H
+
+#include <QImage>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+
+// 逐像素内核按行带并行的默认行带高度：足够摊薄调度开销，又能在各线程间均匀分配
+constexpr int kBandHeight = 64;
+
+// 把 [0, rows) 切成 bandHeight 行的行带，由 cv::parallel_for_ 分发，
+// 每个行带调用一次 body(y0, y1)。各行带互不重叠，body 只需保证行带之间无数据竞争
+template <typename Body>
+void parallelForBands(int rows, Body &&body, int bandHeight = kBandHeight)
+{
+    const int bandCount = (rows + bandHeight - 1) / bandHeight;
+    cv::parallel_for_(cv::Range(0, bandCount), [&](const cv::Range &range) {
+        for (int band = range.start; band < range.end; ++band) {
+            int y0 = band * bandHeight;
+            body(y0, std::min(y0 + bandHeight, rows));
+        }
+    });
+}
+
+// B、G、R 三个通道各自的 256 项查找表，alpha 通道不查表
+struct ChannelLut {
+    uchar table[3][256];
+};
+
+// 行内混合使用的指令集。Auto 在运行时选择可用的最快实现，其余取值供 ziv_bench 强制指定
+enum class BlendIsa {
+    Auto = 0,
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+// 当前构建和 CPU 是否能运行 isa 对应的实现
+bool isBlendIsaSupported(BlendIsa isa);
+
+// 按 alpha1/alpha2 混合两幅 CV_8UC4（BGRA）图像，结果 alpha 恒为 255。
+// dst 可以是包装 QImage::Format_RGB32 缓冲区的 cv::Mat，混合与输出格式一趟完成。
+// 按行带并行，行内使用 AVX2/SSE2（不可用时退回标量实现）。
+// lut2 非空时 src2 的每一行先查表到行缓冲区再混合，不生成整幅副本。
+void blendBgra(const cv::Mat &src1, double alpha1, const cv::Mat &src2, double alpha2, cv::Mat &dst,
+               const ChannelLut *lut2 = nullptr, BlendIsa isa = BlendIsa::Auto);
+
+// 对 CV_8UC4 图像逐像素查表，dst 与 src 可以相同
+void applyChannelLut(const cv::Mat &src, const ChannelLut &lut, cv::Mat &dst);
+
+// 包装 QImage 缓冲区为 CV_8UC4，不拷贝
+cv::Mat wrapQImage(QImage &image);
+
+#endif
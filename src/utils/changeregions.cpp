@@ -0,0 +1,71 @@
+#include "changeregions.h"
+#include "utils/blendkernel.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+cv::Mat thresholdDelta(const cv::Mat &a, const ComparedImage &b, int threshold)
+{
+    cv::Mat mask(a.size(), CV_8UC1);
+    parallelForBands(a.rows, [&](int y0, int y1) {
+        cv::Mat bandB = b.region(cv::Rect(0, y0, a.cols, y1 - y0));
+        for (int y = y0; y < y1; ++y) {
+            const uchar *pa = a.ptr<uchar>(y);
+            const uchar *pb = bandB.ptr<uchar>(y - y0);
+            uchar *out = mask.ptr<uchar>(y);
+            for (int x = 0; x < a.cols; ++x, pa += 4, pb += 4) {
+                // 画布填充和配准后落在图外的区域（alpha 为 0）不算变化
+                if (pa[3] == 0 || pb[3] == 0) {
+                    out[x] = 0;
+                    continue;
+                }
+                int delta = std::max({std::abs(pa[0] - pb[0]),
+                                      std::abs(pa[1] - pb[1]),
+                                      std::abs(pa[2] - pb[2])});
+                out[x] = delta > threshold ? 255 : 0;
+            }
+        }
+    });
+    return mask;
+}
+
+} // namespace
+
+std::vector<ChangedRegion> detectChangedRegions(const cv::Mat &a, const ComparedImage &b,
+                                                int threshold, int minArea)
+{
+    std::vector<ChangedRegion> regions;
+    if (a.empty() || a.type() != CV_8UC4 || b.image.type() != CV_8UC4 || a.size() != b.image.size()) {
+        return regions;
+    }
+
+    cv::Mat mask = thresholdDelta(a, b, threshold);
+
+    // 默认算法对 8 连通使用并行的块标记实现
+    cv::Mat labels, stats, centroids;
+    int count = cv::connectedComponentsWithStats(mask, labels, stats, centroids, 8, CV_32S);
+
+    for (int label = 1; label < count; ++label) {
+        int area = stats.at<int>(label, cv::CC_STAT_AREA);
+        if (area < minArea) {
+            continue;
+        }
+        ChangedRegion region;
+        region.bounds = QRect(stats.at<int>(label, cv::CC_STAT_LEFT),
+                              stats.at<int>(label, cv::CC_STAT_TOP),
+                              stats.at<int>(label, cv::CC_STAT_WIDTH),
+                              stats.at<int>(label, cv::CC_STAT_HEIGHT));
+        region.area = area;
+        regions.push_back(region);
+    }
+
+    std::sort(regions.begin(), regions.end(), [](const ChangedRegion &lhs, const ChangedRegion &rhs) {
+        if (lhs.bounds.top() != rhs.bounds.top()) {
+            return lhs.bounds.top() < rhs.bounds.top();
+        }
+        return lhs.bounds.left() < rhs.bounds.left();
+    });
+    return regions;
+}
@@ -0,0 +1,25 @@
+#ifndef CHANGEREGIONS_H
+#define CHANGEREGIONS_H
+
+#include <QRect>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "utils/comparedimage.h"
+
+struct ChangedRegion {
+    QRect bounds;
+    qint64 area = 0;        // 区域内超过阈值的像素数
+};
+
+/**
+ * @brief 提取两幅同尺寸 CV_8UC4（BGRA）图像之间的连通变化区域
+ *
+ * 逐像素取 BGR 三通道差的最大值与 threshold 比较，按行带并行生成掩膜，
+ * b 只在各自的行带上取区域，不生成整幅副本；任一输入 alpha 为 0 的像素不计为变化。
+ * 再做 8 连通标记。面积小于 minArea 的区域被忽略，结果按从上到下、从左到右排序。
+ */
+std::vector<ChangedRegion> detectChangedRegions(const cv::Mat &a, const ComparedImage &b,
+                                                int threshold, int minArea);
+
+#endif
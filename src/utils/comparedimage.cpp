@@ -0,0 +1,14 @@
+#include "comparedimage.h"
+#include "utils/registration.h"
+
+cv::Mat ComparedImage::region(const cv::Rect &roi) const
+{
+    cv::Mat area = registered ? registeredRegion(image, registration, roi, 1) : image(roi);
+    if (!normalized) {
+        return area;
+    }
+    // 查表写入新的区域缓冲区，不能改写 image 本身
+    cv::Mat result;
+    applyChannelLut(area, lut, result);
+    return result;
+}
@@ -0,0 +1,25 @@
+#ifndef COMPAREDIMAGE_H
+#define COMPAREDIMAGE_H
+
+#include <opencv2/opencv.hpp>
+
+#include "utils/blendkernel.h"
+
+/**
+ * @brief 后台分析中与参考图比较的第二张图片
+ *
+ * 配准变换与曝光查找表只在取区域时作用于该区域，不生成整幅配准或归一化副本；
+ * region() 只读，可在 cv::parallel_for_ 的多个线程中同时调用。
+ */
+struct ComparedImage {
+    cv::Mat image;                  // CV_8UC4（BGRA），与参考图同尺寸
+    bool registered = false;
+    cv::Matx33d registration = cv::Matx33d::eye();
+    bool normalized = false;
+    ChannelLut lut;
+
+    // 返回参考图坐标下 roi 对应的 CV_8UC4 区域；既未配准也未归一化时不拷贝
+    cv::Mat region(const cv::Rect &roi) const;
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include "comparemodes.h"
+#include "utils/blendkernel.h"
+
+#include <algorithm>
+
+namespace {
+
+const cv::Scalar kOpaqueAlpha(0, 0, 0, 255);
+
+// 直接复制 a 的区域，同时把 alpha 置为 255
+void copyOpaque(const cv::Mat &source, cv::Mat &&target)
+{
+    blendBgra(source, 1.0, source, 0.0, target);
+}
+
+const cv::Mat &heatmapLut()
+{
+    // 256 项伪彩色查找表，只生成一次
+    static const cv::Mat lut = []() {
+        cv::Mat ramp(1, 256, CV_8UC1);
+        for (int i = 0; i < 256; ++i) {
+            ramp.at<uchar>(0, i) = static_cast<uchar>(i);
+        }
+        cv::Mat colored;
+        cv::applyColorMap(ramp, colored, cv::COLORMAP_JET);
+        cv::Mat bgra;
+        cv::cvtColor(colored, bgra, cv::COLOR_BGR2BGRA);
+        return bgra;
+    }();
+    return lut;
+}
+
+} // namespace
+
+void renderDifference(const cv::Mat &a, const cv::Mat &b, double gain, bool heatmap, cv::Mat &dst)
+{
+    cv::Mat diff;
+    cv::absdiff(a, b, diff);
+
+    if (!heatmap) {
+        diff.convertTo(dst, CV_8UC4, gain);
+        cv::bitwise_or(dst, kOpaqueAlpha, dst);
+        return;
+    }
+
+    const cv::Vec4b *lut = heatmapLut().ptr<cv::Vec4b>(0);
+    const int scale = qRound(gain * 256.0);
+    for (int y = 0; y < diff.rows; ++y) {
+        const cv::Vec4b *src = diff.ptr<cv::Vec4b>(y);
+        cv::Vec4b *out = dst.ptr<cv::Vec4b>(y);
+        for (int x = 0; x < diff.cols; ++x) {
+            int magnitude = std::max({src[x][0], src[x][1], src[x][2]});
+            out[x] = lut[std::min(255, (magnitude * scale) >> 8)];
+        }
+    }
+}
+
+void renderSwipe(const cv::Mat &a, const cv::Mat &b, int dividerX, cv::Mat &dst)
+{
+    int split = std::clamp(dividerX, 0, a.cols);
+    if (split > 0) {
+        copyOpaque(a.colRange(0, split), dst.colRange(0, split));
+    }
+    if (split < a.cols) {
+        copyOpaque(b.colRange(split, a.cols), dst.colRange(split, a.cols));
+    }
+}
+
+void renderCheckerboard(const cv::Mat &a, const cv::Mat &b, const QPoint &origin, int level,
+                        int cellSize, cv::Mat &dst)
+{
+    copyOpaque(a, cv::Mat(dst));
+
+    // 格子边界换算到瓦片内的降采样坐标，奇数格取 b
+    cellSize = std::max(1, cellSize);
+    int firstCellX = origin.x() / cellSize;
+    int firstCellY = origin.y() / cellSize;
+    int lastCellX = (origin.x() + a.cols * level - 1) / cellSize;
+    int lastCellY = (origin.y() + a.rows * level - 1) / cellSize;
+
+    for (int cy = firstCellY; cy <= lastCellY; ++cy) {
+        int y0 = std::max(0, (cy * cellSize - origin.y()) / level);
+        int y1 = std::min(a.rows, ((cy + 1) * cellSize - origin.y() + level - 1) / level);
+        if (y1 <= y0) {
+            continue;
+        }
+        for (int cx = firstCellX; cx <= lastCellX; ++cx) {
+            if (((cx + cy) & 1) == 0) {
+                continue;
+            }
+            int x0 = std::max(0, (cx * cellSize - origin.x()) / level);
+            int x1 = std::min(a.cols, ((cx + 1) * cellSize - origin.x() + level - 1) / level);
+            if (x1 <= x0) {
+                continue;
+            }
+            cv::Rect cell(x0, y0, x1 - x0, y1 - y0);
+            copyOpaque(b(cell), dst(cell));
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef COMPAREMODES_H
+#define COMPAREMODES_H
+
+#include <QPoint>
+#include <opencv2/opencv.hpp>
+
+// 以下函数都作用于单个瓦片：a、b 为同尺寸 CV_8UC4 输入，
+// dst 为同尺寸 CV_8UC4 输出（可包装 Format_RGB32 的 QImage），alpha 恒为 255。
+
+// 绝对差放大 gain 倍；heatmap 为真时取通道最大差值映射为伪彩色
+void renderDifference(const cv::Mat &a, const cv::Mat &b, double gain, bool heatmap, cv::Mat &dst);
+
+// dividerX 为分割线在瓦片内的列坐标，左侧取 a，右侧取 b
+void renderSwipe(const cv::Mat &a, const cv::Mat &b, int dividerX, cv::Mat &dst);
+
+// origin 为瓦片左上角的画布坐标，level 为降采样倍数，cellSize 为画布像素下的格子边长
+void renderCheckerboard(const cv::Mat &a, const cv::Mat &b, const QPoint &origin, int level,
+                        int cellSize, cv::Mat &dst);
+
+#endif
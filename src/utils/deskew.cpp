@@ -0,0 +1,115 @@
+#include "deskew.h"
+#include "utils/matconvert.h"
+#include "utils/blendkernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+constexpr int kWarpBandHeight = 256;
+constexpr int kSkewAnalysisSize = 1024;
+constexpr double kMaxSkewDegrees = 45.0;
+
+} // namespace
+
+cv::Matx23d toAffineMatrix(const QTransform &dstToSrc)
+{
+    // QTransform: x' = m11 * x + m21 * y + dx, y' = m12 * x + m22 * y + dy
+    return cv::Matx23d(dstToSrc.m11(), dstToSrc.m21(), dstToSrc.dx(),
+                       dstToSrc.m12(), dstToSrc.m22(), dstToSrc.dy());
+}
+
+cv::Mat warpAffineParallel(const cv::Mat &source, const cv::Matx23d &dstToSrc, cv::Size dstSize)
+{
+    if (source.empty() || dstSize.empty()) {
+        return cv::Mat();
+    }
+
+    cv::Mat result(dstSize, source.type());
+
+    // 每个行带是一次独立的 warpAffine，只需把行带起点折算进平移项
+    parallelForBands(dstSize.height, [&](int y0, int y1) {
+        cv::Matx23d bandMatrix = dstToSrc;
+        bandMatrix(0, 2) += dstToSrc(0, 1) * y0;
+        bandMatrix(1, 2) += dstToSrc(1, 1) * y0;
+
+        cv::Mat bandResult = result.rowRange(y0, y1);
+        cv::warpAffine(source, bandResult, bandMatrix, bandResult.size(),
+                       cv::INTER_LINEAR | cv::WARP_INVERSE_MAP, cv::BORDER_CONSTANT);
+    }, kWarpBandHeight);
+
+    return result;
+}
+
+double estimateSkewAngle(const cv::Mat &image, const Orientation &orientation)
+{
+    if (image.empty()) {
+        return 0.0;
+    }
+
+    // 先缩小再烘焙方向，分析只需要较低分辨率
+    cv::Mat gray = toDisplayDepth(image);
+    if (gray.channels() == 3) {
+        cv::cvtColor(gray, gray, cv::COLOR_BGR2GRAY);
+    } else if (gray.channels() == 4) {
+        cv::cvtColor(gray, gray, cv::COLOR_BGRA2GRAY);
+    }
+
+    int longSide = std::max(gray.cols, gray.rows);
+    if (longSide > kSkewAnalysisSize) {
+        double factor = static_cast<double>(kSkewAnalysisSize) / longSide;
+        cv::resize(gray, gray, cv::Size(), factor, factor, cv::INTER_AREA);
+    }
+    gray = orientation.apply(gray);
+
+    cv::Mat edges;
+    cv::Canny(gray, edges, 50, 150);
+
+    std::vector<cv::Vec4i> lines;
+    int minLength = std::max(20, std::min(gray.cols, gray.rows) / 8);
+    cv::HoughLinesP(edges, lines, 1, CV_PI / 1800.0, 80, minLength, 10);
+
+    // 接近水平的线取与水平方向的夹角，接近竖直的线取与竖直方向的夹角，
+    // 按线段长度加权取中位数
+    std::vector<std::pair<double, double>> angles;
+    angles.reserve(lines.size());
+    double totalWeight = 0.0;
+    for (const cv::Vec4i &line : lines) {
+        double dx = line[2] - line[0];
+        double dy = line[3] - line[1];
+        double angle = std::atan2(dy, dx) * 180.0 / CV_PI;
+        if (angle > 90.0) {
+            angle -= 180.0;
+        } else if (angle <= -90.0) {
+            angle += 180.0;
+        }
+        if (angle > kMaxSkewDegrees) {
+            angle -= 90.0;
+        } else if (angle < -kMaxSkewDegrees) {
+            angle += 90.0;
+        }
+        double weight = std::hypot(dx, dy);
+        angles.emplace_back(angle, weight);
+        totalWeight += weight;
+    }
+
+    if (angles.empty()) {
+        return 0.0;
+    }
+
+    std::sort(angles.begin(), angles.end());
+    double accumulated = 0.0;
+    double median = angles.back().first;
+    for (const auto &entry : angles) {
+        accumulated += entry.second;
+        if (accumulated >= totalWeight / 2.0) {
+            median = entry.first;
+            break;
+        }
+    }
+
+    // 内容顺时针倾斜 median 度，需要逆时针转回
+    return -median;
+}
@@ -0,0 +1,18 @@
+#ifndef DESKEW_H
+#define DESKEW_H
+
+#include <QTransform>
+#include <opencv2/opencv.hpp>
+
+#include "utils/orientation.h"
+
+// QTransform（目标像素 -> 源像素）转为 warpAffine 使用的 2x3 矩阵
+cv::Matx23d toAffineMatrix(const QTransform &dstToSrc);
+
+// 按行带并行执行 warpAffine，dstToSrc 为目标到源的逆映射
+cv::Mat warpAffineParallel(const cv::Mat &source, const cv::Matx23d &dstToSrc, cv::Size dstSize);
+
+// 估计按给定方向显示时的倾斜角（度），返回使内容水平所需的顺时针旋转角
+double estimateSkewAngle(const cv::Mat &image, const Orientation &orientation);
+
+#endif
@@ -0,0 +1,82 @@
+#include "exportencoder.h"
+
+#include <algorithm>
+
+#include "utils/bandwriter.h"
+
+std::string encoderExtension(const QString &suffix)
+{
+    QString lower = suffix.toLower();
+    if (lower == "png") {
+        return ".png";
+    } else if (lower == "jpg" || lower == "jpeg") {
+        return ".jpg";
+    } else if (lower == "bmp") {
+        return ".bmp";
+    } else if (lower == "tiff" || lower == "tif") {
+        return ".tiff";
+    } else if (lower == "webp") {
+        return ".webp";
+    }
+    return std::string();
+}
+
+std::vector<int> encoderParams(const QString &suffix, const ExportOptions &options)
+{
+    const std::string ext = encoderExtension(suffix);
+    if (ext == ".jpg") {
+        return {cv::IMWRITE_JPEG_QUALITY, std::clamp(options.jpegQuality, 0, 100)};
+    } else if (ext == ".png") {
+        return {cv::IMWRITE_PNG_COMPRESSION, std::clamp(options.pngCompression, 0, 9)};
+    } else if (ext == ".webp") {
+        // OpenCV 以大于 100 的质量表示无损
+        return {cv::IMWRITE_WEBP_QUALITY, options.webpLossless ? 101 : std::clamp(options.webpQuality, 1, 100)};
+    } else if (ext == ".tiff") {
+        return {cv::IMWRITE_TIFF_COMPRESSION, options.tiffCompression == TiffCompression::Deflate ? 8 : 1};
+    }
+    return {};
+}
+
+bool encoderSupportsType(const QString &suffix, int type)
+{
+    const std::string ext = encoderExtension(suffix);
+    const int depth = CV_MAT_DEPTH(type);
+    const int channels = CV_MAT_CN(type);
+    const bool grayOrColor = channels == 1 || channels == 3 || channels == 4;
+    if (ext == ".png") {
+        return (depth == CV_8U || depth == CV_16U) && grayOrColor;
+    } else if (ext == ".tiff") {
+        return (depth == CV_8U || depth == CV_16U || depth == CV_32F) && grayOrColor;
+    } else if (ext == ".jpg") {
+        return depth == CV_8U && (channels == 1 || channels == 3);
+    } else if (ext == ".webp") {
+        return depth == CV_8U && (channels == 3 || channels == 4);
+    } else if (ext == ".bmp") {
+        return depth == CV_8U && grayOrColor;
+    }
+    return false;
+}
+
+bool encodeImage(const cv::Mat &image, const QString &suffix, const ExportOptions &options, QIODevice *device)
+{
+    if (image.empty() || !device) {
+        return false;
+    }
+
+    std::unique_ptr<BandWriter> writer = createBandWriter(suffix, options);
+    if (writer && writer->supportsType(image.type())) {
+        return writer->open(device, image.cols, image.rows, image.type())
+               && writer->writeBand(image) && writer->finish();
+    }
+
+    const std::string ext = encoderExtension(suffix);
+    if (ext.empty()) {
+        return false;
+    }
+    std::vector<uchar> buffer;
+    if (!cv::imencode(ext, image, buffer, encoderParams(suffix, options))) {
+        return false;
+    }
+    const qint64 size = static_cast<qint64>(buffer.size());
+    return device->write(reinterpret_cast<const char *>(buffer.data()), size) == size;
+}
@@ -0,0 +1,47 @@
+#ifndef EXPORTENCODER_H
+#define EXPORTENCODER_H
+
+#include <QIODevice>
+#include <QString>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+enum class TiffCompression {
+    None = 0,
+    Deflate
+};
+
+// 导出时各格式的编码参数，不适用于当前格式的字段被忽略
+struct ExportOptions {
+    int jpegQuality = 95;           // 0..100
+    // JPEG 源图只做了旋转/翻转时复制源文件并改写 EXIF 方向，不重新编码
+    bool jpegLosslessOrientation = true;
+    int pngCompression = 6;         // 0..9，越大越慢、文件越小
+    int webpQuality = 90;           // 1..100
+    bool webpLossless = false;
+    TiffCompression tiffCompression = TiffCompression::Deflate;
+};
+
+// 按导出参数在样本上试编码得到的估计值
+struct ExportEstimate {
+    bool valid = false;
+    qint64 bytes = 0;
+    double seconds = 0.0;
+};
+
+// 后缀对应的 cv::imencode 扩展名，不支持的格式返回空串
+std::string encoderExtension(const QString &suffix);
+std::vector<int> encoderParams(const QString &suffix, const ExportOptions &options);
+// cv::imencode 能否不经转换直接保存该位深和通道数
+bool encoderSupportsType(const QString &suffix, int type);
+
+/**
+ * @brief 把整幅图像按后缀和参数编码写入 device
+ *
+ * TIFF/PNG 与行带导出使用同一写出器，其余格式由 cv::imencode 编码，
+ * 因此样本估计与实际导出得到的文件一致。
+ */
+bool encodeImage(const cv::Mat &image, const QString &suffix, const ExportOptions &options, QIODevice *device);
+
+#endif
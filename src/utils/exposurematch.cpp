@@ -0,0 +1,101 @@
+#include "exposurematch.h"
+
+#include <QtGlobal>
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace {
+
+// 统计约一百万个采样点，大图按行列等间隔抽样
+constexpr double kTargetSamples = 1.0e6;
+
+using Histogram = std::array<std::array<double, 256>, 3>;
+
+Histogram subsampledHistogram(const cv::Mat &image, double &count)
+{
+    Histogram histogram{};
+    count = 0.0;
+
+    double pixels = static_cast<double>(image.total());
+    int step = qMax(1, static_cast<int>(std::sqrt(pixels / kTargetSamples)));
+    for (int y = 0; y < image.rows; y += step) {
+        const uchar *row = image.ptr<uchar>(y);
+        for (int x = 0; x < image.cols; x += step) {
+            const uchar *pixel = row + x * 4;
+            if (pixel[3] == 0) {
+                continue;
+            }
+            histogram[0][pixel[0]] += 1.0;
+            histogram[1][pixel[1]] += 1.0;
+            histogram[2][pixel[2]] += 1.0;
+            count += 1.0;
+        }
+    }
+    return histogram;
+}
+
+ChannelLut identityLut()
+{
+    ChannelLut lut;
+    for (int c = 0; c < 3; ++c) {
+        for (int v = 0; v < 256; ++v) {
+            lut.table[c][v] = static_cast<uchar>(v);
+        }
+    }
+    return lut;
+}
+
+} // namespace
+
+ChannelLut computeExposureLut(const cv::Mat &reference, const cv::Mat &source, ExposureMatchMode mode)
+{
+    ChannelLut lut = identityLut();
+    if (mode == ExposureMatchMode::None || reference.type() != CV_8UC4 || source.type() != CV_8UC4) {
+        return lut;
+    }
+
+    double referenceCount = 0.0;
+    double sourceCount = 0.0;
+    Histogram referenceHistogram = subsampledHistogram(reference, referenceCount);
+    Histogram sourceHistogram = subsampledHistogram(source, sourceCount);
+    if (referenceCount <= 0.0 || sourceCount <= 0.0) {
+        return lut;
+    }
+
+    for (int c = 0; c < 3; ++c) {
+        if (mode == ExposureMatchMode::Histogram) {
+            // 源值映射到参考累积分布中第一个不小于其累积概率的灰度
+            double sourceCdf = 0.0;
+            double referenceCdf = referenceHistogram[c][0] / referenceCount;
+            int r = 0;
+            for (int v = 0; v < 256; ++v) {
+                sourceCdf += sourceHistogram[c][v] / sourceCount;
+                while (r < 255 && referenceCdf < sourceCdf - 1e-12) {
+                    ++r;
+                    referenceCdf += referenceHistogram[c][r] / referenceCount;
+                }
+                lut.table[c][v] = static_cast<uchar>(r);
+            }
+        } else {
+            auto moments = [](const std::array<double, 256> &histogram, double count, double &mean, double &stddev) {
+                double sum = 0.0, sumSq = 0.0;
+                for (int v = 0; v < 256; ++v) {
+                    sum += v * histogram[v];
+                    sumSq += double(v) * v * histogram[v];
+                }
+                mean = sum / count;
+                stddev = std::sqrt(qMax(0.0, sumSq / count - mean * mean));
+            };
+            double referenceMean, referenceStd, sourceMean, sourceStd;
+            moments(referenceHistogram[c], referenceCount, referenceMean, referenceStd);
+            moments(sourceHistogram[c], sourceCount, sourceMean, sourceStd);
+            double gain = sourceStd > 1e-6 ? referenceStd / sourceStd : 1.0;
+            for (int v = 0; v < 256; ++v) {
+                double mapped = (v - sourceMean) * gain + referenceMean;
+                lut.table[c][v] = static_cast<uchar>(qBound(0, qRound(mapped), 255));
+            }
+        }
+    }
+    return lut;
+}
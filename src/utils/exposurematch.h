@@ -0,0 +1,19 @@
+#ifndef EXPOSUREMATCH_H
+#define EXPOSUREMATCH_H
+
+#include <opencv2/opencv.hpp>
+
+#include "utils/blendkernel.h"
+
+// 第二张图片向第一张图片的曝光归一化方式
+enum class ExposureMatchMode {
+    None = 0,
+    Histogram,  // 逐通道直方图匹配
+    MeanStd     // 逐通道均值/标准差归一化
+};
+
+// 由降采样后的直方图计算把 source 映射到 reference 色调分布的查找表。
+// 两者均为 CV_8UC4（BGRA），alpha 为 0 的画布填充区域不参与统计。
+ChannelLut computeExposureLut(const cv::Mat &reference, const cv::Mat &source, ExposureMatchMode mode);
+
+#endif
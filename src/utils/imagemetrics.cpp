@@ -0,0 +1,175 @@
+#include "imagemetrics.h"
+
+#include <QtGlobal>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// SSIM 使用 7x7 方框窗口，常数取 (0.01 * 255)^2 与 (0.03 * 255)^2
+constexpr int kWindowRadius = 3;
+constexpr double kC1 = 6.5025;
+constexpr double kC2 = 58.5225;
+
+// 任一输入 alpha 为 0 的像素是画布填充或配准后落在图外的区域，不参与统计
+inline bool isValidPixel(const uchar *pa, const uchar *pb)
+{
+    return pa[3] != 0 && pb[3] != 0;
+}
+
+// paddedA、paddedB 为外扩后的瓦片，inner 为瓦片本身在其中的位置
+double tileSsimSum(const cv::Mat &paddedA, const cv::Mat &paddedB, const cv::Rect &inner)
+{
+    cv::Mat a, b;
+    cv::cvtColor(paddedA, a, cv::COLOR_BGRA2GRAY);
+    cv::cvtColor(paddedB, b, cv::COLOR_BGRA2GRAY);
+    a.convertTo(a, CV_32F);
+    b.convertTo(b, CV_32F);
+
+    const cv::Size window(2 * kWindowRadius + 1, 2 * kWindowRadius + 1);
+    cv::Mat muA, muB, aa, bb, ab;
+    cv::boxFilter(a, muA, CV_32F, window, cv::Point(-1, -1), true, cv::BORDER_REFLECT);
+    cv::boxFilter(b, muB, CV_32F, window, cv::Point(-1, -1), true, cv::BORDER_REFLECT);
+    cv::boxFilter(a.mul(a), aa, CV_32F, window, cv::Point(-1, -1), true, cv::BORDER_REFLECT);
+    cv::boxFilter(b.mul(b), bb, CV_32F, window, cv::Point(-1, -1), true, cv::BORDER_REFLECT);
+    cv::boxFilter(a.mul(b), ab, CV_32F, window, cv::Point(-1, -1), true, cv::BORDER_REFLECT);
+
+    double sum = 0.0;
+    for (int y = inner.y; y < inner.y + inner.height; ++y) {
+        const uchar *pa = paddedA.ptr<uchar>(y);
+        const uchar *pb = paddedB.ptr<uchar>(y);
+        const float *pMuA = muA.ptr<float>(y);
+        const float *pMuB = muB.ptr<float>(y);
+        const float *pAA = aa.ptr<float>(y);
+        const float *pBB = bb.ptr<float>(y);
+        const float *pAB = ab.ptr<float>(y);
+        for (int x = inner.x; x < inner.x + inner.width; ++x) {
+            if (!isValidPixel(pa + x * 4, pb + x * 4)) {
+                continue;
+            }
+            double meanA = pMuA[x];
+            double meanB = pMuB[x];
+            double varA = pAA[x] - meanA * meanA;
+            double varB = pBB[x] - meanB * meanB;
+            double cov = pAB[x] - meanA * meanB;
+            sum += ((2.0 * meanA * meanB + kC1) * (2.0 * cov + kC2))
+                   / ((meanA * meanA + meanB * meanB + kC1) * (varA + varB + kC2));
+        }
+    }
+    return sum;
+}
+
+// 返回有效像素的误差平方和，validPixels 为有效像素数
+double tileSquaredError(const cv::Mat &a, const cv::Mat &b, const cv::Rect &tile, qint64 &validPixels)
+{
+    double sum = 0.0;
+    validPixels = 0;
+    for (int y = tile.y; y < tile.y + tile.height; ++y) {
+        const uchar *pa = a.ptr<uchar>(y) + tile.x * 4;
+        const uchar *pb = b.ptr<uchar>(y) + tile.x * 4;
+        qint64 rowSum = 0;
+        for (int x = 0; x < tile.width; ++x, pa += 4, pb += 4) {
+            if (!isValidPixel(pa, pb)) {
+                continue;
+            }
+            ++validPixels;
+            int d0 = pa[0] - pb[0];
+            int d1 = pa[1] - pb[1];
+            int d2 = pa[2] - pb[2];
+            rowSum += d0 * d0 + d1 * d1 + d2 * d2;
+        }
+        sum += static_cast<double>(rowSum);
+    }
+    return sum;
+}
+
+} // namespace
+
+MetricsGrid MetricsGrid::compute(const cv::Mat &a, const ComparedImage &b)
+{
+    MetricsGrid grid;
+    if (a.empty() || a.type() != CV_8UC4 || b.image.type() != CV_8UC4 || a.size() != b.image.size()) {
+        return grid;
+    }
+
+    grid.m_imageSize = QSize(a.cols, a.rows);
+    grid.m_columns = (a.cols + kTileSize - 1) / kTileSize;
+    grid.m_rows = (a.rows + kTileSize - 1) / kTileSize;
+    grid.m_tiles.resize(static_cast<size_t>(grid.m_columns) * grid.m_rows);
+
+    cv::parallel_for_(cv::Range(0, static_cast<int>(grid.m_tiles.size())), [&](const cv::Range &range) {
+        for (int index = range.start; index < range.end; ++index) {
+            int tx = index % grid.m_columns;
+            int ty = index / grid.m_columns;
+            const cv::Rect bounds(0, 0, a.cols, a.rows);
+            cv::Rect tile = cv::Rect(tx * kTileSize, ty * kTileSize, kTileSize, kTileSize) & bounds;
+
+            // 瓦片向外扩展 SSIM 窗口半径，使瓦片内每个像素的窗口都落在真实数据上；
+            // 到达图像边缘时由 boxFilter 反射补齐，结果与分块方式无关
+            cv::Rect padded = cv::Rect(tile.x - kWindowRadius, tile.y - kWindowRadius,
+                                       tile.width + 2 * kWindowRadius, tile.height + 2 * kWindowRadius) & bounds;
+            cv::Rect inner(tile.x - padded.x, tile.y - padded.y, tile.width, tile.height);
+            cv::Mat paddedA = a(padded);
+            cv::Mat paddedB = b.region(padded);
+
+            Totals &totals = grid.m_tiles[index];
+            totals.squaredError = tileSquaredError(paddedA, paddedB, inner, totals.pixels);
+            totals.ssimSum = tileSsimSum(paddedA, paddedB, inner);
+        }
+    });
+    return grid;
+}
+
+bool MetricsGrid::isEmpty() const
+{
+    return m_tiles.empty();
+}
+
+QSize MetricsGrid::imageSize() const
+{
+    return m_imageSize;
+}
+
+QualityMetrics MetricsGrid::summarize() const
+{
+    return summarize(QRect(QPoint(0, 0), m_imageSize));
+}
+
+QualityMetrics MetricsGrid::summarize(const QRect &region) const
+{
+    QRect clipped = region & QRect(QPoint(0, 0), m_imageSize);
+    if (m_tiles.empty() || clipped.isEmpty()) {
+        return QualityMetrics();
+    }
+
+    Totals totals;
+    int tx0 = clipped.left() / kTileSize;
+    int ty0 = clipped.top() / kTileSize;
+    int tx1 = clipped.right() / kTileSize;
+    int ty1 = clipped.bottom() / kTileSize;
+    for (int ty = ty0; ty <= ty1; ++ty) {
+        for (int tx = tx0; tx <= tx1; ++tx) {
+            const Totals &tile = m_tiles[static_cast<size_t>(ty) * m_columns + tx];
+            totals.squaredError += tile.squaredError;
+            totals.ssimSum += tile.ssimSum;
+            totals.pixels += tile.pixels;
+        }
+    }
+    return toMetrics(totals);
+}
+
+QualityMetrics MetricsGrid::toMetrics(const Totals &totals)
+{
+    QualityMetrics metrics;
+    if (totals.pixels <= 0) {
+        return metrics;
+    }
+
+    metrics.valid = true;
+    metrics.mse = totals.squaredError / (3.0 * totals.pixels);
+    metrics.psnr = metrics.mse > 0.0
+        ? 10.0 * std::log10(255.0 * 255.0 / metrics.mse)
+        : std::numeric_limits<double>::infinity();
+    metrics.ssim = totals.ssimSum / totals.pixels;
+    return metrics;
+}
@@ -0,0 +1,54 @@
+#ifndef IMAGEMETRICS_H
+#define IMAGEMETRICS_H
+
+#include <QRect>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "utils/comparedimage.h"
+
+struct QualityMetrics {
+    bool valid = false;
+    double mse = 0.0;
+    double psnr = 0.0;      // 两图完全相同时为 +inf
+    double ssim = 0.0;
+};
+
+/**
+ * @brief 按固定网格分块的画质指标累加值
+ *
+ * 整图只计算一次，每个瓦片保存可累加的误差平方和与 SSIM 之和；任意区域的指标
+ * 由与之相交的瓦片求和得到，区域边界按瓦片网格取整。任一输入 alpha 为 0 的像素
+ * （画布填充、配准后落在图外的区域）不计入指标。
+ */
+class MetricsGrid
+{
+public:
+    static constexpr int kTileSize = 128;
+
+    // a、b.image 为同尺寸的 CV_8UC4（BGRA）图像；瓦片按 cv::parallel_for_ 并行计算，
+    // b 在每个瓦片（含 SSIM 窗口外扩）上单独取区域，不生成整幅副本
+    static MetricsGrid compute(const cv::Mat &a, const ComparedImage &b);
+
+    bool isEmpty() const;
+    QSize imageSize() const;
+
+    QualityMetrics summarize() const;
+    QualityMetrics summarize(const QRect &region) const;
+
+private:
+    struct Totals {
+        double squaredError = 0.0;  // BGR 三通道
+        double ssimSum = 0.0;       // 亮度通道
+        qint64 pixels = 0;          // 两图 alpha 均非 0 的像素数
+    };
+
+    static QualityMetrics toMetrics(const Totals &totals);
+
+    QSize m_imageSize;
+    int m_columns = 0;
+    int m_rows = 0;
+    std::vector<Totals> m_tiles;
+};
+
+#endif
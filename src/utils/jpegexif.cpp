@@ -0,0 +1,333 @@
+#include "jpegexif.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr quint16 kOrientationTag = 0x0112;
+constexpr quint16 kTypeShort = 3;
+constexpr int kEntrySize = 12;
+constexpr int kMaxSegmentLength = 0xFFFF;
+
+// EXIF 内部的 TIFF 数据可能是大端或小端
+class TiffView
+{
+public:
+    TiffView(uchar *data, qsizetype size, bool bigEndian)
+        : m_data(data), m_size(size), m_bigEndian(bigEndian)
+    {
+    }
+
+    bool contains(qint64 offset, qint64 length) const
+    {
+        return offset >= 0 && length >= 0 && offset + length <= m_size;
+    }
+
+    quint16 read16(qint64 offset) const
+    {
+        const uchar *p = m_data + offset;
+        return m_bigEndian ? quint16((p[0] << 8) | p[1]) : quint16((p[1] << 8) | p[0]);
+    }
+
+    quint32 read32(qint64 offset) const
+    {
+        const uchar *p = m_data + offset;
+        return m_bigEndian
+            ? (quint32(p[0]) << 24) | (quint32(p[1]) << 16) | (quint32(p[2]) << 8) | quint32(p[3])
+            : (quint32(p[3]) << 24) | (quint32(p[2]) << 16) | (quint32(p[1]) << 8) | quint32(p[0]);
+    }
+
+    void write16(uchar *p, quint16 value) const
+    {
+        if (m_bigEndian) {
+            p[0] = uchar(value >> 8);
+            p[1] = uchar(value);
+        } else {
+            p[0] = uchar(value);
+            p[1] = uchar(value >> 8);
+        }
+    }
+
+    void write32(uchar *p, quint32 value) const
+    {
+        for (int i = 0; i < 4; ++i) {
+            int shift = m_bigEndian ? 24 - 8 * i : 8 * i;
+            p[i] = uchar(value >> shift);
+        }
+    }
+
+    uchar *data() const { return m_data; }
+
+private:
+    uchar *m_data;
+    qsizetype m_size;
+    bool m_bigEndian;
+};
+
+quint16 readBigEndian16(const QByteArray &data, qsizetype offset)
+{
+    return quint16((uchar(data[offset]) << 8) | uchar(data[offset + 1]));
+}
+
+void writeBigEndian16(QByteArray &data, qsizetype offset, quint16 value)
+{
+    data[offset] = char(value >> 8);
+    data[offset + 1] = char(value);
+}
+
+QByteArray minimalExifSegment(int orientation)
+{
+    // APP1: "Exif\0\0" + 大端 TIFF 头 + 只含方向标签的 IFD0
+    static const uchar segment[] = {
+        0xFF, 0xE1, 0x00, 0x22,
+        'E', 'x', 'i', 'f', 0x00, 0x00,
+        'M', 'M', 0x00, 0x2A, 0x00, 0x00, 0x00, 0x08,
+        0x00, 0x01,
+        0x01, 0x12, 0x00, 0x03, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00
+    };
+    QByteArray bytes(reinterpret_cast<const char *>(segment), sizeof(segment));
+    bytes[29] = char(orientation);
+    return bytes;
+}
+
+bool rewriteExifSegment(QByteArray &jpeg, qsizetype segmentPos, int length, int orientation)
+{
+    // 段内布局：FF E1, 长度(2), "Exif\0\0"(6), TIFF 数据
+    const qsizetype tiffPos = segmentPos + 10;
+    const qsizetype tiffSize = segmentPos + 2 + length - tiffPos;
+    if (tiffSize < 8) {
+        return false;
+    }
+
+    QByteArray working = jpeg;
+    uchar *tiffData = reinterpret_cast<uchar *>(working.data()) + tiffPos;
+    bool bigEndian;
+    if (std::memcmp(tiffData, "MM", 2) == 0) {
+        bigEndian = true;
+    } else if (std::memcmp(tiffData, "II", 2) == 0) {
+        bigEndian = false;
+    } else {
+        return false;
+    }
+    TiffView tiff(tiffData, tiffSize, bigEndian);
+    if (tiff.read16(2) != 42) {
+        return false;
+    }
+
+    const qint64 ifdOffset = tiff.read32(4);
+    if (!tiff.contains(ifdOffset, 2)) {
+        return false;
+    }
+    const int count = tiff.read16(ifdOffset);
+    const qint64 entriesOffset = ifdOffset + 2;
+    if (!tiff.contains(entriesOffset, qint64(count) * kEntrySize + 4)) {
+        return false;
+    }
+
+    // 已有方向标签：只改写两个字节
+    for (int i = 0; i < count; ++i) {
+        const qint64 entry = entriesOffset + qint64(i) * kEntrySize;
+        if (tiff.read16(entry) == kOrientationTag) {
+            if (tiff.read16(entry + 2) != kTypeShort || tiff.read32(entry + 4) != 1) {
+                return false;
+            }
+            tiff.write16(tiff.data() + entry + 8, quint16(orientation));
+            jpeg = working;
+            return true;
+        }
+    }
+
+    // 没有方向标签：在 TIFF 数据末尾写一份插入了方向标签的 IFD0，再让头部指向它。
+    // 其余条目里的偏移都相对 TIFF 头，位置不变，仍然有效
+    const bool pad = tiffSize % 2 != 0;
+    const qint64 newIfdOffset = tiffSize + (pad ? 1 : 0);
+    const qint64 newIfdSize = 2 + qint64(count + 1) * kEntrySize + 4;
+    const qint64 newLength = length + (pad ? 1 : 0) + newIfdSize;
+    if (newLength > kMaxSegmentLength || newIfdOffset > 0xFFFFFFFFLL) {
+        return false;
+    }
+
+    std::vector<uchar> ifd(static_cast<size_t>(newIfdSize), 0);
+    tiff.write16(ifd.data(), quint16(count + 1));
+    uchar *out = ifd.data() + 2;
+    bool inserted = false;
+    for (int i = 0; i < count; ++i) {
+        const qint64 entry = entriesOffset + qint64(i) * kEntrySize;
+        if (!inserted && tiff.read16(entry) > kOrientationTag) {
+            tiff.write16(out, kOrientationTag);
+            tiff.write16(out + 2, kTypeShort);
+            tiff.write32(out + 4, 1);
+            tiff.write16(out + 8, quint16(orientation));
+            out += kEntrySize;
+            inserted = true;
+        }
+        std::memcpy(out, tiff.data() + entry, kEntrySize);
+        out += kEntrySize;
+    }
+    if (!inserted) {
+        tiff.write16(out, kOrientationTag);
+        tiff.write16(out + 2, kTypeShort);
+        tiff.write32(out + 4, 1);
+        tiff.write16(out + 8, quint16(orientation));
+        out += kEntrySize;
+    }
+    // 保留原 IFD0 指向 IFD1（缩略图）的链接
+    std::memcpy(out, tiff.data() + entriesOffset + qint64(count) * kEntrySize, 4);
+
+    tiff.write32(tiff.data() + 4, quint32(newIfdOffset));
+    QByteArray insertion;
+    if (pad) {
+        insertion.append('\0');
+    }
+    insertion.append(reinterpret_cast<const char *>(ifd.data()), qsizetype(ifd.size()));
+    working.insert(tiffPos + tiffSize, insertion);
+    writeBigEndian16(working, segmentPos + 2, quint16(newLength));
+    jpeg = working;
+    return true;
+}
+
+enum class ExifSegment {
+    Found,
+    Missing,
+    Invalid
+};
+
+// 扫描 SOS 之前的标记段查找 EXIF APP1 段；没有时 insertPos 为新段应插入的位置
+ExifSegment findExifSegment(const QByteArray &jpeg, qsizetype &segmentPos, int &length, qsizetype &insertPos)
+{
+    if (jpeg.size() < 4 || uchar(jpeg[0]) != 0xFF || uchar(jpeg[1]) != 0xD8) {
+        return ExifSegment::Invalid;
+    }
+
+    insertPos = 2;
+    qsizetype pos = 2;
+    while (pos + 4 <= jpeg.size()) {
+        if (uchar(jpeg[pos]) != 0xFF) {
+            return ExifSegment::Invalid;
+        }
+        const uchar marker = uchar(jpeg[pos + 1]);
+        if (marker == 0xFF) {
+            ++pos;
+            continue;
+        }
+        if (marker == 0xDA || marker == 0xD9) {
+            break;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            pos += 2;
+            continue;
+        }
+
+        const int segmentLength = readBigEndian16(jpeg, pos + 2);
+        if (segmentLength < 2 || pos + 2 + segmentLength > jpeg.size()) {
+            return ExifSegment::Invalid;
+        }
+        if (marker == 0xE1 && segmentLength >= 16
+            && std::memcmp(jpeg.constData() + pos + 4, "Exif\0\0", 6) == 0) {
+            segmentPos = pos;
+            length = segmentLength;
+            return ExifSegment::Found;
+        }
+        if (marker == 0xE0 && insertPos == pos) {
+            insertPos = pos + 2 + segmentLength;
+        }
+        pos += 2 + segmentLength;
+    }
+    return ExifSegment::Missing;
+}
+
+} // namespace
+
+int exifOrientationValue(const Orientation &orientation)
+{
+    // EXIF 的定义同样是先水平镜像、再顺时针旋转
+    static const int values[2][4] = {
+        {1, 6, 3, 8},
+        {2, 7, 4, 5}
+    };
+    return values[orientation.isMirrored() ? 1 : 0][orientation.quarterTurns()];
+}
+
+Orientation orientationFromExifValue(int value)
+{
+    static const Orientation orientations[9] = {
+        Orientation(),
+        Orientation(0, false), Orientation(0, true), Orientation(2, false), Orientation(2, true),
+        Orientation(3, true), Orientation(1, false), Orientation(1, true), Orientation(3, false)
+    };
+    return value >= 1 && value <= 8 ? orientations[value] : Orientation();
+}
+
+bool setJpegExifOrientation(QByteArray &jpeg, int orientation)
+{
+    if (orientation < 1 || orientation > 8) {
+        return false;
+    }
+
+    qsizetype segmentPos;
+    int length;
+    qsizetype insertPos;
+    switch (findExifSegment(jpeg, segmentPos, length, insertPos)) {
+    case ExifSegment::Found:
+        return rewriteExifSegment(jpeg, segmentPos, length, orientation);
+    case ExifSegment::Missing:
+        jpeg.insert(insertPos, minimalExifSegment(orientation));
+        return true;
+    case ExifSegment::Invalid:
+        break;
+    }
+    return false;
+}
+
+int jpegExifOrientation(const QByteArray &jpeg)
+{
+    qsizetype segmentPos;
+    int length;
+    qsizetype insertPos;
+    if (findExifSegment(jpeg, segmentPos, length, insertPos) != ExifSegment::Found) {
+        return 1;
+    }
+
+    // 拷贝出段内的 TIFF 数据，TiffView 只在这份拷贝上读取
+    const qsizetype tiffPos = segmentPos + 10;
+    QByteArray tiffBytes = jpeg.mid(tiffPos, segmentPos + 2 + length - tiffPos);
+    if (tiffBytes.size() < 8) {
+        return 1;
+    }
+    bool bigEndian;
+    if (tiffBytes.startsWith("MM")) {
+        bigEndian = true;
+    } else if (tiffBytes.startsWith("II")) {
+        bigEndian = false;
+    } else {
+        return 1;
+    }
+    TiffView tiff(reinterpret_cast<uchar *>(tiffBytes.data()), tiffBytes.size(), bigEndian);
+    if (tiff.read16(2) != 42) {
+        return 1;
+    }
+
+    const qint64 ifdOffset = tiff.read32(4);
+    if (!tiff.contains(ifdOffset, 2)) {
+        return 1;
+    }
+    const int count = tiff.read16(ifdOffset);
+    const qint64 entriesOffset = ifdOffset + 2;
+    if (!tiff.contains(entriesOffset, qint64(count) * kEntrySize)) {
+        return 1;
+    }
+    for (int i = 0; i < count; ++i) {
+        const qint64 entry = entriesOffset + qint64(i) * kEntrySize;
+        if (tiff.read16(entry) == kOrientationTag) {
+            if (tiff.read16(entry + 2) != kTypeShort || tiff.read32(entry + 4) != 1) {
+                return 1;
+            }
+            const int value = tiff.read16(entry + 8);
+            return value >= 1 && value <= 8 ? value : 1;
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,26 @@
+#ifndef JPEGEXIF_H
+#define JPEGEXIF_H
+
+#include <QByteArray>
+
+#include "utils/orientation.h"
+
+// 方向对应的 EXIF Orientation 标签值（1..8）
+int exifOrientationValue(const Orientation &orientation);
+
+// EXIF Orientation 标签值对应的方向，超出 1..8 时视为 1
+Orientation orientationFromExifValue(int value);
+
+// 读取 JPEG 文件数据中的 EXIF 方向；不是 JPEG、没有方向标签或无法解析时返回 1
+int jpegExifOrientation(const QByteArray &jpeg);
+
+/**
+ * @brief 改写 JPEG 文件数据中的 EXIF 方向，压缩数据原样保留
+ *
+ * 已有方向标签时原地改写；EXIF 中没有方向标签时在 APP1 段末尾写入一份带方向标签的 IFD0；
+ * 没有 EXIF 时在 SOI（或 JFIF APP0）之后插入最小的 APP1 段。
+ * 数据不是 JPEG、EXIF 无法解析或改写后 APP1 段超长时返回 false，jpeg 不变。
+ */
+bool setJpegExifOrientation(QByteArray &jpeg, int orientation);
+
+#endif
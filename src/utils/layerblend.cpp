@@ -0,0 +1,103 @@
+#include "layerblend.h"
+#include "utils/blendkernel.h"
+
+#include <QtGlobal>
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+// 权重量化到 0..256
+constexpr int kWeightShift = 8;
+constexpr int kWeightOne = 1 << kWeightShift;
+
+using CompositeRowFunc = void (*)(uchar *dst, const uchar *src, int pixels, int opacity);
+
+// x / 255 的精确整数近似，x 不超过 255 * 255
+inline int div255(int x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+template <LayerBlendMode Mode>
+inline int blendChannel(int d, int s)
+{
+    switch (Mode) {
+    case LayerBlendMode::Multiply:
+        return div255(d * s);
+    case LayerBlendMode::Screen:
+        return 255 - div255((255 - d) * (255 - s));
+    case LayerBlendMode::Additive:
+        return std::min(d + s, 255);
+    case LayerBlendMode::Difference:
+        return std::abs(d - s);
+    case LayerBlendMode::Normal:
+    default:
+        return s;
+    }
+}
+
+template <LayerBlendMode Mode>
+void compositeRow(uchar *dst, const uchar *src, int pixels, int opacity)
+{
+    for (int i = 0; i < pixels; ++i, dst += 4, src += 4) {
+        int alpha = src[3] + (src[3] >> 7);
+        int weight = (opacity * alpha) >> kWeightShift;
+        if (weight == 0) {
+            continue;
+        }
+        int inverse = kWeightOne - weight;
+        for (int c = 0; c < 3; ++c) {
+            int blended = blendChannel<Mode>(dst[c], src[c]);
+            dst[c] = static_cast<uchar>((dst[c] * inverse + blended * weight + (kWeightOne >> 1)) >> kWeightShift);
+        }
+    }
+}
+
+CompositeRowFunc rowFuncForMode(LayerBlendMode mode)
+{
+    switch (mode) {
+    case LayerBlendMode::Multiply: return &compositeRow<LayerBlendMode::Multiply>;
+    case LayerBlendMode::Screen: return &compositeRow<LayerBlendMode::Screen>;
+    case LayerBlendMode::Additive: return &compositeRow<LayerBlendMode::Additive>;
+    case LayerBlendMode::Difference: return &compositeRow<LayerBlendMode::Difference>;
+    case LayerBlendMode::Normal:
+    default:
+        return &compositeRow<LayerBlendMode::Normal>;
+    }
+}
+
+} // namespace
+
+void compositeLayers(cv::Mat &dst, const std::vector<LayerTile> &layers)
+{
+    CV_Assert(dst.type() == CV_8UC4);
+
+    struct Pass {
+        const cv::Mat *image;
+        CompositeRowFunc row;
+        int opacity;
+    };
+    std::vector<Pass> passes;
+    for (const LayerTile &layer : layers) {
+        CV_Assert(layer.image.type() == CV_8UC4 && layer.image.size() == dst.size());
+        int opacity = qBound(0, qRound(layer.opacity * kWeightOne), kWeightOne);
+        if (opacity > 0) {
+            passes.push_back({&layer.image, rowFuncForMode(layer.mode), opacity});
+        }
+    }
+    if (passes.empty()) {
+        return;
+    }
+
+    const int width = dst.cols;
+    parallelForBands(dst.rows, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            uchar *row = dst.ptr<uchar>(y);
+            for (const Pass &pass : passes) {
+                pass.row(row, pass.image->ptr<uchar>(y), width, pass.opacity);
+            }
+        }
+    });
+}
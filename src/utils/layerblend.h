@@ -0,0 +1,26 @@
+#ifndef LAYERBLEND_H
+#define LAYERBLEND_H
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// 图层混合方式
+enum class LayerBlendMode {
+    Normal = 0,
+    Multiply,
+    Screen,
+    Additive,
+    Difference
+};
+
+struct LayerTile {
+    cv::Mat image;          // CV_8UC4（BGRA），尺寸与目标相同
+    double opacity = 1.0;   // 0..1，与像素 alpha 相乘作为权重
+    LayerBlendMode mode = LayerBlendMode::Normal;
+};
+
+// 自下而上把各图层合成到 dst（CV_8UC4，可包装 QImage 缓冲区）上，dst 的 alpha 保持不变。
+// 按行带并行，每一行依次叠加所有图层，目标行在缓存中只读写一趟。
+void compositeLayers(cv::Mat &dst, const std::vector<LayerTile> &layers);
+
+#endif
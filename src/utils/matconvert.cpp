@@ -0,0 +1,41 @@
+#include "matconvert.h"
+
+cv::Mat toDisplayDepth(const cv::Mat &mat)
+{
+    if (mat.empty() || mat.depth() == CV_8U) {
+        return mat;
+    }
+
+    cv::Mat converted;
+    if (mat.depth() == CV_16U) {
+        mat.convertTo(converted, CV_8U, 1.0 / 257.0);
+    } else if (mat.depth() == CV_32F || mat.depth() == CV_64F) {
+        mat.convertTo(converted, CV_8U, 255.0);
+    } else {
+        cv::normalize(mat, converted, 0, 255, cv::NORM_MINMAX, CV_8U);
+    }
+    return converted;
+}
+
+QImage cvMatToQImage(const cv::Mat &mat)
+{
+    if (mat.empty()) {
+        return QImage();
+    }
+
+    cv::Mat source = toDisplayDepth(mat);
+
+    // 直接写入 QImage 的缓冲区，省去一次拷贝
+    QImage image(source.cols, source.rows, QImage::Format_ARGB32);
+    cv::Mat target(image.height(), image.width(), CV_8UC4, image.bits(), image.bytesPerLine());
+
+    if (source.channels() == 1) {
+        cv::cvtColor(source, target, cv::COLOR_GRAY2BGRA);
+    } else if (source.channels() == 3) {
+        cv::cvtColor(source, target, cv::COLOR_BGR2BGRA);
+    } else {
+        source.copyTo(target);
+    }
+
+    return image;
+}
@@ -0,0 +1,13 @@
+#ifndef MATCONVERT_H
+#define MATCONVERT_H
+
+#include <QImage>
+#include <opencv2/opencv.hpp>
+
+// 任意深度/通道数的 cv::Mat 转为 8 位显示数据
+cv::Mat toDisplayDepth(const cv::Mat &mat);
+
+// 转为 Format_ARGB32 的 QImage（BGRA 内存布局，无需额外交换通道）
+QImage cvMatToQImage(const cv::Mat &mat);
+
+#endif
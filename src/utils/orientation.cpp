@@ -0,0 +1,228 @@
+#include "orientation.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr int kTileSize = 64;
+
+using OrientKernel = void (*)(const uchar *src, ptrdiff_t srcStride, uchar *dst, int count);
+
+// 以像素字节数为模板参数，覆盖 1/3/4 通道的 8 位与 16 位图像
+template <size_t N>
+void copyStrided(const uchar *src, ptrdiff_t srcStride, uchar *dst, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        std::memcpy(dst, src, N);
+        src += srcStride;
+        dst += N;
+    }
+}
+
+OrientKernel kernelForElemSize(size_t elemSize)
+{
+    switch (elemSize) {
+    case 1: return &copyStrided<1>;
+    case 2: return &copyStrided<2>;
+    case 3: return &copyStrided<3>;
+    case 4: return &copyStrided<4>;
+    case 6: return &copyStrided<6>;
+    case 8: return &copyStrided<8>;
+    case 12: return &copyStrided<12>;
+    case 16: return &copyStrided<16>;
+    default: return nullptr;
+    }
+}
+
+} // namespace
+
+Orientation::Orientation(int quarterTurns, bool mirrored)
+    : m_quarterTurns(((quarterTurns % 4) + 4) % 4)
+    , m_mirrored(mirrored)
+{
+}
+
+void Orientation::rotateLeft()
+{
+    m_quarterTurns = (m_quarterTurns + 3) % 4;
+}
+
+void Orientation::rotateRight()
+{
+    m_quarterTurns = (m_quarterTurns + 1) % 4;
+}
+
+void Orientation::rotate180()
+{
+    m_quarterTurns = (m_quarterTurns + 2) % 4;
+}
+
+void Orientation::flipHorizontal()
+{
+    // FlipH * Rot(r) = Rot(-r) * FlipH
+    m_quarterTurns = (4 - m_quarterTurns) % 4;
+    m_mirrored = !m_mirrored;
+}
+
+void Orientation::flipVertical()
+{
+    // FlipV = Rot(2) * FlipH
+    m_quarterTurns = (6 - m_quarterTurns) % 4;
+    m_mirrored = !m_mirrored;
+}
+
+void Orientation::reset()
+{
+    m_quarterTurns = 0;
+    m_mirrored = false;
+}
+
+bool Orientation::isIdentity() const
+{
+    return m_quarterTurns == 0 && !m_mirrored;
+}
+
+int Orientation::quarterTurns() const
+{
+    return m_quarterTurns;
+}
+
+bool Orientation::isMirrored() const
+{
+    return m_mirrored;
+}
+
+Orientation Orientation::followedBy(const Orientation &next) const
+{
+    // next 本身也是先镜像再旋转，依次追加到本方向之后
+    Orientation composed = *this;
+    if (next.m_mirrored) {
+        composed.flipHorizontal();
+    }
+    composed.m_quarterTurns = (composed.m_quarterTurns + next.m_quarterTurns) % 4;
+    return composed;
+}
+
+QSize Orientation::mapSize(const QSize &imageSize) const
+{
+    return (m_quarterTurns % 2 == 0) ? imageSize : imageSize.transposed();
+}
+
+QTransform Orientation::toTransform(const QSize &imageSize) const
+{
+    QTransform base;
+    if (m_mirrored) {
+        base = QTransform::fromScale(-1, 1);
+    }
+    // QTransform 对 90 的整数倍角度有精确实现，不会引入浮点误差
+    base = base * QTransform().rotate(90.0 * m_quarterTurns);
+
+    QRectF mapped = base.mapRect(QRectF(QPointF(0, 0), QSizeF(imageSize)));
+    return base * QTransform::fromTranslate(-mapped.left(), -mapped.top());
+}
+
+cv::Mat Orientation::apply(const cv::Mat &image) const
+{
+    if (image.empty() || isIdentity()) {
+        return image;
+    }
+
+    // 目标像素 (dx, dy) 对应的源坐标是 dx、dy 的仿射函数：
+    // src = origin + dx * colStride + dy * rowStride
+    const int w = image.cols;
+    const int h = image.rows;
+    int originX = 0, originY = 0;
+    int colX = 1, colY = 0;
+    int rowX = 0, rowY = 1;
+    switch (m_quarterTurns) {
+    case 1:
+        originY = h - 1; colX = 0; colY = -1; rowX = 1; rowY = 0;
+        break;
+    case 2:
+        originX = w - 1; originY = h - 1; colX = -1; colY = 0; rowX = 0; rowY = -1;
+        break;
+    case 3:
+        originX = w - 1; colX = 0; colY = 1; rowX = -1; rowY = 0;
+        break;
+    default:
+        break;
+    }
+    if (m_mirrored) {
+        originX = w - 1 - originX;
+        colX = -colX;
+        rowX = -rowX;
+    }
+
+    const size_t elemSize = image.elemSize();
+    OrientKernel kernel = kernelForElemSize(elemSize);
+    if (!kernel) {
+        return applyTwoPass(image);
+    }
+
+    QSize dstSize = mapSize(QSize(w, h));
+    cv::Mat result(dstSize.height(), dstSize.width(), image.type());
+
+    const ptrdiff_t srcStep = static_cast<ptrdiff_t>(image.step[0]);
+    const ptrdiff_t colStride = colY * srcStep + colX * static_cast<ptrdiff_t>(elemSize);
+    const ptrdiff_t rowStride = rowY * srcStep + rowX * static_cast<ptrdiff_t>(elemSize);
+    const uchar *origin = image.ptr<uchar>(originY) + originX * elemSize;
+
+    // 按行带并行，每个行带内再按方块遍历，使 90° 旋转时源图按列读取的
+    // 访问集中在一个小方块内，避免每个目标像素都跨越整行源数据
+    const int bandCount = (result.rows + kTileSize - 1) / kTileSize;
+    cv::parallel_for_(cv::Range(0, bandCount), [&](const cv::Range &range) {
+        for (int band = range.start; band < range.end; ++band) {
+            int y0 = band * kTileSize;
+            int y1 = std::min(y0 + kTileSize, result.rows);
+            for (int x0 = 0; x0 < result.cols; x0 += kTileSize) {
+                int x1 = std::min(x0 + kTileSize, result.cols);
+                for (int dy = y0; dy < y1; ++dy) {
+                    const uchar *src = origin + dy * rowStride + x0 * colStride;
+                    uchar *dst = result.ptr<uchar>(dy) + x0 * elemSize;
+                    kernel(src, colStride, dst, x1 - x0);
+                }
+            }
+        }
+    });
+
+    return result;
+}
+
+cv::Mat Orientation::applyTwoPass(const cv::Mat &image) const
+{
+    // 每一步都写入新的缓冲区：image 与调用方共享像素，原地 flip/rotate 会改写原图
+    cv::Mat source = image;
+    if (m_mirrored) {
+        cv::Mat flipped;
+        cv::flip(image, flipped, 1);
+        source = flipped;
+    }
+
+    cv::Mat result;
+    switch (m_quarterTurns) {
+    case 1:
+        cv::rotate(source, result, cv::ROTATE_90_CLOCKWISE);
+        break;
+    case 2:
+        cv::rotate(source, result, cv::ROTATE_180);
+        break;
+    case 3:
+        cv::rotate(source, result, cv::ROTATE_90_COUNTERCLOCKWISE);
+        break;
+    default:
+        result = source;
+        break;
+    }
+    return result;
+}
+
+bool Orientation::operator==(const Orientation &other) const
+{
+    return m_quarterTurns == other.m_quarterTurns && m_mirrored == other.m_mirrored;
+}
+
+bool Orientation::operator!=(const Orientation &other) const
+{
+    return !(*this == other);
+}
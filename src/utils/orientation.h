@@ -0,0 +1,54 @@
+#ifndef ORIENTATION_H
+#define ORIENTATION_H
+
+#include <QSize>
+#include <QTransform>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief 图像方向（二面体群 D4 的元素）
+ *
+ * 显示方向 = 先按需水平镜像原图，再顺时针旋转 rotation 个 90 度。
+ * 旋转/翻转只修改这两个量，像素数据在真正需要时才重排。
+ */
+class Orientation
+{
+public:
+    Orientation() = default;
+    Orientation(int quarterTurns, bool mirrored);
+
+    void rotateLeft();
+    void rotateRight();
+    void rotate180();
+    void flipHorizontal();
+    void flipVertical();
+    void reset();
+
+    bool isIdentity() const;
+    int quarterTurns() const;
+    bool isMirrored() const;
+
+    // 先按本方向、再按 next 变换的合成方向
+    Orientation followedBy(const Orientation &next) const;
+
+    // 原图尺寸经方向变换后的尺寸
+    QSize mapSize(const QSize &imageSize) const;
+
+    // 原图坐标到显示坐标的变换，结果位于 (0, 0) 起的正象限
+    QTransform toTransform(const QSize &imageSize) const;
+
+    // 将方向烘焙进像素数据（单趟、分块、按行带并行）
+    cv::Mat apply(const cv::Mat &image) const;
+
+    // flip + rotate 两趟实现：不支持的像素格式回退到这里，ziv_bench 也用它作对照
+    cv::Mat applyTwoPass(const cv::Mat &image) const;
+
+    bool operator==(const Orientation &other) const;
+    bool operator!=(const Orientation &other) const;
+
+private:
+    int m_quarterTurns = 0;
+    bool m_mirrored = false;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include "perfstats.h"
+#include <QMutexLocker>
+#include <algorithm>
+#include <vector>
+
+PerfStats& PerfStats::instance()
+{
+    static PerfStats instance;
+    return instance;
+}
+
+void PerfStats::record(Metric metric, double milliseconds)
+{
+    if (metric < 0 || metric >= MetricCount) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    History &history = m_histories[metric];
+    history.samples[history.next] = milliseconds;
+    history.next = (history.next + 1) % kHistorySize;
+    history.count = qMin(history.count + 1, kHistorySize);
+    history.last = milliseconds;
+}
+
+PerfStats::Summary PerfStats::summary(Metric metric) const
+{
+    Summary result;
+    if (metric < 0 || metric >= MetricCount) {
+        return result;
+    }
+
+    std::vector<double> samples;
+    {
+        QMutexLocker locker(&m_mutex);
+        const History &history = m_histories[metric];
+        result.count = history.count;
+        result.last = history.last;
+        samples.assign(history.samples.begin(), history.samples.begin() + history.count);
+    }
+
+    if (samples.empty()) {
+        return result;
+    }
+
+    // 只有最近 kHistorySize 个样本，排序开销可以忽略
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) {
+        int index = static_cast<int>(p * (samples.size() - 1) + 0.5);
+        return samples[index];
+    };
+    result.p50 = percentile(0.50);
+    result.p95 = percentile(0.95);
+    return result;
+}
+
+void PerfStats::recordCacheLookup(bool hit)
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_cacheLookups;
+    if (hit) {
+        ++m_cacheHits;
+    }
+}
+
+int PerfStats::cacheHits() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cacheHits;
+}
+
+int PerfStats::cacheLookups() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cacheLookups;
+}
+
+QString PerfStats::metricName(Metric metric)
+{
+    switch (metric) {
+    case FileRead:
+        return QString("读取");
+    case Decode:
+        return QString("解码");
+    case Convert:
+        return QString("转换");
+    case Blend:
+        return QString("混合");
+    case Paint:
+        return QString("绘制");
+    case InputLatency:
+        return QString("输入延迟");
+    default:
+        return QString();
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef PERFSTATS_H
+#define PERFSTATS_H
+
+#include <QString>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <array>
+
+/**
+ * @brief 轻量性能统计
+ *
+ * 记录各阶段最近若干次耗时，用于性能监视面板显示最近值和分位数。
+ * 每次记录只有一次计时和加锁，可以常驻在发布版本中。
+ */
+class PerfStats
+{
+public:
+    enum Metric {
+        FileRead = 0,
+        Decode,
+        Convert,
+        Blend,
+        Paint,
+        InputLatency,
+        MetricCount
+    };
+
+    struct Summary {
+        int count = 0;
+        double last = 0.0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+    };
+
+    static PerfStats& instance();
+
+    void record(Metric metric, double milliseconds);
+    Summary summary(Metric metric) const;
+
+    void recordCacheLookup(bool hit);
+    int cacheHits() const;
+    int cacheLookups() const;
+
+    static QString metricName(Metric metric);
+
+private:
+    PerfStats() = default;
+    PerfStats(const PerfStats&) = delete;
+    PerfStats& operator=(const PerfStats&) = delete;
+
+    static constexpr int kHistorySize = 120;
+
+    struct History {
+        std::array<double, kHistorySize> samples{};
+        int next = 0;
+        int count = 0;
+        double last = 0.0;
+    };
+
+    mutable QMutex m_mutex;
+    std::array<History, MetricCount> m_histories;
+    int m_cacheHits = 0;
+    int m_cacheLookups = 0;
+};
+
+/**
+ * @brief 作用域计时器，析构时把耗时记入 PerfStats
+ */
+class ScopedPerfTimer
+{
+public:
+    explicit ScopedPerfTimer(PerfStats::Metric metric)
+        : m_metric(metric)
+    {
+        m_timer.start();
+    }
+
+    ~ScopedPerfTimer()
+    {
+        PerfStats::instance().record(m_metric, m_timer.nsecsElapsed() / 1e6);
+    }
+
+private:
+    PerfStats::Metric m_metric;
+    QElapsedTimer m_timer;
+};
+
+#endif
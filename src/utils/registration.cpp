@@ -0,0 +1,269 @@
+#include "registration.h"
+#include "utils/matconvert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+constexpr int kCoarsestSize = 256;
+constexpr int kFeatureSize = 1024;
+constexpr int kMaxFeatures = 4000;
+constexpr double kRatioTest = 0.75;
+constexpr int kEccIterations = 50;
+// ECC 只精化到像素数不超过该值的层，更细的层按尺寸比换算，避免全分辨率迭代无法取消
+constexpr qint64 kMaxEccPixels = 2000000;
+constexpr double kEccEpsilon = 1e-5;
+
+cv::Mat toGray(const cv::Mat &image)
+{
+    cv::Mat gray = toDisplayDepth(image);
+    if (gray.channels() == 3) {
+        cv::cvtColor(gray, gray, cv::COLOR_BGR2GRAY);
+    } else if (gray.channels() == 4) {
+        cv::cvtColor(gray, gray, cv::COLOR_BGRA2GRAY);
+    }
+    return gray;
+}
+
+// 金字塔第 0 层为原图，逐层减半直到长边不超过 kCoarsestSize；取消时返回空
+std::vector<cv::Mat> buildPyramid(const cv::Mat &gray, const std::atomic_bool &cancel)
+{
+    std::vector<cv::Mat> pyramid{gray};
+    while (std::max(pyramid.back().cols, pyramid.back().rows) > kCoarsestSize) {
+        if (cancel.load()) {
+            return {};
+        }
+        cv::Mat down;
+        cv::pyrDown(pyramid.back(), down);
+        pyramid.push_back(down);
+    }
+    return pyramid;
+}
+
+// 把 from 层坐标下的变换换算到 to 层。pyrDown 把目标像素 i 精确对应到源像素 2i，
+// 与奇数尺寸的取整无关，因此每层的坐标比恰好是 2，不能用两层的尺寸比
+cv::Matx33d rescale(const cv::Matx33d &transform, int from, int to)
+{
+    const double factor = std::ldexp(1.0, from - to);
+    cv::Matx33d scale(factor, 0, 0, 0, factor, 0, 0, 0, 1);
+    cv::Matx33d inverse(1.0 / factor, 0, 0, 0, 1.0 / factor, 0, 0, 0, 1);
+    return scale * transform * inverse;
+}
+
+int eccMotionType(RegistrationModel model)
+{
+    switch (model) {
+    case RegistrationModel::Translation:
+        return cv::MOTION_TRANSLATION;
+    case RegistrationModel::Affine:
+        return cv::MOTION_AFFINE;
+    case RegistrationModel::Homography:
+    default:
+        return cv::MOTION_HOMOGRAPHY;
+    }
+}
+
+// ORB 特征匹配得到初值；匹配不足时返回 false
+bool estimateFromFeatures(const cv::Mat &reference, const cv::Mat &moving,
+                          RegistrationModel model, cv::Matx33d &transform)
+{
+    cv::Ptr<cv::ORB> orb = cv::ORB::create(kMaxFeatures);
+    std::vector<cv::KeyPoint> keypoints1, keypoints2;
+    cv::Mat descriptors1, descriptors2;
+    orb->detectAndCompute(reference, cv::noArray(), keypoints1, descriptors1);
+    orb->detectAndCompute(moving, cv::noArray(), keypoints2, descriptors2);
+    if (descriptors1.empty() || descriptors2.empty()) {
+        return false;
+    }
+
+    cv::BFMatcher matcher(cv::NORM_HAMMING);
+    std::vector<std::vector<cv::DMatch>> knnMatches;
+    matcher.knnMatch(descriptors1, descriptors2, knnMatches, 2);
+
+    std::vector<cv::Point2f> points1, points2;
+    for (const auto &candidates : knnMatches) {
+        if (candidates.size() == 2 && candidates[0].distance < kRatioTest * candidates[1].distance) {
+            points1.push_back(keypoints1[candidates[0].queryIdx].pt);
+            points2.push_back(keypoints2[candidates[0].trainIdx].pt);
+        }
+    }
+    if (points1.size() < 8) {
+        return false;
+    }
+
+    if (model == RegistrationModel::Translation) {
+        std::vector<float> dx, dy;
+        for (size_t i = 0; i < points1.size(); ++i) {
+            dx.push_back(points2[i].x - points1[i].x);
+            dy.push_back(points2[i].y - points1[i].y);
+        }
+        std::nth_element(dx.begin(), dx.begin() + dx.size() / 2, dx.end());
+        std::nth_element(dy.begin(), dy.begin() + dy.size() / 2, dy.end());
+        transform = cv::Matx33d(1, 0, dx[dx.size() / 2], 0, 1, dy[dy.size() / 2], 0, 0, 1);
+        return true;
+    }
+
+    if (model == RegistrationModel::Affine) {
+        cv::Mat affine = cv::estimateAffine2D(points1, points2, cv::noArray(), cv::RANSAC, 3.0);
+        if (affine.empty()) {
+            return false;
+        }
+        transform = cv::Matx33d(affine.at<double>(0, 0), affine.at<double>(0, 1), affine.at<double>(0, 2),
+                                affine.at<double>(1, 0), affine.at<double>(1, 1), affine.at<double>(1, 2),
+                                0, 0, 1);
+        return true;
+    }
+
+    cv::Mat homography = cv::findHomography(points1, points2, cv::RANSAC, 3.0);
+    if (homography.empty()) {
+        return false;
+    }
+    transform = cv::Matx33d(homography);
+    return true;
+}
+
+} // namespace
+
+RegistrationResult registerImages(const cv::Mat &reference, const cv::Mat &moving,
+                                  RegistrationModel model, const std::atomic_bool &cancel,
+                                  const std::function<void(int)> &progress)
+{
+    RegistrationResult result;
+    auto report = [&progress](int percent) {
+        if (progress) {
+            progress(percent);
+        }
+    };
+    auto cancelled = [&cancel, &result]() {
+        if (cancel.load()) {
+            result.cancelled = true;
+            result.message = QStringLiteral("配准已取消");
+            return true;
+        }
+        return false;
+    };
+
+    if (reference.empty() || moving.empty() || reference.size() != moving.size()) {
+        result.message = QStringLiteral("配准失败：两张图片尺寸不一致");
+        return result;
+    }
+
+    std::vector<cv::Mat> pyramid1 = buildPyramid(toGray(reference), cancel);
+    if (cancelled()) {
+        return result;
+    }
+    std::vector<cv::Mat> pyramid2 = buildPyramid(toGray(moving), cancel);
+    report(10);
+    if (cancelled()) {
+        return result;
+    }
+
+    // 特征匹配在长边约 kFeatureSize 的层上进行
+    int featureLevel = 0;
+    while (featureLevel + 1 < static_cast<int>(pyramid1.size())
+           && std::max(pyramid1[featureLevel].cols, pyramid1[featureLevel].rows) > kFeatureSize) {
+        ++featureLevel;
+    }
+
+    cv::Matx33d transform = cv::Matx33d::eye();
+    bool hasInitial = estimateFromFeatures(pyramid1[featureLevel], pyramid2[featureLevel], model, transform);
+    report(30);
+    if (cancelled()) {
+        return result;
+    }
+
+    // 初值换算到最粗层
+    const int coarsest = static_cast<int>(pyramid1.size()) - 1;
+    if (hasInitial) {
+        transform = rescale(transform, featureLevel, coarsest);
+    }
+
+    // ECC 精化的最细层：像素数不超过 kMaxEccPixels
+    int finest = 0;
+    while (finest < coarsest
+           && static_cast<qint64>(pyramid1[finest].cols) * pyramid1[finest].rows > kMaxEccPixels) {
+        ++finest;
+    }
+
+    const int motionType = eccMotionType(model);
+    const cv::TermCriteria criteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, kEccIterations, kEccEpsilon);
+    bool refined = false;
+
+    for (int level = coarsest; level >= finest; --level) {
+        if (cancelled()) {
+            return result;
+        }
+
+        cv::Mat warp;
+        if (motionType == cv::MOTION_HOMOGRAPHY) {
+            warp = cv::Mat(transform, true);
+        } else {
+            warp = cv::Mat(cv::Matx23d(transform(0, 0), transform(0, 1), transform(0, 2),
+                                       transform(1, 0), transform(1, 1), transform(1, 2)), true);
+        }
+        warp.convertTo(warp, CV_32F);
+
+        try {
+            result.correlation = cv::findTransformECC(pyramid1[level], pyramid2[level], warp,
+                                                      motionType, criteria, cv::noArray(), 5);
+            warp.convertTo(warp, CV_64F);
+            if (motionType == cv::MOTION_HOMOGRAPHY) {
+                transform = cv::Matx33d(warp);
+            } else {
+                transform = cv::Matx33d(warp.at<double>(0, 0), warp.at<double>(0, 1), warp.at<double>(0, 2),
+                                        warp.at<double>(1, 0), warp.at<double>(1, 1), warp.at<double>(1, 2),
+                                        0, 0, 1);
+            }
+            refined = true;
+        } catch (const cv::Exception &) {
+            // 本层不收敛时沿用上一层的估计
+        }
+
+        if (level > finest) {
+            transform = rescale(transform, level, level - 1);
+        }
+        report(30 + 70 * (coarsest - level + 1) / (coarsest - finest + 1));
+    }
+
+    if (cancelled()) {
+        return result;
+    }
+    transform = rescale(transform, finest, 0);
+
+    if (!refined && !hasInitial) {
+        result.message = QStringLiteral("配准失败：未能找到可靠的对应关系");
+        return result;
+    }
+
+    result.success = true;
+    result.transform = transform;
+    result.message = refined
+        ? QStringLiteral("配准完成，相关系数 %1").arg(result.correlation, 0, 'f', 3)
+        : QStringLiteral("配准完成（仅特征匹配）");
+    return result;
+}
+
+cv::Mat registeredRegion(const cv::Mat &image, const cv::Matx33d &transform, const cv::Rect &roi, int level)
+{
+    // 区域像素 -> 第 level 级像素 -> 全分辨率画布（按像素中心对齐），
+    // 经配准变换映射到 image 后再换算回第 level 级，只对需要的区域重采样
+    const double offset = 0.5 * level - 0.5;
+    cv::Matx33d levelToFull(level, 0, offset, 0, level, offset, 0, 0, 1);
+    cv::Matx33d fullToLevel = levelToFull.inv();
+    cv::Matx33d regionToLevel(1, 0, roi.x, 0, 1, roi.y, 0, 0, 1);
+    cv::Matx33d dstToSrc = fullToLevel * transform * levelToFull * regionToLevel;
+
+    cv::Mat warped;
+    const int flags = cv::INTER_LINEAR | cv::WARP_INVERSE_MAP;
+    bool affine = dstToSrc(2, 0) == 0.0 && dstToSrc(2, 1) == 0.0 && dstToSrc(2, 2) == 1.0;
+    if (affine) {
+        cv::Matx23d matrix(dstToSrc(0, 0), dstToSrc(0, 1), dstToSrc(0, 2),
+                           dstToSrc(1, 0), dstToSrc(1, 1), dstToSrc(1, 2));
+        cv::warpAffine(image, warped, matrix, roi.size(), flags, cv::BORDER_CONSTANT, cv::Scalar::all(0));
+    } else {
+        cv::warpPerspective(image, warped, dstToSrc, roi.size(), flags, cv::BORDER_CONSTANT, cv::Scalar::all(0));
+    }
+    return warped;
+}
@@ -0,0 +1,40 @@
+#ifndef REGISTRATION_H
+#define REGISTRATION_H
+
+#include <QString>
+#include <atomic>
+#include <functional>
+#include <opencv2/opencv.hpp>
+
+// 配准使用的几何模型
+enum class RegistrationModel {
+    Translation = 0,
+    Affine,
+    Homography
+};
+
+struct RegistrationResult {
+    bool success = false;
+    bool cancelled = false;
+    // 参考图坐标 -> 待配准图坐标（采样时的逆映射）
+    cv::Matx33d transform = cv::Matx33d::eye();
+    double correlation = 0.0;
+    QString message;
+};
+
+/**
+ * @brief 估计 moving 相对 reference 的几何变换
+ *
+ * 先在约 1024 像素的金字塔层用 ORB + RANSAC 得到初值，再自粗到细逐层用 ECC 精化，
+ * 精化只进行到约 2 MP 的层，结果按层间尺寸比换算回原图坐标。
+ * 可在任意线程调用；cancel 置位后在下一步骤前返回，progress 回调参数为 0..100。
+ */
+RegistrationResult registerImages(const cv::Mat &reference, const cv::Mat &moving,
+                                  RegistrationModel model, const std::atomic_bool &cancel,
+                                  const std::function<void(int)> &progress);
+
+// 按配准变换（全分辨率下参考图坐标 -> image 坐标）只重采样 roi 对应的区域。
+// image 与 roi 都以第 level 级降采样像素计，超出 image 的部分填 0
+cv::Mat registeredRegion(const cv::Mat &image, const cv::Matx33d &transform, const cv::Rect &roi, int level);
+
+#endif